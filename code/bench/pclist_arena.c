@@ -0,0 +1,103 @@
+/*---------------------------------------------------------------------*
+ * pclist_arena.c - benchmark of deque updates with plain malloc and   *
+ *                  with generations of versions kept in arenas        *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pclist.h"
+#include "pclistarena.h"
+
+/**
+ * Returns current value of a monotonic clock in seconds.
+ */
+static double now (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Performs one generation of updates derived from the base deque.
+ */
+static long generation (PCList * base, int ops)
+{
+  PCList * d = base;
+  long sum = 0;
+  for (int i = 0; i < ops; i++)
+  {
+    VAL_TYPE x;
+    switch (i & 7)
+    {
+      case 0: case 1: case 2: d = inject(d, i); break;
+      case 3: case 4:         d = push(d, i); break;
+      case 5:                 d = pop(d, &x); sum += x; break;
+      case 6:                 d = eject(d, &x); sum += x; break;
+      default:                d = catenate(d, base); break;
+    }
+  }
+  return sum;
+}
+
+/**
+ * Runs given number of generations, each one either in its own arena or with malloc.
+ */
+static void run (int arena, int gens, int ops, int size)
+{
+  PCList * base = makeList(0);
+  for (int i = 1; i < size; i++) base = inject(base, i);
+  long sum = 0;
+  double start = now();
+  for (int g = 0; g < gens; g++)
+  {
+    PCListArena * a = NULL;
+    if (arena) useArena(a = makeArena(0));
+    sum += generation(base, ops);
+    if (arena)
+    {
+      useArena(NULL);
+      releaseArena(a);
+    }
+  }
+  double sec = now() - start;
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  printf("%s %d %d %.3f %.0f %ld %ld\n", arena ? "arena" : "malloc", gens, ops, sec,
+         (double)gens * ops / sec, ru.ru_maxrss, sum & 1);
+}
+
+int main (int argc, char * argv [])
+{
+  int gens = argc > 1 ? atoi(argv[1]) : 50;
+  int ops = argc > 2 ? atoi(argv[2]) : 20000;
+  int size = argc > 3 ? atoi(argv[3]) : 1000;
+  printf("mode generations ops_per_generation seconds ops_per_sec peak_rss_kb check\n");
+  fflush(stdout);
+  //every mode runs in its own process, so that peak RSS is not shared
+  for (int arena = 0; arena <= 1; arena++)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      run(arena, gens, ops, size);
+      return 0;
+    }
+    waitpid(pid, NULL, 0);
+  }
+  return 0;
+}
@@ -0,0 +1,122 @@
+/*---------------------------------------------------------------------*
+ * pclist_sweep.c - benchmark of deque operations for one setting of   *
+ *                  buffer capacities (PCLIST_BUF_MAX and              *
+ *                  PCLIST_SUFFIX_MAX), run by "make sweep"            *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pclist.h"
+#include "pclistarena.h"
+
+/**
+ * Returns current value of a monotonic clock in seconds.
+ */
+static double now (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Returns the nesting depth of a deque.
+ */
+static int depth (PCList * d)
+{
+  if (!d) return 0;
+  int l = depth(d->l), r = depth(d->r);
+  return 1 + (l > r ? l : r);
+}
+
+/**
+ * Prints one line of results of a workload run in given arena.
+ */
+static void report (const char * name, PCListArena * a, long ops, double sec, PCList * d)
+{
+  printf("%d %d %s %ld %.1f %.1f %d\n", PCLIST_BUF_MAX, PCLIST_SUFFIX_MAX, name, ops,
+         sec * 1e9 / ops, (double)a->bytes / ops, depth(d));
+}
+
+int main (int argc, char * argv [])
+{
+  long n = argc > 1 ? atol(argv[1]) : 1000000;
+  long sum = 0;
+  VAL_TYPE x;
+  unsigned int seed = 12345;
+  //queue: n injects followed by n pops
+  PCListArena * a = makeArena(0);
+  useArena(a);
+  double start = now();
+  PCList * d = NULL;
+  for (long i = 0; i < n; i++) d = inject(d, i);
+  PCList * full = d;
+  for (long i = 0; i < n; i++)
+  {
+    d = pop(d, &x);
+    sum += x;
+  }
+  report("queue", a, 2 * n, now() - start, full);
+  releaseArena(a);
+  //deque: random ends on a deque of steady size
+  useArena(a = makeArena(0));
+  d = NULL;
+  for (long i = 0; i < 1000; i++) d = inject(d, i);
+  start = now();
+  for (long i = 0; i < n; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    switch ((seed >> 16) & 3)
+    {
+      case 0: d = push(d, i); d = eject(d, &x); break;
+      case 1: d = inject(d, i); d = pop(d, &x); break;
+      case 2: d = push(d, i); d = pop(d, &x); break;
+      default: d = inject(d, i); d = eject(d, &x); break;
+    }
+    sum += x;
+  }
+  report("deque", a, 2 * n, now() - start, d);
+  releaseArena(a);
+  //catenation of small deques followed by draining from the front
+  useArena(a = makeArena(0));
+  PCList * piece = NULL;
+  for (long i = 0; i < 20; i++) piece = inject(piece, i);
+  start = now();
+  d = NULL;
+  for (long i = 0; i < n / 20; i++) d = catenate(d, piece);
+  full = d;
+  for (long i = 0; i < n; i++)
+  {
+    d = pop(d, &x);
+    sum += x;
+  }
+  report("catenate", a, n / 20 + n, now() - start, full);
+  releaseArena(a);
+  //random access
+  useArena(a = makeArena(0));
+  d = NULL;
+  for (long i = 0; i < n; i++) d = push(d, i);
+  //only allocations of the lookups are counted
+  a->bytes = 0;
+  start = now();
+  for (long i = 0; i < n; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    sum += nth(d, seed % n);
+  }
+  report("nth", a, n, now() - start, d);
+  useArena(NULL);
+  releaseArena(a);
+  (void)sum;
+  return 0;
+}
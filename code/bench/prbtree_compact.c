@@ -0,0 +1,88 @@
+/*---------------------------------------------------------------------*
+ * prbtree_compact.c - benchmark of red-black trees with pointer       *
+ *                     links and with compact nodes linked by indices  *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "prbctree.h"
+#include "prbtree.h"
+
+/**
+ * Returns current value of a monotonic clock in seconds.
+ */
+static double now (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Inserts n random keys (keeping all versions alive when keep is set)
+ * and then looks up n random keys in the last version.
+ */
+static void run (int compact, long n, int keep)
+{
+  PRBTree * t = makeTree();
+  PRBCTree * c = makeCompactTree();
+  long found = 0;
+  srand(1);
+  double start = now();
+  for (long i = 0; i < n; i++)
+  {
+    VAL_TYPE x = rand();
+    if (compact)
+    {
+      PRBCTree * cnew = compactInsert(c, x);
+      if (!keep) releaseCompactTree(c);
+      c = cnew;
+    }
+    else
+    {
+      PRBTree * tnew = insert(t, x);
+      if (!keep) releaseTree(t);
+      t = tnew;
+    }
+  }
+  double mid = now();
+  for (long i = 0; i < n; i++) found += compact ? compactFind(c, rand()) : find(t, rand());
+  double end = now();
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  printf("%s %ld %s %.3f %.3f %ld %ld\n", compact ? "compact" : "pointer", n, keep ? "all" : "last",
+         mid - start, end - mid, ru.ru_maxrss, found & 1);
+}
+
+int main (int argc, char * argv [])
+{
+  long n = argc > 1 ? atol(argv[1]) : 1000000;
+  printf("nodes keys versions insert_seconds find_seconds peak_rss_kb check\n");
+  fflush(stdout);
+  //every mode runs in its own process, so that peak RSS is not shared
+  for (int keep = 0; keep <= 1; keep++)
+    for (int compact = 0; compact <= 1; compact++)
+    {
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+        run(compact, n, keep);
+        return 0;
+      }
+      waitpid(pid, NULL, 0);
+    }
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*---------------------------------------------------------------------*
+ * prbtree_fat.c - benchmark of red-black trees keeping all versions   *
+ *                 by path copying and by node copying (fat nodes)     *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "prbtree.h"
+#include "prbtreefat.h"
+
+/**
+ * Returns current value of a monotonic clock in seconds.
+ */
+static double now (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Makes n random updates (insertions and every third one a deletion) of the latest
+ * version, keeping all versions alive, and then looks up n random keys
+ * in random versions.
+ */
+static void run (int fat, long n)
+{
+  PRBTree ** hist = fat ? NULL : (PRBTree **)malloc((n + 1) * sizeof(PRBTree *));
+  PRBFatTree * f = makeFatTree();
+  long found = 0;
+  if (!fat) hist[0] = makeTree();
+  srand(1);
+  double start = now();
+  for (long i = 0; i < n; i++)
+  {
+    VAL_TYPE x = rand() % (2 * n);
+    int del = i % 3 == 2;
+    if (fat) del ? fatErase(f, x) : fatInsert(f, x);
+    else hist[i + 1] = del ? erase(hist[i], x) : insert(hist[i], x);
+  }
+  double mid = now();
+  for (long i = 0; i < n; i++)
+  {
+    long v = rand() % (n + 1);
+    VAL_TYPE x = rand() % (2 * n);
+    found += fat ? fatFind(f, v, x) : find(hist[v], x);
+  }
+  double end = now();
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  printf("%s %ld %.3f %.3f %ld %ld\n", fat ? "node-copying" : "path-copying", n,
+         mid - start, end - mid, ru.ru_maxrss, found & 1);
+}
+
+int main (int argc, char * argv [])
+{
+  long n = argc > 1 ? atol(argv[1]) : 1000000;
+  printf("method updates update_seconds find_seconds peak_rss_kb check\n");
+  fflush(stdout);
+  //every mode runs in its own process, so that peak RSS is not shared
+  for (int fat = 0; fat <= 1; fat++)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      run(fat, n);
+      return 0;
+    }
+    waitpid(pid, NULL, 0);
+  }
+  return 0;
+}
@@ -0,0 +1,74 @@
+/*---------------------------------------------------------------------*
+ * prbtree_freeze.c - benchmark of lookups in a red-black tree version *
+ *                    and in its frozen snapshot                       *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "prbtree.h"
+#include "prbtreefreeze.h"
+
+/**
+ * Returns current value of a monotonic clock in seconds.
+ */
+static double now (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main (int argc, char * argv [])
+{
+  long n = argc > 1 ? atol(argv[1]) : 4000000;
+  long q = argc > 2 ? atol(argv[2]) : 4000000;
+  //random insertions scatter the nodes over the heap like a long history does
+  PRBTree * t = makeTree();
+  srand(1);
+  for (long i = 0; i < n; i++)
+  {
+    PRBTree * tnew = insert(t, rand());
+    releaseTree(t);
+    t = tnew;
+  }
+  VAL_TYPE * keys = (VAL_TYPE *)malloc(q * sizeof(VAL_TYPE));
+  char * found = (char *)malloc(q);
+  for (long i = 0; i < q; i++) keys[i] = rand();
+  printf("mode keys lookups seconds ns_per_lookup found\n");
+  double start = now();
+  long cnt = 0;
+  for (long i = 0; i < q; i++) cnt += find(t, keys[i]);
+  double sec = now() - start;
+  printf("tree %ld %ld %.3f %.1f %ld\n", n, q, sec, sec * 1e9 / q, cnt);
+  start = now();
+  PRBTreeFrozen * f = prbtreeFreeze(t);
+  if (!f) return 1;
+  sec = now() - start;
+  printf("freeze %ld 0 %.3f 0 0\n", n, sec);
+  start = now();
+  cnt = 0;
+  for (long i = 0; i < q; i++) cnt += frozenFind(f, keys[i]);
+  sec = now() - start;
+  printf("frozen %ld %ld %.3f %.1f %ld\n", n, q, sec, sec * 1e9 / q, cnt);
+  start = now();
+  frozenFindBatch(f, keys, q, found);
+  sec = now() - start;
+  cnt = 0;
+  for (long i = 0; i < q; i++) cnt += found[i];
+  printf("frozen_batch %ld %ld %.3f %.1f %ld\n", n, q, sec, sec * 1e9 / q, cnt);
+  releaseFrozen(f);
+  releaseTree(t);
+  free(keys);
+  free(found);
+  return 0;
+}
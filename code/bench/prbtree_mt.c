@@ -0,0 +1,104 @@
+/*---------------------------------------------------------------------*
+ * prbtree_mt.c - scaling benchmark of concurrent red-black tree       *
+ *                updates (every thread derives its own versions)      *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "prbtree.h"
+
+/* Work description of one writer thread */
+typedef struct
+{
+  PRBTree *    base;
+  int          ops;
+  int          keys;
+  unsigned int seed;
+} Writer;
+
+/**
+ * Returns current value of a monotonic clock in seconds.
+ */
+static double now (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Simple xorshift generator, so that the threads do not share rand() state.
+ */
+static unsigned int nextRand (unsigned int * s)
+{
+  *s ^= *s << 13;
+  *s ^= *s >> 17;
+  *s ^= *s << 5;
+  return *s;
+}
+
+/**
+ * Body of a writer thread -- derives a chain of versions from the shared base tree.
+ */
+static void * writer (void * arg)
+{
+  Writer * w = (Writer *)arg;
+  PRBTree * t = w->base;
+  for (int i = 0; i < w->ops; i++)
+  {
+    VAL_TYPE x = nextRand(&w->seed) % (unsigned int)(2 * w->keys);
+    if (i & 1) t = erase(t, x);
+    else t = insert(t, x);
+  }
+  return t;
+}
+
+/**
+ * Runs given number of writers over the same base tree, returns elapsed seconds.
+ */
+static double run (PRBTree * base, int threads, int ops, int keys)
+{
+  pthread_t tid[threads];
+  Writer w[threads];
+  double start = now();
+  for (int i = 0; i < threads; i++)
+  {
+    w[i].base = base;
+    w[i].ops = ops;
+    w[i].keys = keys;
+    w[i].seed = 2463534242u + 7919u * i;
+    pthread_create(&tid[i], NULL, writer, &w[i]);
+  }
+  for (int i = 0; i < threads; i++) pthread_join(tid[i], NULL);
+  return now() - start;
+}
+
+int main (int argc, char * argv [])
+{
+  int maxThreads = argc > 1 ? atoi(argv[1]) : 8;
+  int ops = argc > 2 ? atoi(argv[2]) : 100000;
+  int keys = argc > 3 ? atoi(argv[3]) : 100000;
+  PRBTree * base = makeTree();
+  for (int i = 0; i < keys; i++) base = insert(base, 2 * i);
+  printf("threads ops_per_thread total_ops seconds ops_per_sec speedup\n");
+  double single = 0;
+  for (int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    double sec = run(base, threads, ops, keys);
+    double rate = (double)threads * ops / sec;
+    if (threads == 1) single = rate;
+    printf("%d %d %d %.3f %.0f %.2f\n", threads, ops, threads * ops, sec, rate, rate / single);
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+/*---------------------------------------------------------------------*
+ * prbtree_release.c - stress benchmark of red-black tree updates      *
+ *                     with a sliding window of live versions          *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "prbtree.h"
+
+/**
+ * Returns current resident set size of the process in kB.
+ */
+static long rss (void)
+{
+  long pages = 0, resident = 0;
+  FILE * f = fopen("/proc/self/statm", "r");
+  if (!f) return -1;
+  if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = -1;
+  fclose(f);
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/**
+ * Derives a chain of versions. Only the last window versions stay alive
+ * when release is set, otherwise no version is ever released.
+ */
+static void run (int release, long ops, int window, int keys)
+{
+  PRBTree ** live = (PRBTree **)calloc(window, sizeof(PRBTree *));
+  PRBTree * t = makeTree();
+  for (int i = 0; i < keys; i++)
+  {
+    PRBTree * tnew = insert(t, 2 * i);
+    if (release) releaseTree(t);
+    t = tnew;
+  }
+  unsigned int seed = 2463534242u;
+  clock_t start = clock();
+  for (long i = 1; i <= ops; i++)
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    VAL_TYPE x = seed % (unsigned int)(2 * keys);
+    PRBTree * tnew = (i & 1) ? erase(t, x) : insert(t, x);
+    //the oldest version of the window falls out
+    int slot = i % window;
+    if (release && live[slot]) releaseTree(live[slot]);
+    live[slot] = t = tnew;
+    if (i % (ops / 10) == 0)
+      printf("%s %ld %d %ld %.3f\n", release ? "release" : "keep", i, window, rss(),
+             (double)(clock() - start) / CLOCKS_PER_SEC);
+  }
+  fflush(stdout);
+}
+
+int main (int argc, char * argv [])
+{
+  long ops = argc > 1 ? atol(argv[1]) : 1000000;
+  int window = argc > 2 ? atoi(argv[2]) : 1000;
+  int keys = argc > 3 ? atoi(argv[3]) : 100000;
+  printf("mode ops live_versions rss_kb seconds\n");
+  fflush(stdout);
+  //every mode runs in its own process, so that RSS is not shared
+  for (int release = 1; release >= 0; release--)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      run(release, ops, window, keys);
+      return 0;
+    }
+    waitpid(pid, NULL, 0);
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+/*---------------------------------------------------------------------*
+ * psnapshot.c - benchmark of restarting from a snapshot file          *
+ *               compared with replaying the updates                   *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pclist.h"
+#include "prbtree.h"
+#include "psnapshot.h"
+
+/* Number of versions of each structure kept in the snapshot */
+#define VERSIONS 16
+
+/**
+ * Returns current value of a monotonic clock in seconds.
+ */
+static double now (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Replays n random updates of a tree and of a deque, every (n / VERSIONS)-th
+ * versions are kept in given arrays.
+ */
+static void replay (long n, PRBTree ** trees, PCList ** lists)
+{
+  PRBTree * t = makeTree();
+  PCList * d = NULL;
+  srand(1);
+  for (long i = 0; i < n; i++)
+  {
+    PRBTree * tnew = insert(t, rand());
+    d = (i & 1) ? push(d, i) : inject(d, i);
+    if ((i + 1) % (n / VERSIONS) == 0 && (i + 1) / (n / VERSIONS) <= VERSIONS)
+    {
+      trees[(i + 1) / (n / VERSIONS) - 1] = t;
+      lists[(i + 1) / (n / VERSIONS) - 1] = d;
+    }
+    else releaseTree(t);
+    t = tnew;
+  }
+  releaseTree(t);
+}
+
+int main (int argc, char * argv [])
+{
+  long n = argc > 1 ? atol(argv[1]) : 2000000;
+  long q = argc > 2 ? atol(argv[2]) : 1000000;
+  const char * path = argc > 3 ? argv[3] : "bench/psnapshot.bin";
+  PRBTree * trees [VERSIONS];
+  PCList * lists [VERSIONS];
+  printf("step seconds detail\n");
+  double start = now();
+  replay(n, trees, lists);
+  printf("replay %.3f %ld_updates\n", now() - start, n);
+  start = now();
+  if (!saveSnapshot(path, trees, VERSIONS, lists, VERSIONS)) return 1;
+  printf("save %.3f -\n", now() - start);
+  start = now();
+  PSnapshot * s = openSnapshot(path);
+  if (!s) return 1;
+  long found = snapshotFind(s, VERSIONS - 1, 0);
+  printf("open %.6f %zu_bytes\n", now() - start, s->size);
+  start = now();
+  for (long i = 0; i < q; i++) found += snapshotFind(s, i % VERSIONS, rand());
+  printf("find_mapped %.3f %.0f_ns_per_lookup\n", now() - start, (now() - start) * 1e9 / q);
+  start = now();
+  for (long i = 0; i < q; i++) found += find(trees[i % VERSIONS], rand());
+  printf("find_memory %.3f %.0f_ns_per_lookup\n", now() - start, (now() - start) * 1e9 / q);
+  start = now();
+  for (long i = 0; i < q; i++) found += snapshotNth(s, i % VERSIONS, i % snapshotListLength(s, i % VERSIONS));
+  printf("nth_mapped %.3f %.0f_ns_per_lookup\n", now() - start, (now() - start) * 1e9 / q);
+  closeSnapshot(s);
+  remove(path);
+  for (int i = 0; i < VERSIONS; i++) releaseTree(trees[i]);
+  return found < 0;
+}
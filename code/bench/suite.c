@@ -0,0 +1,273 @@
+/*---------------------------------------------------------------------*
+ * suite.c - microbenchmark suite of both structures, run by           *
+ *           "make bench", prints one CSV line per case                *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pclist.h"
+#include "prbtree.h"
+
+/* The tree cases run on B+-trees when built with -DPRBTREE_BTREE (see pbtree.h) */
+#ifdef PRBTREE_BTREE
+#define TREE_NAME  "pbtree"
+#define FIRST_CASE (5 * 3) /* the deque cases do not depend on the trees */
+#else
+#define TREE_NAME  "prbtree"
+#define FIRST_CASE 0
+#endif
+
+/* Patterns of keys (values) and of versions the operations are applied to */
+#define SEQ  0
+#define RAND 1
+#define ADV  2
+
+static const char * pattern_names [] = {"sequential", "random", "adversarial"};
+
+/* Allocations are counted by wrapping malloc at link time (-Wl,--wrap=malloc) */
+void * __real_malloc (size_t size);
+static long allocs = 0;
+
+void * __wrap_malloc (size_t size)
+{
+  allocs++;
+  return __real_malloc(size);
+}
+
+/* Latencies of the operations of the current case (in ns) */
+static long * lat;
+static long   nlat;
+static struct timespec t0;
+
+/**
+ * Starts timing of one operation.
+ */
+static void tick (void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+}
+
+/**
+ * Ends timing of one operation.
+ */
+static void tock (void)
+{
+  struct timespec t1;
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  lat[nlat++] = (t1.tv_sec - t0.tv_sec) * 1000000000L + (t1.tv_nsec - t0.tv_nsec);
+}
+
+/**
+ * Returns the next value of a xorshift generator.
+ */
+static unsigned int rnd (void)
+{
+  static unsigned int seed = 2463534242u;
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static int cmpLong (const void * a, const void * b)
+{
+  long x = *(const long *)a, y = *(const long *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Prints the results of a finished case as one CSV line.
+ */
+static void report (const char * structure, const char * op, int pattern, long size, long alloc_count)
+{
+  long total = 0;
+  for (long i = 0; i < nlat; i++) total += lat[i];
+  qsort(lat, nlat, sizeof(long), cmpLong);
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  printf("%s,%s,%s,%ld,%ld,%.0f,%ld,%ld,%ld,%.2f,%ld\n", structure, op, pattern_names[pattern], size, nlat,
+         total ? nlat * 1e9 / total : 0.0, lat[nlat / 2], lat[nlat * 99 / 100], lat[nlat * 999 / 1000],
+         (double)alloc_count / nlat, ru.ru_maxrss);
+  fflush(stdout);
+}
+
+/**
+ * Builds a deque of values 0..n-1.
+ */
+static PCList * buildList (long n)
+{
+  VAL_TYPE * a = (VAL_TYPE *)malloc(n * sizeof(VAL_TYPE));
+  for (long i = 0; i < n; i++) a[i] = i;
+  PCList * d = pclistFromArray(a, n);
+  free(a);
+  return d;
+}
+
+/**
+ * Runs n operations of given kind on a deque. Sequential pattern applies every
+ * operation to the latest version, random one to a random version of the history
+ * and adversarial one always to the same version, which is just at the edge of
+ * restructuring (the amortized bounds do not hold for it).
+ */
+static void benchList (const char * op, int pattern, long n)
+{
+  PCList ** hist = (PCList **)malloc((n + 1) * sizeof(PCList *));
+  PCList * piece = buildList(16);
+  PCList * d = NULL;
+  VAL_TYPE x;
+  int kind = op[0] == 'c' ? 4 : (op[0] == 'i') ? 2 : (op[0] == 'e') ? 3 : (op[1] == 'u') ? 0 : 1;
+  if (kind != 0 && kind != 2) d = buildList(n);
+  if (pattern == ADV)
+  {
+    //walk the deque to the edge of restructuring of its prefix (suffix)
+    if (!d) d = buildList(n);
+    for (int i = 0; i < 64 && !d->suffix_only; i++)
+    {
+      if (kind == 0 && d->p->size == PCLIST_BUF_MAX) break;
+      if (kind == 1 && d->p->size == 3 && (d->l || d->r)) break;
+      if (kind == 2 && d->s->size == PCLIST_BUF_MAX) break;
+      if (kind == 3 && d->s->size == 3 && (d->l || d->r)) break;
+      if (kind == 4) break;
+      if (kind == 0) d = push(d, i);
+      else if (kind == 1) d = pop(d, &x);
+      else if (kind == 2) d = inject(d, i);
+      else d = eject(d, &x);
+    }
+  }
+  long hcnt = 0;
+  hist[hcnt++] = d;
+  long alloc_start = allocs;
+  for (long i = 0; i < n; i++)
+  {
+    PCList * v = pattern == SEQ ? d : pattern == RAND ? hist[rnd() % hcnt] : hist[0];
+    VAL_TYPE val = pattern == RAND ? (VAL_TYPE)(rnd() & 0x7fffffff) : (VAL_TYPE)i;
+    if (!v && (kind == 1 || kind == 3)) v = d = buildList(n);
+    tick();
+    switch (kind)
+    {
+      case 0: d = push(v, val); break;
+      case 1: d = pop(v, &x); break;
+      case 2: d = inject(v, val); break;
+      case 3: d = eject(v, &x); break;
+      default:
+        //adversarial catenation alternates both ends
+        if (pattern == ADV) d = (i & 1) ? catenate(piece, v) : catenate(v, piece);
+        else d = catenate(v, pattern == RAND ? hist[rnd() % hcnt] : piece);
+        break;
+    }
+    tock();
+    if (pattern == RAND && d) hist[hcnt++] = d;
+    if (pattern == ADV && kind == 4) hist[0] = d;
+  }
+  report("pclist", op, pattern, n, allocs - alloc_start);
+}
+
+/**
+ * Returns the value stored at the root of a tree -- with B+-trees it is the least one
+ * under the second child of the root (a value stored in the leaves, unlike the separator).
+ */
+static VAL_TYPE rootKey (PRBTree * t)
+{
+#ifdef PRBTREE_BTREE
+  PBTreeNode * x = t->root;
+  if (!x) return 0;
+  if (!x->leaf) x = x->child[1];
+  while (!x->leaf) x = x->child[0];
+  return x->keys[0];
+#else
+  return isNull(t->root) ? 0 : t->root->content;
+#endif
+}
+
+/**
+ * Runs n operations of given kind on a tree. Sequential pattern uses
+ * ascending keys, random one uniformly random keys and adversarial one keys
+ * in alternating order from both ends for insert, the key of the root for erase
+ * and keys missing from the tree (deepest unsuccessful searches) for find.
+ */
+static void benchTree (const char * op, int pattern, long n)
+{
+  int kind = op[0] == 'i' ? 0 : op[0] == 'e' ? 1 : 2;
+  PRBTree * t = makeTree();
+  if (kind)
+  {
+    for (long i = 0; i < n; i++)
+    {
+      PRBTree * tnew = insert(t, 2 * i);
+      releaseTree(t);
+      t = tnew;
+    }
+  }
+  long alloc_start = allocs;
+  long found = 0;
+  for (long i = 0; i < n; i++)
+  {
+    VAL_TYPE key;
+    if (pattern == SEQ) key = 2 * i;
+    else if (pattern == RAND) key = 2 * (rnd() % n);
+    else if (kind == 0) key = (i & 1) ? 2 * (n - 1 - i / 2) : 2 * (i / 2);
+    else if (kind == 1) key = rootKey(t);
+    else key = 2 * (rnd() % n) + 1;
+    if (kind == 2)
+    {
+      tick();
+      found += find(t, key);
+      tock();
+      continue;
+    }
+    tick();
+    PRBTree * tnew = kind ? erase(t, key) : insert(t, key);
+    tock();
+    releaseTree(t);
+    t = tnew;
+  }
+  report(TREE_NAME, op, pattern, n, allocs - alloc_start);
+  if (found < 0) printf("%ld\n", found);
+}
+
+int main (int argc, char * argv [])
+{
+  static const char * list_ops [] = {"push", "pop", "inject", "eject", "catenate"};
+  static const char * tree_ops [] = {"insert", "erase", "find"};
+  long sizes [16] = {1000, 100000, 1000000};
+  int nsizes = 3;
+  if (argc > 1)
+  {
+    nsizes = 0;
+    for (int i = 1; i < argc && nsizes < 16; i++) sizes[nsizes++] = atol(argv[i]);
+  }
+  printf("structure,op,pattern,size,ops,ops_per_sec,p50_ns,p99_ns,p999_ns,allocs_per_op,peak_rss_kb\n");
+  fflush(stdout);
+  //every case runs in its own process, so that peak RSS is not shared
+  for (int s = 0; s < nsizes; s++)
+  {
+    for (int c = FIRST_CASE; c < 8 * 3; c++)
+    {
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+        lat = (long *)malloc(sizes[s] * sizeof(long));
+        nlat = 0;
+        if (c < 5 * 3) benchList(list_ops[c / 3], c % 3, sizes[s]);
+        else benchTree(tree_ops[c / 3 - 5], c % 3, sizes[s]);
+        return 0;
+      }
+      waitpid(pid, NULL, 0);
+    }
+  }
+  return 0;
+}
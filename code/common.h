@@ -21,6 +21,10 @@ typedef int VAL_TYPE;
 typedef struct PCListElem_struct PCListElem;
 typedef struct PCListBuffer_struct PCListBuffer;
 typedef struct PCList_struct PCList;
+typedef struct PCListArena_struct PCListArena;
+typedef union PCListSlot_union PCListSlot;
+typedef struct PCListIter_struct PCListIter;
+typedef struct PCListTransient_struct PCListTransient;
 
 /* Declarations of print procedures for persistent deques */
 void printElem   (PCListElem * x);
@@ -30,7 +34,33 @@ void printDeque  (PCList       * d);
 
 /* Type definitions for persistent red-black trees */
 typedef struct PRBTreeNode_struct PRBTreeNode;
+#ifdef PRBTREE_BTREE
+typedef struct PBTree_struct PRBTree; /* B+-trees stand for them (see pbtree.h) */
+#else
 typedef struct PRBTree_struct PRBTree;
+#endif
+typedef struct PRBTreeIter_struct PRBTreeIter;
+typedef struct PRBTreePool_struct PRBTreePool;
+typedef struct PRBTreeTask_struct PRBTreeTask;
+typedef struct PRBTreeFrozen_struct PRBTreeFrozen;
+
+/* Type definitions for partially persistent red-black trees made by node copying */
+typedef struct PRBFatNode_struct PRBFatNode;
+typedef struct PRBFatTree_struct PRBFatTree;
+
+/* Type definitions for compact persistent red-black trees */
+typedef struct PRBCNode_struct PRBCNode;
+typedef struct PRBCTree_struct PRBCTree;
+
+/* Type definitions for persistent B+-trees */
+typedef struct PBTreeNode_struct PBTreeNode;
+typedef struct PBTree_struct PBTree;
+
+/* Type definitions for registries of versions */
+typedef struct PVersionReg_struct PVersionReg;
+
+/* Type definitions for on-disk snapshots */
+typedef struct PSnapshot_struct PSnapshot;
 
 /* Colour definitions for persistent red-black trees */
 #define RED   0
@@ -0,0 +1,13 @@
+/*-------------------------------------------------------------*
+ * intmap.c - implementation of persistent map of integer keys *
+ *            to real values (a specialization of prbmap.h)    *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#define PRBMAP_IMPL
+#include "intmap.h"
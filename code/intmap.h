@@ -0,0 +1,20 @@
+/*-------------------------------------------------------------*
+ * intmap.h - persistent map of integer keys to real values    *
+ *            (a specialization of prbmap.h)                   *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __INTMAP_H__
+#define __INTMAP_H__
+
+#define PRBMAP_NAME  IntMap
+#define PRBMAP_KEY   int
+#define PRBMAP_VALUE double
+#include "prbmap.h"
+
+#endif /*__INTMAP_H__*/
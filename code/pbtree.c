@@ -0,0 +1,380 @@
+/*-------------------------------------------------------------*
+ * pbtree.c - implementation of confluently persistent         *
+ *            B+-trees with SIMD search inside the nodes       *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * An update copies the nodes on the path from the root to a leaf (about
+ * log_B n nodes of a few cache lines instead of log_2 n small ones), the new
+ * nodes share all other children with the old version. Every node knows the
+ * number of nodes and versions pointing to it and it is freed with the last one.
+ * Keys of a node are compared with the searched value by 8 (AVX2) or 4 (SSE2)
+ * at once, the position is the number of smaller keys counted from the masks.
+ */
+
+#include "pbtree.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* Value padding the unused keys of a node (it is never less than a searched value) */
+#define KEY_PAD INT32_MAX
+
+/* The keys are compared as signed 32-bit integers (see countLess), so VAL_TYPE
+   must be one -- the array has a negative size otherwise */
+typedef char KeyTypeCheck [sizeof(VAL_TYPE) == 4 && (VAL_TYPE)-1 < 0 && (VAL_TYPE)1 / 2 == 0 ? 1 : -1];
+
+static PBTreeNode * makeBNode    (int leaf, const VAL_TYPE * keys, int cnt, PBTreeNode * const * child);
+static void         retainBNode  (PBTreeNode * x);
+static void         releaseBNode (PBTreeNode * x);
+static inline int   countLess    (const PBTreeNode * x, VAL_TYPE k);
+static inline int   countLessEq  (const PBTreeNode * x, VAL_TYPE k);
+static int          insertRec    (PBTreeNode * x, VAL_TYPE k, PBTreeNode ** out, PBTreeNode ** right, VAL_TYPE * sep);
+static int          eraseRec     (PBTreeNode * x, VAL_TYPE k, PBTreeNode ** out);
+static PBTree     * wrapRoot     (PBTreeNode * root);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates an empty persistent B+-tree.
+ */
+PBTree * makeBTree (void)
+{
+  PBTree * ret = (PBTree *)malloc(sizeof(PBTree));
+  ret->root = NULL;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree formed by inserting given value to given tree.
+ */
+PBTree * btreeInsert (PBTree * t, VAL_TYPE x)
+{
+  if (!t->root) return wrapRoot(makeBNode(1, &x, 1, NULL));
+  PBTreeNode * out, * right;
+  VAL_TYPE sep;
+  if (!insertRec(t->root, x, &out, &right, &sep))
+  {
+    retainBNode(t->root);
+    return wrapRoot(t->root);
+  }
+  if (!right) return wrapRoot(out);
+  //the root was split, the tree grows by one level
+  PBTreeNode * child [2] = {out, right};
+  PBTreeNode * root = makeBNode(0, &sep, 1, child);
+  releaseBNode(out);
+  releaseBNode(right);
+  return wrapRoot(root);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree formed by deleting given value from given tree.
+ */
+PBTree * btreeErase (PBTree * t, VAL_TYPE x)
+{
+  PBTreeNode * out;
+  if (!t->root || !eraseRec(t->root, x, &out))
+  {
+    if (t->root) retainBNode(t->root);
+    return wrapRoot(t->root);
+  }
+  if (out->cnt == 0)
+  {
+    //an inner root left with one child is dropped, an empty leaf means an empty tree
+    PBTreeNode * root = out->leaf ? NULL : out->child[0];
+    if (root) retainBNode(root);
+    releaseBNode(out);
+    return wrapRoot(root);
+  }
+  return wrapRoot(out);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether given tree contains certain value or not.
+ */
+int btreeFind (PBTree * t, VAL_TYPE x)
+{
+  PBTreeNode * cur = t->root;
+  if (!cur) return 0;
+  while (!cur->leaf) cur = cur->child[countLessEq(cur, x)];
+  int p = countLess(cur, x);
+  return p < cur->cnt && cur->keys[p] == x;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Releases given version of a tree. Exactly the nodes which are not shared
+ * with any other live version are freed. The handle must not be used afterwards.
+ */
+void releaseBTree (PBTree * t)
+{
+  if (!t) return;
+  releaseBNode(t->root);
+  free(t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a node with given keys (and cnt + 1 given children in case of an inner node),
+ * the children get one more reference. The node has one reference of its creator.
+ */
+static PBTreeNode * makeBNode (int leaf, const VAL_TYPE * keys, int cnt, PBTreeNode * const * child)
+{
+  size_t size = sizeof(PBTreeNode) + (leaf ? 0 : (BTREE_KEYS + 1) * sizeof(PBTreeNode *));
+  PBTreeNode * ret = (PBTreeNode *)malloc(size);
+  ret->refs = 1;
+  ret->cnt = cnt;
+  ret->leaf = leaf;
+  memcpy(ret->keys, keys, cnt * sizeof(VAL_TYPE));
+  for (int i = cnt; i < BTREE_KEYS; i++) ret->keys[i] = KEY_PAD;
+  if (!leaf)
+  {
+    for (int i = 0; i <= cnt; i++)
+    {
+      ret->child[i] = child[i];
+      retainBNode(child[i]);
+    }
+  }
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Adds a reference to given node.
+ */
+static void retainBNode (PBTreeNode * x)
+{
+  __atomic_add_fetch(&x->refs, 1, __ATOMIC_RELAXED);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Drops a reference to given node, unshared nodes are freed recursively (see releaseNode).
+ */
+static void releaseBNode (PBTreeNode * x)
+{
+  if (!x) return;
+  if (__atomic_sub_fetch(&x->refs, 1, __ATOMIC_ACQ_REL)) return;
+  if (!x->leaf)
+    for (int i = 0; i <= x->cnt; i++) releaseBNode(x->child[i]);
+  free(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of keys of a node which are less than k. Only the blocks
+ * of 8 keys holding the used ones are compared, the padding is never less than k.
+ */
+static inline int countLess (const PBTreeNode * x, VAL_TYPE k)
+{
+  int ret = 0;
+#if defined(__AVX2__)
+  __m256i v = _mm256_set1_epi32(k);
+  for (int i = 0; i < x->cnt; i += 8)
+  {
+    __m256i m = _mm256_cmpgt_epi32(v, _mm256_loadu_si256((const __m256i *)(x->keys + i)));
+    ret += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+  }
+#elif defined(__SSE2__)
+  __m128i v = _mm_set1_epi32(k);
+  for (int i = 0; i < x->cnt; i += 8)
+  {
+    __m128i a = _mm_cmpgt_epi32(v, _mm_loadu_si128((const __m128i *)(x->keys + i)));
+    __m128i b = _mm_cmpgt_epi32(v, _mm_loadu_si128((const __m128i *)(x->keys + i + 4)));
+    ret += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(a)) | _mm_movemask_ps(_mm_castsi128_ps(b)) << 4);
+  }
+#else
+  for (int i = 0; i < x->cnt; i++) ret += x->keys[i] < k;
+#endif
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of keys of a node which are not greater than k,
+ * it is the index of the child of an inner node where k belongs.
+ */
+static inline int countLessEq (const PBTreeNode * x, VAL_TYPE k)
+{
+  //k < KEY_PAD, so the keys not greater than k are less than k + 1
+  if (k == KEY_PAD) return x->cnt;
+  return countLess(x, k + 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Inserts k to a copy of subtree x, which is stored to out. If the copy overflows,
+ * its upper half is moved to a new node stored to right (otherwise right is NULL)
+ * and the least value under it is stored to sep. Returns 0 if k was there (nothing is created).
+ */
+static int insertRec (PBTreeNode * x, VAL_TYPE k, PBTreeNode ** out, PBTreeNode ** right, VAL_TYPE * sep)
+{
+  VAL_TYPE keys [BTREE_KEYS + 1];
+  PBTreeNode * child [BTREE_KEYS + 2];
+  int n = x->cnt;
+  *right = NULL;
+  if (x->leaf)
+  {
+    int p = countLess(x, k);
+    if (p < n && x->keys[p] == k) return 0;
+    memcpy(keys, x->keys, p * sizeof(VAL_TYPE));
+    keys[p] = k;
+    memcpy(keys + p + 1, x->keys + p, (n - p) * sizeof(VAL_TYPE));
+    n++;
+    if (n <= BTREE_KEYS)
+    {
+      *out = makeBNode(1, keys, n, NULL);
+      return 1;
+    }
+    *out = makeBNode(1, keys, n / 2, NULL);
+    *right = makeBNode(1, keys + n / 2, n - n / 2, NULL);
+    *sep = keys[n / 2];
+    return 1;
+  }
+  int c = countLessEq(x, k);
+  PBTreeNode * nc, * nr;
+  VAL_TYPE ns;
+  if (!insertRec(x->child[c], k, &nc, &nr, &ns)) return 0;
+  memcpy(keys, x->keys, n * sizeof(VAL_TYPE));
+  memcpy(child, x->child, (n + 1) * sizeof(PBTreeNode *));
+  child[c] = nc;
+  if (nr)
+  {
+    //the split child adds a key and a child
+    memmove(keys + c + 1, keys + c, (n - c) * sizeof(VAL_TYPE));
+    memmove(child + c + 2, child + c + 1, (n - c) * sizeof(PBTreeNode *));
+    keys[c] = ns;
+    child[c + 1] = nr;
+    n++;
+  }
+  if (n <= BTREE_KEYS) *out = makeBNode(0, keys, n, child);
+  else
+  {
+    //the middle key moves up
+    int m = n / 2;
+    *out = makeBNode(0, keys, m, child);
+    *right = makeBNode(0, keys + m + 1, n - m - 1, child + m + 1);
+    *sep = keys[m];
+  }
+  releaseBNode(nc);
+  releaseBNode(nr);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Deletes k from a copy of subtree x, which is stored to out (it may have fewer than
+ * BTREE_MIN keys then). An underflowing child is refilled from its sibling or merged
+ * with it. Returns 0 if k was not there (nothing is created).
+ */
+static int eraseRec (PBTreeNode * x, VAL_TYPE k, PBTreeNode ** out)
+{
+  VAL_TYPE keys [2 * BTREE_KEYS + 1];
+  PBTreeNode * child [2 * BTREE_KEYS + 2];
+  int n = x->cnt;
+  if (x->leaf)
+  {
+    int p = countLess(x, k);
+    if (p == n || x->keys[p] != k) return 0;
+    memcpy(keys, x->keys, p * sizeof(VAL_TYPE));
+    memcpy(keys + p, x->keys + p + 1, (n - p - 1) * sizeof(VAL_TYPE));
+    *out = makeBNode(1, keys, n - 1, NULL);
+    return 1;
+  }
+  int c = countLessEq(x, k);
+  PBTreeNode * nc;
+  if (!eraseRec(x->child[c], k, &nc)) return 0;
+  PBTreeNode * pchild [BTREE_KEYS + 1];
+  VAL_TYPE pkeys [BTREE_KEYS];
+  memcpy(pkeys, x->keys, n * sizeof(VAL_TYPE));
+  memcpy(pchild, x->child, (n + 1) * sizeof(PBTreeNode *));
+  if (nc->cnt >= BTREE_MIN)
+  {
+    pchild[c] = nc;
+    *out = makeBNode(0, pkeys, n, pchild);
+    releaseBNode(nc);
+    return 1;
+  }
+  //the child underflows, it is joined with its left (or right) sibling: l < r are their indices
+  int l = c > 0 ? c - 1 : c;
+  int r = l + 1;
+  PBTreeNode * a = l == c ? nc : x->child[l];
+  PBTreeNode * b = r == c ? nc : x->child[r];
+  int cnt = 0;
+  memcpy(keys, a->keys, a->cnt * sizeof(VAL_TYPE));
+  cnt = a->cnt;
+  if (!a->leaf)
+  {
+    memcpy(child, a->child, (a->cnt + 1) * sizeof(PBTreeNode *));
+    memcpy(child + a->cnt + 1, b->child, (b->cnt + 1) * sizeof(PBTreeNode *));
+    keys[cnt++] = pkeys[l];
+  }
+  memcpy(keys + cnt, b->keys, b->cnt * sizeof(VAL_TYPE));
+  cnt += b->cnt;
+  if (cnt <= BTREE_KEYS)
+  {
+    //both fit to one node, the parent loses a key and a child
+    pchild[l] = makeBNode(a->leaf, keys, cnt, child);
+    memmove(pkeys + l, pkeys + l + 1, (n - l - 1) * sizeof(VAL_TYPE));
+    memmove(pchild + r, pchild + r + 1, (n - r) * sizeof(PBTreeNode *));
+    *out = makeBNode(0, pkeys, n - 1, pchild);
+    releaseBNode(pchild[l]);
+  }
+  else
+  {
+    //the keys are spread evenly to two new nodes
+    int m = cnt / 2;
+    if (a->leaf)
+    {
+      pchild[l] = makeBNode(1, keys, m, NULL);
+      pchild[r] = makeBNode(1, keys + m, cnt - m, NULL);
+      pkeys[l] = keys[m];
+    }
+    else
+    {
+      pchild[l] = makeBNode(0, keys, m, child);
+      pchild[r] = makeBNode(0, keys + m + 1, cnt - m - 1, child + m + 1);
+      pkeys[l] = keys[m];
+    }
+    *out = makeBNode(0, pkeys, n, pchild);
+    releaseBNode(pchild[l]);
+    releaseBNode(pchild[r]);
+  }
+  releaseBNode(nc);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Wraps given root (with a reference for the new version) to a new version of a tree.
+ */
+static PBTree * wrapRoot (PBTreeNode * root)
+{
+  PBTree * ret = makeBTree();
+  ret->root = root;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
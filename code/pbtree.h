@@ -0,0 +1,62 @@
+/*-------------------------------------------------------------*
+ * pbtree.h - header for confluently persistent B+-trees       *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PBTREE_H__
+#define __PBTREE_H__
+
+#include "common.h"
+
+/* Largest number of keys of a node, it may be set at compile time (-DBTREE_KEYS=n) --
+   nodes are searched by 8 keys at once, so it must be a multiple of 8 */
+#ifndef BTREE_KEYS
+#define BTREE_KEYS 32
+#endif
+
+/* Least number of keys of a node other than the root */
+#define BTREE_MIN (BTREE_KEYS / 2)
+
+#if BTREE_KEYS < 8 || BTREE_KEYS % 8
+#error "BTREE_KEYS must be a positive multiple of 8"
+#endif
+
+/* Node of a B+-tree -- values are stored in the leaves, inner nodes hold the least
+   value of every child but the first one. Unused keys are padded by the largest value,
+   leaves are allocated without the children */
+/* With -DPRBTREE_BTREE the B+-trees take the place of the red-black trees of prbtree.h,
+   the programs using makeTree, insert, erase, find and releaseTree get them instead */
+#ifdef PRBTREE_BTREE
+#define makeBTree    makeTree
+#define btreeInsert  insert
+#define btreeErase   erase
+#define btreeFind    find
+#define releaseBTree releaseTree
+#endif
+
+struct PBTreeNode_struct
+{
+  int          refs;
+  int          cnt;
+  int          leaf;
+  VAL_TYPE     keys[BTREE_KEYS];
+  PBTreeNode * child[];
+};
+
+struct PBTree_struct
+{
+  PBTreeNode * root;
+};
+
+PBTree * makeBTree    (void);
+PBTree * btreeInsert  (PBTree * t, VAL_TYPE x);
+PBTree * btreeErase   (PBTree * t, VAL_TYPE x);
+int      btreeFind    (PBTree * t, VAL_TYPE x);
+void     releaseBTree (PBTree * t);
+
+#endif /*__PBTREE_H__*/
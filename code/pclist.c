@@ -9,17 +9,30 @@
  */
 
 #include "pclist.h"
+#include "pclistarena.h"
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-static PCList * listCreate  (PCListElem * x);
-static PCList * listPush    (PCList * d, PCListElem * x);
-static PCList * listPop     (PCList * d, PCListElem ** x);
-static PCList * listInject  (PCList * d, PCListElem * x);
-static PCList * listEject   (PCList * d, PCListElem ** x);
-static PCList * simplePop   (PCList * d, PCListElem ** x);
-static PCList * simpleEject (PCList * d, PCListElem ** x);
-static void     concatSplit (PCListBuffer * b, PCListBuffer ** b1, PCListBuffer ** b2, int first);
+static PCList * listCreate   (PCListSlot x, int leaf);
+static PCList * listPush     (PCList * d, PCListSlot x, int leaf);
+static PCList * listPop      (PCList * d, PCListSlot * x);
+static PCList * listInject   (PCList * d, PCListSlot x, int leaf);
+static PCList * listEject    (PCList * d, PCListSlot * x);
+static PCList * pushTriple   (PCList * d, PCListElem * t);
+static PCList * injectTriple (PCList * d, PCListElem * t);
+static PCList * simplePop    (PCList * d, PCListSlot * x);
+static PCList * simpleEject  (PCList * d, PCListSlot * x);
+static int      concatSplit  (PCListBuffer * b, PCListBuffer ** parts, int first);
+static PCList * bulkList     (const VAL_TYPE * vals, PCListSlot * slots, size_t n, int leaf, PCListSlot * triples);
+static PCListBuffer * bulkBuffer (const VAL_TYPE * vals, PCListSlot * slots, int leaf, size_t from, int size);
+static int        findInBuf  (PCListBuffer * b, size_t * k);
+static PCList   * bufList    (PCListBuffer * b, int from, int to);
+static PCListSlot cutBuffer  (PCListBuffer * b, size_t k, PCList ** left, PCList ** right, size_t * off);
+static PCListSlot splitList  (PCList * d, size_t k, PCList ** left, PCList ** right, size_t * off);
+static PCList   * wrapList   (PCList * d);
+static PCList   * popUnit    (PCList * d, PCListBuffer ** u);
+static PCList   * ejectUnit  (PCList * d, PCListBuffer ** u);
 
 /*---------------------------------------------------------------------------*/
 
@@ -28,8 +41,9 @@ static void     concatSplit (PCListBuffer * b, PCListBuffer ** b1, PCListBuffer
  */
 PCList * makeList (VAL_TYPE val)
 {
-  PCListElem * x = makeElem(val);
-  return listCreate(x);
+  PCListSlot x;
+  x.val = val;
+  return listCreate(x, 1);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -39,25 +53,38 @@ PCList * makeList (VAL_TYPE val)
  */
 PCList * consList (PCListBuffer * p, PCList * l, PCListBuffer * m, PCList * r, PCListBuffer * s, int so)
 {
-  PCList * ret = (PCList *)malloc(sizeof(PCList));
+  PCList * ret = (PCList *)pclistAlloc(sizeof(PCList));
   ret->p = p;
   ret->l = l;
   ret->m = m;
   ret->r = r;
   ret->s = s;
   ret->suffix_only = so;
+  ret->len = bufferLen(p) + length(l) + bufferLen(m) + length(r) + bufferLen(s);
   return ret;
 }
 
 /*---------------------------------------------------------------------------*/
 
+/**
+ * Returns a shallow copy of given list(deque) -- the top level only, all parts are shared.
+ */
+PCList * copyList (PCList * d)
+{
+  if (!d) return d;
+  return consList(d->p, d->l, d->m, d->r, d->s, d->suffix_only);
+}
+
+/*---------------------------------------------------------------------------*/
+
 /**
  * Wrapper function for user that pushes an element to a list(deque).
  */
 PCList * push (PCList * d, VAL_TYPE val)
 {
-  PCListElem * x = makeElem(val);
-  return listPush(d, x);
+  PCListSlot x;
+  x.val = val;
+  return listPush(d, x, 1);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -74,12 +101,12 @@ PCList * pop (PCList * d, VAL_TYPE * val)
   }
   if (d->suffix_only && d->s->size == 1)
   {
-    *val = getBufCont(d->s, 0)->val;
+    *val = getBufCont(d->s, 0).val;
     return NULL;
   }
-  PCListElem * x;
+  PCListSlot x;
   PCList * ret = listPop(d, &x);
-  *val = x->val;
+  *val = x.val;
   return ret;
 }
 
@@ -90,8 +117,9 @@ PCList * pop (PCList * d, VAL_TYPE * val)
  */
 PCList * inject (PCList * d, VAL_TYPE val)
 {
-  PCListElem * x = makeElem(val);
-  return listInject(d, x);
+  PCListSlot x;
+  x.val = val;
+  return listInject(d, x, 1);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -108,17 +136,185 @@ PCList * eject (PCList * d, VAL_TYPE * val)
   }
   if (d->suffix_only && d->s->size == 1)
   {
-    *val = getBufCont(d->s, 0)->val;
+    *val = getBufCont(d->s, 0).val;
     return NULL;
   }
-  PCListElem * x;
+  PCListSlot x;
   PCList * ret = listEject(d, &x);
-  *val = x->val;
+  *val = x.val;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a new list(deque) of n values from given array in one linear pass.
+ * The deque is laid out directly in a green shape (no restructuring is done).
+ */
+PCList * pclistFromArray (const VAL_TYPE * a, size_t n)
+{
+  PCListSlot * triples = NULL;
+  if (n > 9) triples = (PCListSlot *)malloc(n / 3 * sizeof(PCListSlot));
+  PCList * ret = bulkList(a, NULL, n, 1, triples);
+  free(triples);
   return ret;
 }
 
 /*---------------------------------------------------------------------------*/
 
+/**
+ * Pushes n values of given array to a list(deque), so that a[0] ends up in front.
+ */
+PCList * pushMany (PCList * d, const VAL_TYPE * a, size_t n)
+{
+  return catenate(pclistFromArray(a, n), d);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Injects n values of given array to a list(deque), so that a[n - 1] ends up at the back.
+ */
+PCList * injectMany (PCList * d, const VAL_TYPE * a, size_t n)
+{
+  return catenate(d, pclistFromArray(a, n));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the first value of a list(deque) without removing it (NA for an empty one).
+ */
+VAL_TYPE front (PCList * d)
+{
+  if (!d) return NA;
+  if (d->suffix_only) return getBufCont(d->s, 0).val;
+  return getBufCont(d->p, 0).val;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the last value of a list(deque) without removing it (NA for an empty one).
+ */
+VAL_TYPE back (PCList * d)
+{
+  if (!d) return NA;
+  return getBufCont(d->s, d->s->size - 1).val;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of values in a list(deque).
+ */
+size_t length (PCList * d)
+{
+  return d ? d->len : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the value at given position of a list(deque) (NA if there is none).
+ * The search descends by the lengths kept in lists and triples.
+ */
+VAL_TYPE nth (PCList * d, size_t k)
+{
+  if (k >= length(d)) return NA;
+  while (1)
+  {
+    PCListBuffer * part[5] = {d->p, NULL, d->m, NULL, d->s};
+    PCList * sub[5] = {NULL, d->l, NULL, d->r, NULL};
+    int c = 0;
+    for (; c < 4; c++)
+    {
+      size_t len = part[c] ? bufferLen(part[c]) : length(sub[c]);
+      if (k < len) break;
+      k -= len;
+    }
+    if (sub[c])
+    {
+      d = sub[c];
+      continue;
+    }
+    //descend through buffers and triples until a value or a nested list is reached
+    PCListBuffer * b = part[c];
+    while (b)
+    {
+      PCListSlot x = getBufCont(b, findInBuf(b, &k));
+      if (b->is_leaf) return x.val;
+      PCListElem * t = x.elem;
+      size_t lenf = bufferLen(t->fmb);
+      if (k < lenf)
+      {
+        b = t->fmb;
+        continue;
+      }
+      k -= lenf;
+      if (k < length(t->rl))
+      {
+        d = t->rl;
+        b = NULL;
+        continue;
+      }
+      k -= length(t->rl);
+      b = t->lmb;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Splits a list(deque) into its first k values (left) and the rest (right).
+ * Both parts reuse whole subtrees of the original, only the path to position k is rebuilt.
+ */
+void splitAt (PCList * d, size_t k, PCList ** left, PCList ** right)
+{
+  if (k == 0)
+  {
+    *left = NULL;
+    *right = d;
+    return;
+  }
+  if (k >= length(d))
+  {
+    *left = d;
+    *right = NULL;
+    return;
+  }
+  size_t off;
+  PCListSlot x = splitList(d, k, left, right, &off);
+  *right = listPush(*right, x, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a list(deque) of the first k values of given one.
+ */
+PCList * take (PCList * d, size_t k)
+{
+  PCList * left, * right;
+  splitAt(d, k, &left, &right);
+  return left;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a list(deque) without the first k values of given one.
+ */
+PCList * drop (PCList * d, size_t k)
+{
+  PCList * left, * right;
+  splitAt(d, k, &left, &right);
+  return right;
+}
+
+/*---------------------------------------------------------------------------*/
+
 /**
  * Concatenates two given deques.
  */
@@ -131,28 +327,27 @@ PCList * catenate (PCList * d1, PCList * d2)
   if (!isTuple(d1))
   {
     target = d2;
-    for (int i = d1->s->size - 1; i >= 0; i--) target = listPush(target, getBufCont(d1->s, i));
+    for (int i = d1->s->size - 1; i >= 0; i--) target = listPush(target, getBufCont(d1->s, i), d1->s->is_leaf);
     return target;
   }
   else if (!isTuple(d2))
   {
     target = d1;
-    for (int i = 0; i < d2->s->size; i++) target = listInject(target, getBufCont(d2->s, i));
+    for (int i = 0; i < d2->s->size; i++) target = listInject(target, getBufCont(d2->s, i), d2->s->is_leaf);
     return target;
   }
   //both lists are tuples
-  PCListBuffer * mnew = makeBuffer();
+  PCListBuffer * mnew = makeBuffer(d1->s->is_leaf, 2);
   setBufCont(mnew, getBufCont(d1->s, d1->s->size - 1), 0);
   setBufCont(mnew, getBufCont(d2->p, 0), 1);
   mnew->size = 2;
-  PCListBuffer * s1, * s2;
-  concatSplit(d1->s, &s1, &s2, 1);
-  PCList * lnew = listInject(d1->l, makeTriple(d1->m, d1->r, s1));
-  if (s2->size) lnew = listInject(lnew, makeTriple(s2, NULL, NULL));
-  PCListBuffer * p1, * p2;
-  concatSplit(d2->p, &p1, &p2, 0);
-  PCList * rnew = listPush(d2->r, makeTriple(p2, d2->l, d2->m));
-  if (p1->size) rnew = listPush(rnew, makeTriple(p1, NULL, NULL));
+  PCListBuffer * parts[PCLIST_BUF_MAX];
+  int cnt = concatSplit(d1->s, parts, 1);
+  PCList * lnew = injectTriple(d1->l, makeTriple(d1->m, d1->r, parts[0]));
+  for (int i = 1; i < cnt; i++) lnew = injectTriple(lnew, makeTriple(parts[i], NULL, NULL));
+  cnt = concatSplit(d2->p, parts, 0);
+  PCList * rnew = pushTriple(d2->r, makeTriple(parts[cnt - 1], d2->l, d2->m));
+  for (int i = cnt - 2; i >= 0; i--) rnew = pushTriple(rnew, makeTriple(parts[i], NULL, NULL));
   return consList(d1->p, lnew, mnew, rnew, d2->s, 0);
 }
 
@@ -173,26 +368,27 @@ int isTuple (PCList * d)
  */
 void gPrefix (PCList * d)
 {
-  if (d->p->size == 6)
+  if (d->p->size == PCLIST_BUF_MAX)
   {
     PCListBuffer * pnew, * qnew;
-    pnew = makeBuffer();
-    qnew = makeBuffer();
+    pnew = makeBuffer(d->p->is_leaf, PCLIST_BUF_MAX - PCLIST_SPILL);
+    qnew = makeBuffer(d->p->is_leaf, PCLIST_SPILL);
     int cp = 0;
-    for (int j = 0; j < 4; j++) setBufCont(pnew, getBufCont(d->p, cp++), j);
-    pnew->size = 4;
-    for (int j = 0; j < 2; j++) setBufCont(qnew, getBufCont(d->p, cp++), j);
-    qnew->size = 2;
+    for (int j = 0; j < PCLIST_BUF_MAX - PCLIST_SPILL; j++) setBufCont(pnew, getBufCont(d->p, cp++), j);
+    pnew->size = PCLIST_BUF_MAX - PCLIST_SPILL;
+    for (int j = 0; j < PCLIST_SPILL; j++) setBufCont(qnew, getBufCont(d->p, cp++), j);
+    qnew->size = PCLIST_SPILL;
     d->p = pnew;
-    d->l = listPush(d->l, makeTriple(qnew, NULL, NULL));
+    d->l = pushTriple(d->l, makeTriple(qnew, NULL, NULL));
     return;
   }
   PCList * x;
   if (d->l) x = d->l;
   else x = d->r;
   PCList * xtmp;
-  PCListElem * t;
-  xtmp = simplePop(x, &t);
+  PCListSlot ts;
+  xtmp = simplePop(x, &ts);
+  PCListElem * t = ts.elem;
   PCListBuffer * f = t->fmb;
   int first = 1;
   if (!f)
@@ -202,18 +398,19 @@ void gPrefix (PCList * d)
   }
   if (f->size == 2 && !t->rl) 
   {
-    xtmp = listPop(x, &t);
+    xtmp = listPop(x, &ts);
+    t = ts.elem;
     if (first) f = t->fmb;
     else f = t->lmb;
   }
-  PCListElem * a, * b;
+  PCListSlot a, b;
   if (f->size == 3)
   {
     PCListBuffer * fnew = popBuffer(f, &a);
     PCListElem * tnew;
     if (first) tnew = makeTriple(fnew, t->rl, t->lmb);
     else tnew = makeTriple(t->fmb, t->rl, fnew);
-    PCList * xnew = listPush(xtmp, tnew);
+    PCList * xnew = pushTriple(xtmp, tnew);
     if (d->l)
     {
       d->p = injectBuffer(d->p, a);
@@ -241,7 +438,7 @@ void gPrefix (PCList * d)
       }
       else
       {
-        PCList * lnew = catenate(t->rl, listPush(xtmp, makeTriple(t->lmb, NULL, NULL)));
+        PCList * lnew = catenate(t->rl, pushTriple(xtmp, makeTriple(t->lmb, NULL, NULL)));
         d->p = pnew;
         d->l = lnew;
       }
@@ -258,7 +455,7 @@ void gPrefix (PCList * d)
       }
       else
       {
-        PCList * rnew = catenate(t->rl, listPush(xtmp, makeTriple(t->lmb, NULL, NULL)));
+        PCList * rnew = catenate(t->rl, pushTriple(xtmp, makeTriple(t->lmb, NULL, NULL)));
         d->p = pnew;
         d->m = f;
         d->r = rnew;
@@ -274,26 +471,27 @@ void gPrefix (PCList * d)
  */
 void gSuffix (PCList * d)
 {
-  if (d->s->size == 6)
+  if (d->s->size == PCLIST_BUF_MAX)
   {
     PCListBuffer * snew, * qnew;
-    snew = makeBuffer();
-    qnew = makeBuffer();
+    snew = makeBuffer(d->s->is_leaf, PCLIST_BUF_MAX - PCLIST_SPILL);
+    qnew = makeBuffer(d->s->is_leaf, PCLIST_SPILL);
     int cp = d->s->size - 1;
-    for (int j = 3; j >= 0; j--) setBufCont(snew, getBufCont(d->s, cp--), j);
-    snew->size = 4;
-    for (int j = 1; j >= 0; j--) setBufCont(qnew, getBufCont(d->s, cp--), j);
-    qnew->size = 2;
+    for (int j = PCLIST_BUF_MAX - PCLIST_SPILL - 1; j >= 0; j--) setBufCont(snew, getBufCont(d->s, cp--), j);
+    snew->size = PCLIST_BUF_MAX - PCLIST_SPILL;
+    for (int j = PCLIST_SPILL - 1; j >= 0; j--) setBufCont(qnew, getBufCont(d->s, cp--), j);
+    qnew->size = PCLIST_SPILL;
     d->s = snew;
-    d->r = listInject(d->r, makeTriple(NULL, NULL, qnew));
+    d->r = injectTriple(d->r, makeTriple(NULL, NULL, qnew));
     return;
   }
   PCList * x;
   if (d->r) x = d->r;
   else x = d->l;
   PCList * xtmp;
-  PCListElem * t;
-  xtmp = simpleEject(x, &t);
+  PCListSlot ts;
+  xtmp = simpleEject(x, &ts);
+  PCListElem * t = ts.elem;
   PCListBuffer * f = t->lmb;
   int first = 1;
   if (!f)
@@ -303,18 +501,19 @@ void gSuffix (PCList * d)
   }
   if (f->size == 2 && !t->rl) 
   {
-    xtmp = listEject(x, &t);
+    xtmp = listEject(x, &ts);
+    t = ts.elem;
     if (first) f = t->lmb;
     else f = t->fmb;
   }
-  PCListElem * a, * b;
+  PCListSlot a, b;
   if (f->size == 3)
   {
     PCListBuffer * fnew = ejectBuffer(f, &a);
     PCListElem * tnew;
     if (first) tnew = makeTriple(t->fmb, t->rl, fnew);
     else tnew = makeTriple(fnew, t->rl, t->lmb);
-    PCList * xnew = listInject(xtmp, tnew);
+    PCList * xnew = injectTriple(xtmp, tnew);
     if (d->r)
     {
       d->s = pushBuffer(d->s, a);
@@ -342,7 +541,7 @@ void gSuffix (PCList * d)
       }
       else
       {
-        PCList * rnew = catenate(listInject(xtmp, makeTriple(NULL, NULL, t->fmb)), t->rl);
+        PCList * rnew = catenate(injectTriple(xtmp, makeTriple(NULL, NULL, t->fmb)), t->rl);
         d->s = snew;
         d->r = rnew;
       }
@@ -359,7 +558,7 @@ void gSuffix (PCList * d)
       }
       else
       {
-        PCList * lnew = catenate(listInject(xtmp, makeTriple(NULL, NULL, t->fmb)), t->rl);
+        PCList * lnew = catenate(injectTriple(xtmp, makeTriple(NULL, NULL, t->fmb)), t->rl);
         d->s = snew;
         d->m = f;
         d->l = lnew;
@@ -386,19 +585,21 @@ void printList (PCList * d)
 /*---------------------------------------------------------------------------*/
 
 /**
- * Helping function to create a list with the element already as a PCListElem.
+ * Helping function to create a list with the element already as a buffer slot.
  */
-static PCList * listCreate (PCListElem * x)
+static PCList * listCreate (PCListSlot x, int leaf)
 {
-  PCList * ret = (PCList *)malloc(sizeof(PCList));
+  PCList * ret = (PCList *)pclistAlloc(sizeof(PCList));
   ret->p = NULL;
   ret->l = NULL;
   ret->m = NULL;
   ret->r = NULL;
-  ret->s = makeBuffer();
+  ret->s = makeBuffer(leaf, 1);
   setBufCont(ret->s, x, 0);
   ret->s->size = 1;
   ret->suffix_only = 1;
+  ret->len = leaf ? 1 : x.elem->len;
+  return ret;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -406,26 +607,32 @@ static PCList * listCreate (PCListElem * x)
 /**
  * Actual procedure that performs push.
  */
-static PCList * listPush (PCList * d, PCListElem * x)
+static PCList * listPush (PCList * d, PCListSlot x, int leaf)
 {
-  if (!d) return listCreate(x);
+  if (!d) return listCreate(x, leaf);
   if (isTuple(d))
   {
-    if (d->p->size == 6) gPrefix(d);
+    if (d->p->size == PCLIST_BUF_MAX)
+    {
+      d = copyList(d);
+      gPrefix(d);
+    }
     return consList(pushBuffer(d->p, x), d->l, d->m, d->r, d->s, 0);
   }
   PCListBuffer * stmp = pushBuffer(d->s, x);
-  if (stmp->size <= 8) return consList(NULL, NULL, NULL, NULL, stmp, 1);
+  if (stmp->size <= PCLIST_SUFFIX_MAX) return consList(NULL, NULL, NULL, NULL, stmp, 1);
+  //the larger half goes to the prefix, which is going to grow
+  int ps = PCLIST_SUFFIX_MAX / 2, ss = PCLIST_SUFFIX_MAX - 1 - ps;
   PCListBuffer * pnew, * mnew, * snew;
-  pnew = makeBuffer();
-  mnew = makeBuffer();
-  snew = makeBuffer();
-  for (int j = 0; j < 4; j++) setBufCont(pnew, getBufCont(stmp, j), j);
-  pnew->size = 4;
-  for (int i = 4, j = 0; j < 2; i++, j++) setBufCont(mnew, getBufCont(stmp, i), j);
+  pnew = makeBuffer(stmp->is_leaf, ps);
+  mnew = makeBuffer(stmp->is_leaf, 2);
+  snew = makeBuffer(stmp->is_leaf, ss);
+  for (int j = 0; j < ps; j++) setBufCont(pnew, getBufCont(stmp, j), j);
+  pnew->size = ps;
+  for (int i = ps, j = 0; j < 2; i++, j++) setBufCont(mnew, getBufCont(stmp, i), j);
   mnew->size = 2;
-  for (int i = 6, j = 0; j < 3; i++, j++) setBufCont(snew, getBufCont(stmp, i), j);
-  snew->size = 3;
+  for (int i = ps + 2, j = 0; j < ss; i++, j++) setBufCont(snew, getBufCont(stmp, i), j);
+  snew->size = ss;
   return consList(pnew, NULL, mnew, NULL, snew, 0);
 }
 
@@ -434,20 +641,21 @@ static PCList * listPush (PCList * d, PCListElem * x)
 /**
  * Actual procedure that performs pop.
  */
-static PCList * listPop (PCList * d, PCListElem ** x)
+static PCList * listPop (PCList * d, PCListSlot * x)
 {
   if (d->suffix_only || d->p->size > 3) return simplePop(d, x);
   else if (d->p->size == 3 && (d->l || d->r))
   {
+    d = copyList(d);
     gPrefix(d);
     return simplePop(d, x);
   }
   //else for all other cases
-  PCListElem * a = getBufCont(d->p, 0);
+  PCListSlot a = getBufCont(d->p, 0);
   *x = a;
   if (d->s->size == 3)
   {
-    PCListBuffer * snew = makeBuffer();
+    PCListBuffer * snew = makeBuffer(d->p->is_leaf, d->p->size - 1 + d->m->size + d->s->size);
     int cp = 0;
     for (int i = 1; i < d->p->size; i++) setBufCont(snew, getBufCont(d->p, i), cp++);
     for (int i = 0; i < d->m->size; i++) setBufCont(snew, getBufCont(d->m, i), cp++);
@@ -457,7 +665,7 @@ static PCList * listPop (PCList * d, PCListElem ** x)
   }
   else
   {
-    PCListElem * b, * c;
+    PCListSlot b, c;
     PCListBuffer * pnew, * mnew, * snew, * ptmp, * mtmp;
     ptmp = popBuffer(d->p, &a);
     mtmp = popBuffer(d->m, &b);
@@ -473,26 +681,32 @@ static PCList * listPop (PCList * d, PCListElem ** x)
 /**
  * Actual procedure that performs inject.
  */
-static PCList * listInject (PCList * d, PCListElem * x)
+static PCList * listInject (PCList * d, PCListSlot x, int leaf)
 {
-  if (!d) return listCreate(x);
+  if (!d) return listCreate(x, leaf);
   if (isTuple(d))
   {
-    if (d->s->size == 6) gSuffix(d);
+    if (d->s->size == PCLIST_BUF_MAX)
+    {
+      d = copyList(d);
+      gSuffix(d);
+    }
     return consList(d->p, d->l, d->m, d->r, injectBuffer(d->s, x), 0);
   }
   PCListBuffer * stmp = injectBuffer(d->s, x);
-  if (stmp->size <= 8) return consList(NULL, NULL, NULL, NULL, stmp, 1);
+  if (stmp->size <= PCLIST_SUFFIX_MAX) return consList(NULL, NULL, NULL, NULL, stmp, 1);
+  //the larger half goes to the suffix, which is going to grow
+  int ss = PCLIST_SUFFIX_MAX / 2, ps = PCLIST_SUFFIX_MAX - 1 - ss;
   PCListBuffer * pnew, * mnew, * snew;
-  pnew = makeBuffer();
-  mnew = makeBuffer();
-  snew = makeBuffer();
-  for (int j = 0; j < 3; j++) setBufCont(pnew, getBufCont(stmp, j), j);
-  pnew->size = 3;
-  for (int i = 3, j = 0; j < 2; i++, j++) setBufCont(mnew, getBufCont(stmp, i), j);
+  pnew = makeBuffer(stmp->is_leaf, ps);
+  mnew = makeBuffer(stmp->is_leaf, 2);
+  snew = makeBuffer(stmp->is_leaf, ss);
+  for (int j = 0; j < ps; j++) setBufCont(pnew, getBufCont(stmp, j), j);
+  pnew->size = ps;
+  for (int i = ps, j = 0; j < 2; i++, j++) setBufCont(mnew, getBufCont(stmp, i), j);
   mnew->size = 2;
-  for (int i = 5, j = 0; j < 4; i++, j++) setBufCont(snew, getBufCont(stmp, i), j);
-  snew->size = 4;
+  for (int i = ps + 2, j = 0; j < ss; i++, j++) setBufCont(snew, getBufCont(stmp, i), j);
+  snew->size = ss;
   return consList(pnew, NULL, mnew, NULL, snew, 0);
 }
 
@@ -501,20 +715,21 @@ static PCList * listInject (PCList * d, PCListElem * x)
 /**
  * Actual procedure that performs eject.
  */
-static PCList * listEject (PCList * d, PCListElem ** x)
+static PCList * listEject (PCList * d, PCListSlot * x)
 {
   if (d->suffix_only || d->s->size > 3) return simpleEject(d, x);
   else if (d->s->size == 3 && (d->l || d->r))
   {
+    d = copyList(d);
     gSuffix(d);
     return simpleEject(d, x);
   }
   //else for all other cases
-  PCListElem * a = getBufCont(d->s, d->s->size - 1);
+  PCListSlot a = getBufCont(d->s, d->s->size - 1);
   *x = a;
   if (d->p->size == 3)
   {
-    PCListBuffer * snew = makeBuffer();
+    PCListBuffer * snew = makeBuffer(d->p->is_leaf, d->p->size + d->m->size + d->s->size - 1);
     int cp = 0;
     for (int i = 0; i < d->p->size; i++) setBufCont(snew, getBufCont(d->p, i), cp++);
     for (int i = 0; i < d->m->size; i++) setBufCont(snew, getBufCont(d->m, i), cp++);
@@ -524,7 +739,7 @@ static PCList * listEject (PCList * d, PCListElem ** x)
   }
   else
   {
-    PCListElem * b, * c;
+    PCListSlot b, c;
     PCListBuffer * snew, * mnew, * pnew, * stmp, * mtmp;
     stmp = ejectBuffer(d->s, &a);
     mtmp = ejectBuffer(d->m, &b);
@@ -537,14 +752,38 @@ static PCList * listEject (PCList * d, PCListElem ** x)
 
 /*---------------------------------------------------------------------------*/
 
+/**
+ * Pushes a triple to a list(deque) of triples.
+ */
+static PCList * pushTriple (PCList * d, PCListElem * t)
+{
+  PCListSlot x;
+  x.elem = t;
+  return listPush(d, x, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Injects a triple to a list(deque) of triples.
+ */
+static PCList * injectTriple (PCList * d, PCListElem * t)
+{
+  PCListSlot x;
+  x.elem = t;
+  return listInject(d, x, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
 /**
  * Pop that doesn't check or change size properties of list(deque) under pop.
  */
-static PCList * simplePop (PCList * d, PCListElem ** x)
+static PCList * simplePop (PCList * d, PCListSlot * x)
 {
   if (!d)
   {
-    *x = NULL;
+    x->elem = NULL;
     return d;
   }
   if (d->suffix_only)
@@ -566,11 +805,11 @@ static PCList * simplePop (PCList * d, PCListElem ** x)
 /**
  * Eject that doesn't check or change size properties of list(deque) under ejection.
  */
-static PCList * simpleEject (PCList * d, PCListElem ** x)
+static PCList * simpleEject (PCList * d, PCListSlot * x)
 {
   if (!d)
   {
-    *x = NULL;
+    x->elem = NULL;
     return d;
   }
   if (d->suffix_only)
@@ -594,85 +833,268 @@ static PCList * simpleEject (PCList * d, PCListElem ** x)
 
 /**
  * Splits buffers according to the specifications in concatenation.
+ * The last (first) element of the buffer goes to the middle buffer, the rest
+ * is divided into buffers of sizes 3 followed (preceded) by buffers of size 2.
+ * Returns the number of the buffers.
  */
-static void concatSplit (PCListBuffer * b, PCListBuffer ** b1, PCListBuffer ** b2, int first)
+static int concatSplit (PCListBuffer * b, PCListBuffer ** parts, int first)
 {
-  *b1 = makeBuffer();
-  *b2 = makeBuffer();
   int size = b->size - 1;
-  switch (size)
+  int n2 = (3 - size % 3) % 3;
+  int n3 = (size - 2 * n2) / 3;
+  int cnt = n2 + n3;
+  int cp = first ? 0 : 1;
+  for (int i = 0; i < cnt; i++)
   {
-    case 2:
-      if (first) 
-      {
-        int cp = 0;
-        for (int i = 0; i < 2; i++) setBufCont(*b1, getBufCont(b, cp++), i);
-        (*b1)->size = 2;
-        (*b2)->size = 0;
-      }
-      else 
-      {
-        int cp = 1;
-        for (int i = 0; i < 2; i++) setBufCont(*b2, getBufCont(b, cp++), i);
-        (*b1)->size = 0;
-        (*b2)->size = 2;
-      }
-      break;
-    case 3:
-      if (first) 
-      {
-        int cp = 0;
-        for (int i = 0; i < 3; i++) setBufCont(*b1, getBufCont(b, cp++), i);
-        (*b1)->size = 3;
-        (*b2)->size = 0;
-      }
-      else 
-      {
-        int cp = 1;
-        for (int i = 0; i < 3; i++) setBufCont(*b2, getBufCont(b, cp++), i);
-        (*b1)->size = 0;
-        (*b2)->size = 3;
-      }
-      break;
-    case 4:
-      if (first) 
-      {
-        int cp = 0;
-        for (int i = 0; i < 2; i++) setBufCont(*b1, getBufCont(b, cp++), i);
-        for (int i = 0; i < 2; i++) setBufCont(*b2, getBufCont(b, cp++), i);
-        (*b1)->size = 2;
-        (*b2)->size = 2;
-      }
-      else 
-      {
-        int cp = 1;
-        for (int i = 0; i < 2; i++) setBufCont(*b1, getBufCont(b, cp++), i);
-        for (int i = 0; i < 2; i++) setBufCont(*b2, getBufCont(b, cp++), i);
-        (*b1)->size = 2;
-        (*b2)->size = 2;
-      }
-      break;
-    case 5:
-      if (first) 
-      {
-        int cp = 0;
-        for (int i = 0; i < 3; i++) setBufCont(*b1, getBufCont(b, cp++), i);
-        for (int i = 0; i < 2; i++) setBufCont(*b2, getBufCont(b, cp++), i);
-        (*b1)->size = 3;
-        (*b2)->size = 2;
-      }
-      else 
-      {
-        int cp = 1;
-        for (int i = 0; i < 2; i++) setBufCont(*b1, getBufCont(b, cp++), i);
-        for (int i = 0; i < 3; i++) setBufCont(*b2, getBufCont(b, cp++), i);
-        (*b1)->size = 2;
-        (*b2)->size = 3;
-      }
-      break;
-    default:
-      break;
+    int n = (first ? i < n3 : i >= n2) ? 3 : 2;
+    parts[i] = makeBuffer(b->is_leaf, n);
+    for (int j = 0; j < n; j++) setBufCont(parts[i], getBufCont(b, cp++), j);
+    parts[i]->size = n;
+  }
+  return cnt;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Builds a list(deque) of n elements -- values when vals is given, otherwise
+ * given slots (values if leaf is set, triples of a deeper level otherwise). Prefix and suffix get 4 or 5 elements, so that
+ * the rest except the middle buffer splits into triples of 3 elements, which form
+ * the deeper level. The array of triples is the scratch space shared by all levels.
+ */
+static PCList * bulkList (const VAL_TYPE * vals, PCListSlot * slots, size_t n, int leaf, PCListSlot * triples)
+{
+  if (!n) return NULL;
+  if (n <= PCLIST_SUFFIX_MAX) return consList(NULL, NULL, NULL, NULL, bulkBuffer(vals, slots, leaf, 0, n), 1);
+  if (n < 10)
+  {
+    int ps = (int)(n - 1) / 2;
+    return consList(bulkBuffer(vals, slots, leaf, 0, ps), NULL, bulkBuffer(vals, slots, leaf, ps, 2), NULL,
+                    bulkBuffer(vals, slots, leaf, ps + 2, (int)n - 2 - ps), 0);
+  }
+  size_t ends = 8 + (n - 10) % 3;
+  size_t ps = ends / 2, ss = ends - ps;
+  size_t k = (n - 2 - ends) / 3;
+  assert(!k || triples);
+  //the buffers are filled first, the triples may overwrite slots of this level
+  PCListBuffer * p = bulkBuffer(vals, slots, leaf, 0, ps);
+  PCListBuffer * m = bulkBuffer(vals, slots, leaf, n - ss - 2, 2);
+  PCListBuffer * s = bulkBuffer(vals, slots, leaf, n - ss, ss);
+  for (size_t i = 0; i < k; i++) triples[i].elem = makeTriple(bulkBuffer(vals, slots, leaf, ps + 3 * i, 3), NULL, NULL);
+  return consList(p, bulkList(NULL, triples, k, 0, triples), m, NULL, s, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a buffer of given size from a part of an array (of values or slots).
+ */
+static PCListBuffer * bulkBuffer (const VAL_TYPE * vals, PCListSlot * slots, int leaf, size_t from, int size)
+{
+  PCListBuffer * ret = makeBuffer(leaf, size);
+  for (int i = 0; i < size; i++)
+  {
+    if (vals) ret->buf[i].val = vals[from + i];
+    else ret->buf[i] = slots[from + i];
+  }
+  ret->size = size;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the index of the element of a buffer which holds the k-th value,
+ * k is decreased to the position inside that element.
+ */
+static int findInBuf (PCListBuffer * b, size_t * k)
+{
+  int i = 0;
+  if (b->is_leaf)
+  {
+    i = (int)*k;
+    *k = 0;
+    return i;
+  }
+  while (*k >= getBufCont(b, i).elem->len) *k -= getBufCont(b, i++).elem->len;
+  return i;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a small list(deque) of the elements of a buffer between given positions.
+ * Wide buffers (see PCLIST_BUF_CAP) need triples, which are made in a scratch array
+ * on the stack -- the buffer itself may be shared, so it must not be overwritten.
+ */
+static PCList * bufList (PCListBuffer * b, int from, int to)
+{
+  PCListSlot triples[PCLIST_BUF_CAP / 3];
+  if (!b || from >= to) return NULL;
+  assert(to - from <= PCLIST_BUF_CAP);
+  return bulkList(NULL, &b->buf[from], to - from, b->is_leaf, triples);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Cuts a buffer at the element holding the k-th value. Elements in front of it
+ * are appended to left, the ones behind it are prepended to right.
+ */
+static PCListSlot cutBuffer (PCListBuffer * b, size_t k, PCList ** left, PCList ** right, size_t * off)
+{
+  int i = findInBuf(b, &k);
+  *left = catenate(*left, bufList(b, 0, i));
+  *right = catenate(bufList(b, i + 1, b->size), *right);
+  *off = k;
+  return getBufCont(b, i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Splits a list(deque) at the element holding the k-th value (0 <= k < length).
+ * Returns that element, the elements in front of it form left and the ones behind
+ * it form right (lists of the same level). The position inside the element is stored to off.
+ * Parts which are not on the path to the k-th value are taken over as they are --
+ * nested lists just get wrapped to the level of given list.
+ */
+static PCListSlot splitList (PCList * d, size_t k, PCList ** left, PCList ** right, size_t * off)
+{
+  PCListBuffer * part[5] = {d->p, NULL, d->m, NULL, d->s};
+  PCList * sub[5] = {NULL, d->l, NULL, d->r, NULL};
+  int c = 0;
+  for (; c < 4; c++)
+  {
+    size_t len = part[c] ? bufferLen(part[c]) : length(sub[c]);
+    if (k < len) break;
+    k -= len;
+  }
+  *left = NULL;
+  *right = NULL;
+  for (int i = 0; i < c; i++) *left = catenate(*left, part[i] ? bufList(part[i], 0, part[i]->size) : wrapList(sub[i]));
+  for (int i = 4; i > c; i--) *right = catenate(part[i] ? bufList(part[i], 0, part[i]->size) : wrapList(sub[i]), *right);
+  if (part[c]) return cutBuffer(part[c], k, left, right, off);
+  //the value lies in a nested list -- follow the triples holding it
+  PCList * x = sub[c];
+  while (1)
+  {
+    PCList * xl, * xr;
+    size_t o;
+    PCListElem * t = splitList(x, k, &xl, &xr, &o).elem;
+    *left = catenate(*left, wrapList(xl));
+    *right = catenate(wrapList(xr), *right);
+    k = o;
+    size_t lenf = bufferLen(t->fmb);
+    if (k < lenf)
+    {
+      *right = catenate(bufList(t->lmb, 0, t->lmb ? t->lmb->size : 0), *right);
+      *right = catenate(wrapList(t->rl), *right);
+      return cutBuffer(t->fmb, k, left, right, off);
+    }
+    k -= lenf;
+    *left = catenate(*left, bufList(t->fmb, 0, t->fmb ? t->fmb->size : 0));
+    if (k < length(t->rl))
+    {
+      *right = catenate(bufList(t->lmb, 0, t->lmb ? t->lmb->size : 0), *right);
+      x = t->rl;
+      continue;
+    }
+    k -= length(t->rl);
+    *left = catenate(*left, wrapList(t->rl));
+    return cutBuffer(t->lmb, k, left, right, off);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Turns a list(deque) of triples into a list(deque) of the level above with the same values.
+ * Prefix, middle and suffix are made of whole buffers taken from the triples at both ends,
+ * the rest of given list becomes the nested list.
+ */
+static PCList * wrapList (PCList * d)
+{
+  if (!d) return NULL;
+  PCListSlot items[12];
+  int n = 0, leaf = 0;
+  PCListBuffer * u, * v, * w;
+  //prefix of at least 3 elements
+  d = popUnit(d, &u);
+  leaf = u->is_leaf;
+  for (int i = 0; i < u->size; i++) items[n++] = getBufCont(u, i);
+  if (d && n < 3)
+  {
+    d = popUnit(d, &u);
+    for (int i = 0; i < u->size; i++) items[n++] = getBufCont(u, i);
+  }
+  int np = n;
+  //suffix of at least 3 elements
+  if (d) d = ejectUnit(d, &v);
+  else v = NULL;
+  if (d && v->size < 3) d = ejectUnit(d, &w);
+  else w = NULL;
+  if (w) for (int i = 0; i < w->size; i++) items[n++] = getBufCont(w, i);
+  if (v) for (int i = 0; i < v->size; i++) items[n++] = getBufCont(v, i);
+  //too few elements for a middle buffer -- all of them are in items (which serve as the scratch array too)
+  if (!d) return bulkList(NULL, items, n, leaf, items);
+  d = ejectUnit(d, &u);
+  PCListBuffer * p = bulkBuffer(NULL, items, leaf, 0, np);
+  PCListBuffer * m = bulkBuffer(NULL, u->buf, leaf, 0, 2);
+  PCListBuffer * s;
+  if (u->size == 3)
+  {
+    items[np - 1] = getBufCont(u, 2);
+    s = bulkBuffer(NULL, items, leaf, np - 1, n - np + 1);
+  }
+  else s = bulkBuffer(NULL, items, leaf, np, n - np);
+  return consList(p, d, m, NULL, s, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Removes the first buffer (of the level above) from a list(deque) of triples.
+ */
+static PCList * popUnit (PCList * d, PCListBuffer ** u)
+{
+  PCListSlot ts;
+  PCList * rest = listPop(d, &ts);
+  PCListElem * t = ts.elem;
+  PCList * rl = t->rl;
+  PCListBuffer * lmb = t->lmb;
+  if (t->fmb && t->fmb->size) *u = t->fmb;
+  else if (rl) rl = popUnit(rl, u);
+  else
+  {
+    *u = lmb;
+    lmb = NULL;
+  }
+  if (lmb && lmb->size) rest = pushTriple(rest, makeTriple(lmb, NULL, NULL));
+  return catenate(rl, rest);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Removes the last buffer (of the level above) from a list(deque) of triples.
+ */
+static PCList * ejectUnit (PCList * d, PCListBuffer ** u)
+{
+  PCListSlot ts;
+  PCList * rest = listEject(d, &ts);
+  PCListElem * t = ts.elem;
+  PCList * rl = t->rl;
+  PCListBuffer * fmb = t->fmb;
+  if (t->lmb && t->lmb->size) *u = t->lmb;
+  else if (rl) rl = ejectUnit(rl, u);
+  else
+  {
+    *u = fmb;
+    fmb = NULL;
   }
+  if (fmb && fmb->size) rest = injectTriple(rest, makeTriple(NULL, NULL, fmb));
+  return catenate(rest, rl);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -11,6 +11,7 @@
 #ifndef __PCL_H__
 #define __PCL_H__
 
+#include <stddef.h>
 #include "common.h"
 #include "pclistbuffer.h"
 
@@ -22,6 +23,7 @@ struct PCList_struct
   PCList       * r;
   PCListBuffer * s;
   int            suffix_only;
+  size_t         len;
 };
 
 PCList * makeList  (VAL_TYPE val);
@@ -31,7 +33,17 @@ PCList * push      (PCList * d, VAL_TYPE val);
 PCList * pop       (PCList * d, VAL_TYPE * val);
 PCList * inject    (PCList * d, VAL_TYPE val);
 PCList * eject     (PCList * d, VAL_TYPE * val);
+VAL_TYPE front     (PCList * d);
+VAL_TYPE back      (PCList * d);
+size_t   length    (PCList * d);
+VAL_TYPE nth       (PCList * d, size_t k);
+void     splitAt   (PCList * d, size_t k, PCList ** left, PCList ** right);
+PCList * take      (PCList * d, size_t k);
+PCList * drop      (PCList * d, size_t k);
 PCList * catenate  (PCList * d1, PCList * d2);
+PCList * pclistFromArray (const VAL_TYPE * a, size_t n);
+PCList * pushMany        (PCList * d, const VAL_TYPE * a, size_t n);
+PCList * injectMany      (PCList * d, const VAL_TYPE * a, size_t n);
 void     gPrefix   (PCList * d);
 void     gSuffix   (PCList * d);
 int      isTuple   (PCList * d);
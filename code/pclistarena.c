@@ -0,0 +1,101 @@
+/*---------------------------------------------------------------*
+ * pclistarena.c - implementation of region allocator of PCList  *
+ *---------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent   *
+ * data structures and their applications.                       *
+ *                                                               *
+ * Author: Josef Malík                                           *
+ *---------------------------------------------------------------*
+ */
+
+#include "pclistarena.h"
+#include <stdlib.h>
+
+/* Alignment of every block handed out by an arena */
+#define ARENA_ALIGN sizeof(void *)
+
+/* Header of a chunk, the blocks follow right behind it */
+struct PCListChunk_struct
+{
+  PCListChunk * next;
+  void        * pad;
+};
+
+/* Arena that serves allocations of deque parts of the calling thread (NULL means plain malloc) */
+static __thread PCListArena * current = NULL;
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates an empty arena which allocates chunks of given size (0 means default).
+ */
+PCListArena * makeArena (size_t chunk_size)
+{
+  PCListArena * ret = (PCListArena *)malloc(sizeof(PCListArena));
+  ret->chunks = NULL;
+  ret->cur = NULL;
+  ret->end = NULL;
+  ret->chunk_size = chunk_size ? chunk_size : ARENA_CHUNK;
+  ret->bytes = 0;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Makes all following deque operations of the calling thread allocate from given
+ * arena (or from malloc when NULL is given). Returns the previously used arena.
+ * Every thread has its own setting, but one arena must not be used by two threads at once.
+ */
+PCListArena * useArena (PCListArena * a)
+{
+  PCListArena * prev = current;
+  current = a;
+  return prev;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Allocates a block for a part of deque -- bumps a pointer in the current arena,
+ * falls back to malloc if there is none.
+ */
+void * pclistAlloc (size_t size)
+{
+  if (!current) return malloc(size);
+  size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  if ((size_t)(current->end - current->cur) < size)
+  {
+    size_t csize = size > current->chunk_size ? size : current->chunk_size;
+    PCListChunk * c = (PCListChunk *)malloc(sizeof(PCListChunk) + csize);
+    c->next = current->chunks;
+    current->chunks = c;
+    current->cur = (char *)(c + 1);
+    current->end = current->cur + csize;
+  }
+  void * ret = current->cur;
+  current->cur += size;
+  current->bytes += size;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Releases all chunks of given arena at once together with the arena itself.
+ * No version of any deque that was built inside the arena may be used afterwards.
+ */
+void releaseArena (PCListArena * a)
+{
+  if (!a) return;
+  if (current == a) current = NULL;
+  while (a->chunks)
+  {
+    PCListChunk * next = a->chunks->next;
+    free(a->chunks);
+    a->chunks = next;
+  }
+  free(a);
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,36 @@
+/*-------------------------------------------------------------*
+ * pclistarena.h - header for region allocator used in PCList  *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PCLISTARENA_H__
+#define __PCLISTARENA_H__
+
+#include <stddef.h>
+#include "common.h"
+
+/* Default size of one chunk of an arena (in bytes) */
+#define ARENA_CHUNK 65536
+
+typedef struct PCListChunk_struct PCListChunk;
+
+struct PCListArena_struct
+{
+  PCListChunk * chunks;
+  char        * cur;
+  char        * end;
+  size_t        chunk_size;
+  size_t        bytes;
+};
+
+PCListArena * makeArena    (size_t chunk_size);
+PCListArena * useArena     (PCListArena * a);
+void        * pclistAlloc  (size_t size);
+void          releaseArena (PCListArena * a);
+
+#endif /*__PCLISTARENA_H__*/
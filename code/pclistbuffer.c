@@ -9,18 +9,22 @@
  */
 
 #include "pclistbuffer.h"
+#include "pclistarena.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Creates a blank constant-sized buffer.
+ * Creates a blank buffer with room for cap elements
+ * (values if leaf is set, triples otherwise).
  */
-PCListBuffer * makeBuffer (void)
+PCListBuffer * makeBuffer (int leaf, int cap)
 {
-  PCListBuffer * ret = (PCListBuffer *)malloc(sizeof(PCListBuffer));
+  PCListBuffer * ret = (PCListBuffer *)pclistAlloc(sizeof(PCListBuffer) + cap * sizeof(PCListSlot));
   ret->size = 0;
+  ret->is_leaf = leaf;
   return ret;
 }
 
@@ -29,9 +33,9 @@ PCListBuffer * makeBuffer (void)
 /**
  * Corresponds to BPUSH in the thesis -- performs push of an element on a buffer.
  */
-PCListBuffer * pushBuffer (PCListBuffer * a, PCListElem  * x)
+PCListBuffer * pushBuffer (PCListBuffer * a, PCListSlot x)
 {
-  PCListBuffer * ret = (PCListBuffer *)malloc(sizeof(PCListBuffer));
+  PCListBuffer * ret = makeBuffer(a->is_leaf, a->size + 1);
   for (int i = 0; i < a->size; i++) setBufCont(ret, getBufCont(a, i), i + 1);
   setBufCont(ret, x, 0);
   ret->size = a->size + 1;
@@ -43,15 +47,15 @@ PCListBuffer * pushBuffer (PCListBuffer * a, PCListElem  * x)
 /**
  * Corresponds to BPOP in the thesis -- performs pop from a buffer.
  */
-PCListBuffer * popBuffer (PCListBuffer * a, PCListElem ** x)
+PCListBuffer * popBuffer (PCListBuffer * a, PCListSlot * x)
 {
   PCListBuffer * ret;
   if (!a)
   {
-    *x = NULL;
+    x->elem = NULL;
     return a;
   }
-  ret = (PCListBuffer *)malloc(sizeof(PCListBuffer));
+  ret = makeBuffer(a->is_leaf, a->size - 1);
   for (int i = 1; i < a->size; i++) setBufCont(ret, getBufCont(a, i), i - 1);
   ret->size = a->size - 1;
   *x = getBufCont(a, 0);
@@ -63,9 +67,9 @@ PCListBuffer * popBuffer (PCListBuffer * a, PCListElem ** x)
 /**
  * Corresponds to BINJECT in the thesis -- performs injection of an element to a buffer.
  */
-PCListBuffer * injectBuffer (PCListBuffer * a, PCListElem * x)
+PCListBuffer * injectBuffer (PCListBuffer * a, PCListSlot x)
 {
-  PCListBuffer * ret = (PCListBuffer *)malloc(sizeof(PCListBuffer));
+  PCListBuffer * ret = makeBuffer(a->is_leaf, a->size + 1);
   for (int i = 0; i < a->size; i++) setBufCont(ret, getBufCont(a, i), i);
   setBufCont(ret, x, a->size);
   ret->size = a->size + 1;
@@ -77,15 +81,15 @@ PCListBuffer * injectBuffer (PCListBuffer * a, PCListElem * x)
 /**
  * Corresponds to BEJECT in the thesis -- performs ejection from a buffer.
  */
-PCListBuffer * ejectBuffer (PCListBuffer * a, PCListElem ** x)
+PCListBuffer * ejectBuffer (PCListBuffer * a, PCListSlot * x)
 {
   PCListBuffer * ret;
   if (!a)
   {
-    *x = NULL;
+    x->elem = NULL;
     return a;
   }
-  ret = (PCListBuffer *)malloc(sizeof(PCListBuffer));
+  ret = makeBuffer(a->is_leaf, a->size - 1);
   for (int i = 0; i < a->size - 1; i++) setBufCont(ret, getBufCont(a, i), i);
   ret->size = a->size - 1;
   *x = getBufCont(a, a->size - 1);
@@ -97,7 +101,7 @@ PCListBuffer * ejectBuffer (PCListBuffer * a, PCListElem ** x)
 /**
  * Sets buffer's content on the given position
  */
-void setBufCont (PCListBuffer * a, PCListElem * x, int pos)
+void setBufCont (PCListBuffer * a, PCListSlot x, int pos)
 {
   a->buf[pos] = x;
 }
@@ -107,20 +111,38 @@ void setBufCont (PCListBuffer * a, PCListElem * x, int pos)
 /**
  * Retrieves content of a buffer at the given position
  */
-PCListElem * getBufCont (PCListBuffer * a, int pos)
+PCListSlot getBufCont (PCListBuffer * a, int pos)
 {
   return a->buf[pos];
 }
 
 /*---------------------------------------------------------------------------*/
 
+/**
+ * Returns the number of values stored in a buffer (in all of its triples for deeper levels).
+ */
+size_t bufferLen (PCListBuffer * a)
+{
+  if (!a) return 0;
+  if (a->is_leaf) return a->size;
+  size_t ret = 0;
+  for (int i = 0; i < a->size; i++) ret += getBufCont(a, i).elem->len;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
 /**
  * Prints buffer to std. output.
  */
 void printBuffer (PCListBuffer * a)
 {
   if (!a) return;
-  for (int i = 0; i < a->size; i++) printElem(getBufCont(a, i)); 
+  for (int i = 0; i < a->size; i++)
+  {
+    if (a->is_leaf) printf("%d ", getBufCont(a, i).val);
+    else printElem(getBufCont(a, i).elem);
+  }
 }
 
 /*---------------------------------------------------------------------------*/
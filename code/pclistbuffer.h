@@ -11,21 +11,58 @@
 #ifndef __PCLISTBUFFER_H__
 #define __PCLISTBUFFER_H__
 
+#include <stddef.h>
 #include "common.h"
 #include "pclistelem.h"
 
+/* Largest prefix (suffix) of a deque made of a tuple, it may be set at compile time
+   (-DPCLIST_BUF_MAX=n) -- wider buffers mean more copying per operation but less
+   frequent restructuring of the deeper levels */
+#ifndef PCLIST_BUF_MAX
+#define PCLIST_BUF_MAX 6
+#endif
+
+/* Largest deque represented by a suffix only, it may be set at compile time as well */
+#ifndef PCLIST_SUFFIX_MAX
+#define PCLIST_SUFFIX_MAX 8
+#endif
+
+/* Largest number of elements of any buffer */
+#define PCLIST_BUF_CAP (PCLIST_BUF_MAX > PCLIST_SUFFIX_MAX ? PCLIST_BUF_MAX : PCLIST_SUFFIX_MAX)
+
+/* Number of elements moved from a full prefix (suffix) to a new triple */
+#define PCLIST_SPILL (PCLIST_BUF_MAX - 4 < 3 ? PCLIST_BUF_MAX - 4 : 3)
+
+#if PCLIST_BUF_MAX < 6
+#error "PCLIST_BUF_MAX must be at least 6"
+#endif
+#if PCLIST_SUFFIX_MAX < 7 || PCLIST_SUFFIX_MAX / 2 > PCLIST_BUF_MAX
+#error "PCLIST_SUFFIX_MAX must be at least 7 and at most 2 * PCLIST_BUF_MAX + 1"
+#endif
+
+/* Content of a buffer -- values are stored inline in the top level (leaf) buffers,
+   only buffers of the deeper levels hold triples */
+union PCListSlot_union
+{
+  VAL_TYPE     val;
+  PCListElem * elem;
+};
+
+/* Buffers are allocated just as large as their content */
 struct PCListBuffer_struct
 {
-  PCListElem * buf[10];
-  int          size;
+  int        size;
+  int        is_leaf;
+  PCListSlot buf[];
 };
 
-PCListBuffer * makeBuffer   (void);
-PCListBuffer * pushBuffer   (PCListBuffer * a, PCListElem * x);
-PCListBuffer * popBuffer    (PCListBuffer * a, PCListElem ** x);
-PCListBuffer * injectBuffer (PCListBuffer * a, PCListElem * x);
-PCListBuffer * ejectBuffer  (PCListBuffer * a, PCListElem ** x);
-void           setBufCont   (PCListBuffer * a, PCListElem * x, int pos);
-PCListElem   * getBufCont   (PCListBuffer * a, int pos);
+PCListBuffer * makeBuffer   (int leaf, int cap);
+PCListBuffer * pushBuffer   (PCListBuffer * a, PCListSlot x);
+PCListBuffer * popBuffer    (PCListBuffer * a, PCListSlot * x);
+PCListBuffer * injectBuffer (PCListBuffer * a, PCListSlot x);
+PCListBuffer * ejectBuffer  (PCListBuffer * a, PCListSlot * x);
+void           setBufCont   (PCListBuffer * a, PCListSlot x, int pos);
+PCListSlot     getBufCont   (PCListBuffer * a, int pos);
+size_t         bufferLen    (PCListBuffer * a);
 
 #endif /*__PCLISTBUFFER_H__*/
@@ -1,5 +1,5 @@
 /*-------------------------------------------------------------*
- * pclistelem.h - header for elements used in PCList           *
+ * pclistelem.h - header for triples used in PCList            *
  *-------------------------------------------------------------*
  * This file is a part of a Bachelor's thesis named Persistent *
  * data structures and their applications.                     *
@@ -11,6 +11,7 @@
 #ifndef __PCLISTELEM_H__
 #define __PCLISTELEM_H__
 
+#include <stddef.h>
 #include "common.h"
 
 struct PCListElem_struct
@@ -18,11 +19,9 @@ struct PCListElem_struct
   PCListBuffer * fmb;
   PCList       * rl;
   PCListBuffer * lmb;
-  VAL_TYPE       val;
-  int            is_triple;
+  size_t         len;
 };
 
-PCListElem * makeElem   (VAL_TYPE content);
 PCListElem * makeTriple (PCListBuffer * fmb, PCList * rl, PCListBuffer * lmb);
 void         printElem  (PCListElem * x);
 
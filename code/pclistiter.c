@@ -0,0 +1,211 @@
+/*----------------------------------------------------------------*
+ * pclistiter.c - implementation of cursors over PCList versions  *
+ *----------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent    *
+ * data structures and their applications.                        *
+ *                                                                *
+ * Author: Josef Malík                                            *
+ *----------------------------------------------------------------*
+ */
+
+#include "pclistiter.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Kinds of traversal frames */
+#define FRAME_LIST   0
+#define FRAME_TRIPLE 1
+#define FRAME_BUFFER 2
+#define FRAME_LEAF   3
+
+static void pushFrame   (PCListIter * it, void * node, int kind);
+static void enterBuffer (PCListIter * it, PCListBuffer * b);
+static int  advance     (PCListIter * it);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Initializes a cursor over given version of a list(deque), which goes
+ * from the front to the back (or from the back to the front if backward is set).
+ * The cursor does not allocate unless the deque is nested deeper than
+ * PCLIST_ITER_DEPTH levels.
+ */
+void initIter (PCListIter * it, PCList * d, int backward)
+{
+  it->stack = it->frames;
+  it->top = 0;
+  it->cap = PCLIST_ITER_DEPTH;
+  it->backward = backward;
+  if (d) pushFrame(it, d, FRAME_LIST);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Retrieves the next value of a cursor. Returns 0 when the cursor is at the end.
+ */
+int iterNext (PCListIter * it, VAL_TYPE * val)
+{
+  if (!advance(it)) return 0;
+  PCListFrame * f = &it->stack[it->top - 1];
+  PCListBuffer * b = (PCListBuffer *)f->node;
+  *val = getBufCont(b, it->backward ? b->size - 1 - f->pos : f->pos).val;
+  f->pos++;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Fills given array with at most n next values of a cursor. Returns how many were written.
+ */
+size_t nextBatch (PCListIter * it, VAL_TYPE * out, size_t n)
+{
+  size_t cnt = 0;
+  while (cnt < n && advance(it))
+  {
+    PCListFrame * f = &it->stack[it->top - 1];
+    PCListBuffer * b = (PCListBuffer *)f->node;
+    int k = b->size - f->pos;
+    if ((size_t)k > n - cnt) k = (int)(n - cnt);
+    if (it->backward)
+    {
+      for (int i = b->size - 1 - f->pos, j = 0; j < k; i--, j++) out[cnt++] = b->buf[i].val;
+    }
+    else
+    {
+      for (int i = f->pos, j = 0; j < k; i++, j++) out[cnt++] = b->buf[i].val;
+    }
+    f->pos += k;
+  }
+  return cnt;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Releases what a cursor may have allocated for very deep deques.
+ */
+void endIter (PCListIter * it)
+{
+  if (it->stack != it->frames) free(it->stack);
+  it->stack = it->frames;
+  it->top = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Copies at most n first values of a list(deque) to given array. Returns how many were written.
+ */
+size_t pclistToArray (PCList * d, VAL_TYPE * out, size_t n)
+{
+  PCListIter it;
+  initIter(&it, d, 0);
+  size_t ret = nextBatch(&it, out, n);
+  endIter(&it);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Adds a frame on top of the traversal stack (the stack moves to the heap when it runs out).
+ */
+static void pushFrame (PCListIter * it, void * node, int kind)
+{
+  if (it->top == it->cap)
+  {
+    PCListFrame * s = (PCListFrame *)malloc(2 * it->cap * sizeof(PCListFrame));
+    memcpy(s, it->stack, it->top * sizeof(PCListFrame));
+    if (it->stack != it->frames) free(it->stack);
+    it->stack = s;
+    it->cap *= 2;
+  }
+  it->stack[it->top].node = node;
+  it->stack[it->top].kind = kind;
+  it->stack[it->top].pos = 0;
+  it->top++;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Adds a frame of given buffer unless it is empty.
+ */
+static void enterBuffer (PCListIter * it, PCListBuffer * b)
+{
+  if (b && b->size) pushFrame(it, b, b->is_leaf ? FRAME_LEAF : FRAME_BUFFER);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves the traversal to the closest leaf buffer with an unread value.
+ * Returns 0 when there is none (the cursor is at the end).
+ */
+static int advance (PCListIter * it)
+{
+  while (it->top)
+  {
+    PCListFrame * f = &it->stack[it->top - 1];
+    switch (f->kind)
+    {
+      case FRAME_LEAF:
+        if (f->pos < ((PCListBuffer *)f->node)->size) return 1;
+        it->top--;
+        break;
+      case FRAME_BUFFER:
+      {
+        PCListBuffer * b = (PCListBuffer *)f->node;
+        if (f->pos == b->size)
+        {
+          it->top--;
+          break;
+        }
+        int i = it->backward ? b->size - 1 - f->pos : f->pos;
+        f->pos++;
+        pushFrame(it, getBufCont(b, i).elem, FRAME_TRIPLE);
+        break;
+      }
+      case FRAME_TRIPLE:
+      {
+        PCListElem * t = (PCListElem *)f->node;
+        if (f->pos == 3)
+        {
+          it->top--;
+          break;
+        }
+        int part = it->backward ? 2 - f->pos : f->pos;
+        f->pos++;
+        if (part == 0) enterBuffer(it, t->fmb);
+        else if (part == 1 && t->rl) pushFrame(it, t->rl, FRAME_LIST);
+        else if (part == 2) enterBuffer(it, t->lmb);
+        break;
+      }
+      default:
+      {
+        PCList * d = (PCList *)f->node;
+        if (f->pos == 5)
+        {
+          it->top--;
+          break;
+        }
+        int part = it->backward ? 4 - f->pos : f->pos;
+        f->pos++;
+        switch (part)
+        {
+          case 0: enterBuffer(it, d->p); break;
+          case 1: if (d->l) pushFrame(it, d->l, FRAME_LIST); break;
+          case 2: enterBuffer(it, d->m); break;
+          case 3: if (d->r) pushFrame(it, d->r, FRAME_LIST); break;
+          default: enterBuffer(it, d->s); break;
+        }
+        break;
+      }
+    }
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,46 @@
+/*-------------------------------------------------------------*
+ * pclistiter.h - header for cursors over PCList versions      *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PCLISTITER_H__
+#define __PCLISTITER_H__
+
+#include <stddef.h>
+#include "common.h"
+#include "pclist.h"
+
+/* Number of frames a cursor holds without touching the heap */
+#ifndef PCLIST_ITER_DEPTH
+#define PCLIST_ITER_DEPTH 128
+#endif
+
+/* One level of the traversal -- a list, a triple or a buffer and the position in it */
+typedef struct
+{
+  void * node;
+  int    kind;
+  int    pos;
+} PCListFrame;
+
+struct PCListIter_struct
+{
+  PCListFrame * stack;
+  int           top;
+  int           cap;
+  int           backward;
+  PCListFrame   frames[PCLIST_ITER_DEPTH];
+};
+
+void     initIter      (PCListIter * it, PCList * d, int backward);
+int      iterNext      (PCListIter * it, VAL_TYPE * val);
+size_t   nextBatch     (PCListIter * it, VAL_TYPE * out, size_t n);
+void     endIter       (PCListIter * it);
+size_t   pclistToArray (PCList * d, VAL_TYPE * out, size_t n);
+
+#endif /*__PCLISTITER_H__*/
@@ -0,0 +1,175 @@
+/*--------------------------------------------------------------*
+ * pclisttransient.c - implementation of transient PCList mode  *
+ *--------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent  *
+ * data structures and their applications.                      *
+ *                                                              *
+ * Author: Josef Malík                                          *
+ *--------------------------------------------------------------*
+ */
+
+#include "pclisttransient.h"
+#include "pclistiter.h"
+#include <stdlib.h>
+
+static void flushHead (PCListTransient * t);
+static void flushTail (PCListTransient * t);
+static void fillHead  (PCListTransient * t);
+static void fillTail  (PCListTransient * t);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Starts a batch of in-place updates of given version of a list(deque).
+ * The version itself stays untouched.
+ */
+PCListTransient * pclistTransient (PCList * d)
+{
+  PCListTransient * ret = (PCListTransient *)malloc(sizeof(PCListTransient));
+  ret->head.b = ret->head.e = TRANSIENT_CHUNK;
+  ret->d = d;
+  ret->tail.b = ret->tail.e = 0;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Ends a batch of in-place updates, frees the transient and returns
+ * the resulting version of the list(deque).
+ */
+PCList * pclistPersistent (PCListTransient * t)
+{
+  flushTail(t);
+  flushHead(t);
+  PCList * ret = t->d;
+  free(t);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of values in a transient list(deque).
+ */
+size_t transientLength (PCListTransient * t)
+{
+  return (t->head.e - t->head.b) + length(t->d) + (t->tail.e - t->tail.b);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Pushes an element to a transient list(deque).
+ */
+void transientPush (PCListTransient * t, VAL_TYPE val)
+{
+  if (!t->head.b) flushHead(t);
+  t->head.vals[--t->head.b] = val;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Pops an element from a transient list(deque) (NA if it is empty).
+ */
+void transientPop (PCListTransient * t, VAL_TYPE * val)
+{
+  if (t->head.b == t->head.e) fillHead(t);
+  if (t->head.b < t->head.e) *val = t->head.vals[t->head.b++];
+  else if (t->tail.b < t->tail.e) *val = t->tail.vals[t->tail.b++];
+  else *val = NA;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Injects an element to a transient list(deque).
+ */
+void transientInject (PCListTransient * t, VAL_TYPE val)
+{
+  if (t->tail.e == TRANSIENT_CHUNK) flushTail(t);
+  t->tail.vals[t->tail.e++] = val;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Ejects an element from a transient list(deque) (NA if it is empty).
+ */
+void transientEject (PCListTransient * t, VAL_TYPE * val)
+{
+  if (t->tail.b == t->tail.e) fillTail(t);
+  if (t->tail.b < t->tail.e) *val = t->tail.vals[--t->tail.e];
+  else if (t->head.b < t->head.e) *val = t->head.vals[--t->head.e];
+  else *val = NA;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Appends a (persistent) list(deque) to a transient one.
+ */
+void transientCatenate (PCListTransient * t, PCList * d)
+{
+  flushTail(t);
+  t->d = catenate(t->d, d);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves the values of the head window to the front of the list(deque) as one chunk.
+ */
+static void flushHead (PCListTransient * t)
+{
+  t->d = pushMany(t->d, &t->head.vals[t->head.b], t->head.e - t->head.b);
+  t->head.b = t->head.e = TRANSIENT_CHUNK;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves the values of the tail window to the back of the list(deque) as one chunk.
+ */
+static void flushTail (PCListTransient * t)
+{
+  t->d = injectMany(t->d, &t->tail.vals[t->tail.b], t->tail.e - t->tail.b);
+  t->tail.b = t->tail.e = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves a chunk of values from the front of the list(deque) to the (empty) head window.
+ */
+static void fillHead (PCListTransient * t)
+{
+  size_t k = length(t->d);
+  if (!k) return;
+  if (k > TRANSIENT_CHUNK) k = TRANSIENT_CHUNK;
+  PCList * left;
+  splitAt(t->d, k, &left, &t->d);
+  t->head.b = TRANSIENT_CHUNK - (int)k;
+  t->head.e = TRANSIENT_CHUNK;
+  pclistToArray(left, &t->head.vals[t->head.b], k);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves a chunk of values from the back of the list(deque) to the (empty) tail window.
+ */
+static void fillTail (PCListTransient * t)
+{
+  size_t k = length(t->d);
+  if (!k) return;
+  if (k > TRANSIENT_CHUNK) k = TRANSIENT_CHUNK;
+  PCList * right;
+  splitAt(t->d, length(t->d) - k, &t->d, &right);
+  t->tail.b = 0;
+  t->tail.e = (int)k;
+  pclistToArray(right, t->tail.vals, k);
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,48 @@
+/*-------------------------------------------------------------*
+ * pclisttransient.h - header for transient updates of PCList  *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PCLISTTRANSIENT_H__
+#define __PCLISTTRANSIENT_H__
+
+#include <stddef.h>
+#include "common.h"
+#include "pclist.h"
+
+/* Number of values a transient keeps at each end of its list(deque) */
+#define TRANSIENT_CHUNK 256
+
+/* Values at one end of a transient, the ones between b and e are in use */
+typedef struct
+{
+  VAL_TYPE vals[TRANSIENT_CHUNK];
+  int      b;
+  int      e;
+} PCListWindow;
+
+/* A list(deque) under a batch of in-place updates -- values at both ends are
+   updated in place in the windows, the persistent list(deque) in between
+   is changed by whole chunks only */
+struct PCListTransient_struct
+{
+  PCListWindow   head;
+  PCList       * d;
+  PCListWindow   tail;
+};
+
+PCListTransient * pclistTransient   (PCList * d);
+PCList          * pclistPersistent  (PCListTransient * t);
+size_t            transientLength   (PCListTransient * t);
+void              transientPush     (PCListTransient * t, VAL_TYPE val);
+void              transientPop      (PCListTransient * t, VAL_TYPE * val);
+void              transientInject   (PCListTransient * t, VAL_TYPE val);
+void              transientEject    (PCListTransient * t, VAL_TYPE * val);
+void              transientCatenate (PCListTransient * t, PCList * d);
+
+#endif /*__PCLISTTRANSIENT_H__*/
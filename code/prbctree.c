@@ -0,0 +1,396 @@
+/*-------------------------------------------------------------*
+ * prbctree.c - implementation of compact confluently          *
+ *              persistent red-black trees                     *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * The updates are the ones of prbtree.c (see prbtemplate.h), only the nodes
+ * live in slabs of a global pool and refer to each other by 32-bit indices.
+ * A node takes 16 bytes instead of 32, so twice as many of them fit into the cache.
+ * Every thread takes chunks of fresh indices by one atomic addition and keeps its
+ * own free list linked by the left links, so threads do not wait for each other.
+ * Surplus freed nodes go to a shared list in batches, which is locked only once
+ * per CHUNK_SIZE allocations or frees.
+ */
+
+#include "prbctree.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Number of nodes of one slab (2^SLAB_BITS) */
+#define SLAB_BITS 16
+#define SLAB_SIZE (1u << SLAB_BITS)
+
+/* Number of slabs (indices have 31 bits) */
+#define SLAB_COUNT (1u << (31 - SLAB_BITS))
+
+/* Number of indices taken by a thread at once (a chunk never spans two slabs) */
+#define CHUNK_SIZE 256
+
+/* Slab with given number, slabs are published by a release store (see makeSlab) */
+#define SLAB(s) (__atomic_load_n(&slabs[s], __ATOMIC_ACQUIRE))
+
+/* Node with given index */
+#define N(i) (SLAB((i) >> SLAB_BITS)[(i) & (SLAB_SIZE - 1)])
+
+/* The first slab holds the sentinel at index 0 (it is never written to) */
+static PRBCNode slab0[SLAB_SIZE] = {{CNULL, CNULL, BLACK, NA, 0}};
+
+/* Slabs of nodes, they are allocated on demand and never moved */
+static PRBCNode * slabs[SLAB_COUNT] = {slab0};
+
+/* State of the pool -- next chunk never used and number of live nodes (both atomic) */
+static uint32_t next_chunk = 0;
+static size_t   live = 0;
+
+/* Batches of free nodes given up by threads -- heads of batches are linked by the right
+   links and hold the number of nodes of their batch in refs */
+static PRBCRef         shared_free = CNULL;
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Free list of the running thread and the unused rest [chunk_next, chunk_end) of its chunk */
+static __thread PRBCRef  local_free = CNULL;
+static __thread uint32_t local_cnt = 0;
+static __thread uint32_t chunk_next = 0;
+static __thread uint32_t chunk_end = 0;
+static __thread int      watched = 0;
+
+/* Key whose destructor gives the nodes of an exiting thread back */
+static pthread_key_t  exit_key;
+static pthread_once_t exit_once = PTHREAD_ONCE_INIT;
+
+static void       makeExitKey (void);
+static void       watchThread (void);
+static void       exitThread  (void * unused);
+static void       makeSlab    (uint32_t s);
+static void       pushBatch   (PRBCRef head, uint32_t cnt);
+static void       refill      (void);
+static PRBCRef    makeNode    (VAL_TYPE x);
+static PRBCRef    cloneNode   (PRBCRef x);
+static inline int isNull      (PRBCRef x);
+static void       freeNode    (PRBCRef x);
+static void       releaseNode (PRBCRef x);
+static void       commitNode  (PRBCRef x);
+static int        insertNode  (PRBCTree * tnew, VAL_TYPE x);
+
+/* Updates of the trees (see prbtemplate.h) */
+#define PRBT_FN(x)      x
+#define PRBT_TREE       PRBCTree
+#define PRBT_REF        PRBCRef
+#define PRBT_PATH       PRBCPath
+#define PRBT_NULL       CNULL
+#define PRBT_LEFT(x)    N(x).left
+#define PRBT_RIGHT(x)   N(x).right
+#define PRBT_COLOUR(x)  N(x).colour
+#define PRBT_KEY_T      VAL_TYPE
+#define PRBT_KEY(x)     N(x).content
+#define PRBT_MOVE(x, y) (N(x).content = N(y).content)
+#define PRBT_CLONE(x)   cloneNode(x)
+#define PRBT_FREE(x)    freeNode(x)
+#include "prbtemplate.h"
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates an empty compact persistent red-black tree.
+ */
+PRBCTree * makeCompactTree (void)
+{
+  PRBCTree * ret = (PRBCTree *)malloc(sizeof(PRBCTree));
+  ret->root = CNULL;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree formed by inserting given value to given tree.
+ */
+PRBCTree * compactInsert (PRBCTree * t, VAL_TYPE x)
+{
+  PRBCTree * tnew = makeCompactTree();
+  tnew->root = t->root;
+  insertNode(tnew, x);
+  commitNode(tnew->root);
+  return tnew;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree formed by deleting given value from given tree.
+ */
+PRBCTree * compactErase (PRBCTree * t, VAL_TYPE x)
+{
+  PRBCTree * tnew = makeCompactTree();
+  tnew->root = t->root;
+  eraseNode(tnew, x);
+  commitNode(tnew->root);
+  return tnew;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether given tree contains certain value or not.
+ */
+int compactFind (PRBCTree * t, VAL_TYPE x)
+{
+  PRBCRef cur = t->root;
+  while (!isNull(cur))
+  {
+    if (x < N(cur).content) cur = N(cur).left;
+    else if (x > N(cur).content) cur = N(cur).right;
+    else return 1;
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Releases given version of a tree (see releaseTree).
+ */
+void releaseCompactTree (PRBCTree * t)
+{
+  if (!t) return;
+  releaseNode(t->root);
+  free(t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of bytes taken by live nodes of all compact trees.
+ */
+size_t compactTreeBytes (void)
+{
+  return __atomic_load_n(&live, __ATOMIC_RELAXED) * sizeof(PRBCNode);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates the key, whose destructor runs at the exit of a thread which took nodes.
+ */
+static void makeExitKey (void)
+{
+  pthread_key_create(&exit_key, exitThread);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Makes sure the nodes of the running thread are given back when it exits.
+ */
+static void watchThread (void)
+{
+  if (watched) return;
+  pthread_once(&exit_once, makeExitKey);
+  pthread_setspecific(exit_key, &exit_key);
+  watched = 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Gives the free list and the rest of the chunk of an exiting thread to other threads.
+ */
+static void exitThread (void * unused)
+{
+  (void)unused;
+  for (uint32_t i = chunk_next; i < chunk_end; i++)
+  {
+    N(i).left = local_free;
+    local_free = i;
+    local_cnt++;
+  }
+  chunk_next = chunk_end = 0;
+  watched = 0;
+  if (local_free != CNULL) pushBatch(local_free, local_cnt);
+  local_free = CNULL;
+  local_cnt = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Allocates the slab with given number unless another thread did. The slab is published
+ * by a release store, so that readers of its nodes (see N) see it initialized.
+ */
+static void makeSlab (uint32_t s)
+{
+  if (SLAB(s)) return;
+  PRBCNode * slab = (PRBCNode *)malloc(sizeof(PRBCNode) * SLAB_SIZE);
+  PRBCNode * expected = NULL;
+  if (!slab) abort();
+  if (!__atomic_compare_exchange_n(&slabs[s], &expected, slab, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    free(slab);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Adds a list of cnt free nodes (linked by the left links) to the shared batches.
+ */
+static void pushBatch (PRBCRef head, uint32_t cnt)
+{
+  N(head).refs = cnt;
+  pthread_mutex_lock(&shared_lock);
+  N(head).right = shared_free;
+  shared_free = head;
+  pthread_mutex_unlock(&shared_lock);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Fills the empty free list of the running thread by a shared batch, or takes
+ * a new chunk of indices when there is none.
+ */
+static void refill (void)
+{
+  watchThread();
+  pthread_mutex_lock(&shared_lock);
+  PRBCRef head = shared_free;
+  if (head != CNULL) shared_free = N(head).right;
+  pthread_mutex_unlock(&shared_lock);
+  if (head != CNULL)
+  {
+    local_free = head;
+    local_cnt = N(head).refs;
+    return;
+  }
+  uint32_t chunk = __atomic_fetch_add(&next_chunk, 1, __ATOMIC_RELAXED);
+  if (chunk >= SLAB_COUNT * (SLAB_SIZE / CHUNK_SIZE)) abort(); //all 2^31 indices are used
+  makeSlab(chunk * CHUNK_SIZE >> SLAB_BITS);
+  chunk_next = chunk ? chunk * CHUNK_SIZE : 1;
+  chunk_end = (chunk + 1) * CHUNK_SIZE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a node (with given value) in the pool and returns its index.
+ */
+static PRBCRef makeNode (VAL_TYPE x)
+{
+  PRBCRef ret;
+  if (local_free == CNULL && chunk_next == chunk_end) refill();
+  if (local_free != CNULL)
+  {
+    ret = local_free;
+    local_free = N(ret).left;
+    local_cnt--;
+  }
+  else ret = chunk_next++;
+  __atomic_add_fetch(&live, 1, __ATOMIC_RELAXED);
+  N(ret).left = CNULL;
+  N(ret).right = CNULL;
+  N(ret).colour = BLACK;
+  N(ret).content = x;
+  N(ret).refs = 0;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a copy of given node, a node created by the running update is returned as it is (see cloneNode).
+ */
+static PRBCRef cloneNode (PRBCRef x)
+{
+  if (isNull(x)) return CNULL;
+  if (__atomic_load_n(&N(x).refs, __ATOMIC_RELAXED) == 0) return x;
+  PRBCRef ret = makeNode(N(x).content);
+  N(ret).colour = N(x).colour;
+  N(ret).left = N(x).left;
+  N(ret).right = N(x).right;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether a node is the null leaf node.
+ */
+static inline int isNull (PRBCRef x)
+{
+  return x == CNULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Gives given node back to the pool (the node must not be referenced). A thread keeps
+ * at most 2 * CHUNK_SIZE free nodes, a batch of CHUNK_SIZE of them is shared beyond that.
+ */
+static void freeNode (PRBCRef x)
+{
+  if (local_free == CNULL) watchThread();
+  N(x).left = local_free;
+  local_free = x;
+  __atomic_sub_fetch(&live, 1, __ATOMIC_RELAXED);
+  if (++local_cnt < 2 * CHUNK_SIZE) return;
+  PRBCRef last = local_free;
+  for (int i = 1; i < CHUNK_SIZE; i++) last = N(last).left;
+  PRBCRef head = local_free;
+  local_free = N(last).left;
+  local_cnt -= CHUNK_SIZE;
+  N(last).left = CNULL;
+  pushBatch(head, CHUNK_SIZE);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Drops a reference to given node, unshared nodes are freed recursively (see releaseNode).
+ */
+static void releaseNode (PRBCRef x)
+{
+  if (isNull(x)) return;
+  if (__atomic_sub_fetch(&N(x).refs, 1, __ATOMIC_ACQ_REL)) return;
+  releaseNode(N(x).left);
+  releaseNode(N(x).right);
+  freeNode(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Publishes the nodes created by an update (see commitNode).
+ */
+static void commitNode (PRBCRef x)
+{
+  if (isNull(x)) return;
+  if (__atomic_load_n(&N(x).refs, __ATOMIC_RELAXED))
+  {
+    __atomic_add_fetch(&N(x).refs, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  N(x).refs = 1;
+  commitNode(N(x).left);
+  commitNode(N(x).right);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Inserts given value to a new version of a tree, which is not published yet. Nodes of other
+ * versions on the access path are copied, the ones created by the running update are reused.
+ * Returns whether the value was inserted (it was not in the tree).
+ */
+static int insertNode (PRBCTree * tnew, VAL_TYPE x)
+{
+  PRBCPath path;
+  if (findPath(tnew, x, &path)) return 0;
+  insertFixup(tnew, insertTreePers(tnew, makeNode(x), &path), &path);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
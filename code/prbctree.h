@@ -0,0 +1,47 @@
+/*-------------------------------------------------------------*
+ * prbctree.h - header for compact confluently persistent      *
+ *              red-black trees (nodes linked by indices)      *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PRBCTREE_H__
+#define __PRBCTREE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "common.h"
+
+/* Reference to a node -- its index to the slabs of nodes (0 is the sentinel) */
+typedef uint32_t PRBCRef;
+
+/* Index of the sentinel node representing NULL */
+#define CNULL 0
+
+/* Node of 16 bytes -- the colour is kept in the spare top bit of the right link */
+struct PRBCNode_struct
+{
+  uint32_t left;
+  uint32_t right  : 31;
+  uint32_t colour : 1;
+  VAL_TYPE content;
+  uint32_t refs;
+};
+
+struct PRBCTree_struct
+{
+  PRBCRef root;
+};
+
+PRBCTree * makeCompactTree    (void);
+PRBCTree * compactInsert      (PRBCTree * t, VAL_TYPE x);
+PRBCTree * compactErase       (PRBCTree * t, VAL_TYPE x);
+int        compactFind        (PRBCTree * t, VAL_TYPE x);
+void       releaseCompactTree (PRBCTree * t);
+size_t     compactTreeBytes   (void);
+
+#endif /*__PRBCTREE_H__*/
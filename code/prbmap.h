@@ -0,0 +1,295 @@
+/*-------------------------------------------------------------*
+ * prbmap.h - template of persistent ordered maps (red-black   *
+ *            trees with keys and values of given types)       *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * The file is included once per specialization, with these macros defined:
+ *
+ *   PRBMAP_NAME       name of the map type, also the prefix of its functions
+ *   PRBMAP_KEY        type of keys
+ *   PRBMAP_VALUE      type of values
+ *   PRBMAP_LESS(a, b) comparison of keys (optional, < by default)
+ *   PRBMAP_IMPL       defined in exactly one translation unit, which then
+ *                     gets the definitions of the functions
+ *
+ * For PRBMAP_NAME IntMap it declares types IntMap, IntMapNode and functions
+ * IntMapMake, IntMapUpsert, IntMapErase, IntMapGet and IntMapRelease,
+ * which work the same way as the ones of PRBTree (the updates are the ones
+ * of prbtemplate.h). The macros are undefined at the end, so that the file
+ * can be included again for another specialization.
+ */
+
+#include <stddef.h>
+#include "common.h"
+
+#ifndef PRBMAP_LESS
+#define PRBMAP_LESS(a, b) ((a) < (b))
+#endif
+
+#define PRBMAP_CAT(a, b)  a ## b
+#define PRBMAP_XCAT(a, b) PRBMAP_CAT(a, b)
+#define FN(x)             PRBMAP_XCAT(PRBMAP_NAME, x)
+#define RB(x)             PRBMAP_XCAT(PRBMAP_XCAT(PRBMAP_NAME, _), x)
+#define MAP_T             PRBMAP_NAME
+#define NODE_T            FN(Node)
+#define PATH_T            FN(Path)
+#define KEY_T             PRBMAP_KEY
+#define VALUE_T           PRBMAP_VALUE
+#define NIL               (&FN(Sentinel))
+
+typedef struct PRBMAP_XCAT(PRBMAP_NAME, _node) NODE_T;
+
+struct PRBMAP_XCAT(PRBMAP_NAME, _node)
+{
+  NODE_T * left;
+  NODE_T * right;
+  int      colour;
+  int      refs;
+  KEY_T    key;
+  VALUE_T  value;
+};
+
+typedef struct
+{
+  NODE_T * root;
+} MAP_T;
+
+/* Sentinel node representing NULL of the map */
+extern NODE_T FN(Sentinel);
+
+MAP_T         * FN(Make)    (void);
+MAP_T         * FN(Upsert)  (MAP_T * t, KEY_T k, VALUE_T v);
+MAP_T         * FN(Erase)   (MAP_T * t, KEY_T k);
+const VALUE_T * FN(Get)     (MAP_T * t, KEY_T k);
+void            FN(Release) (MAP_T * t);
+
+#ifdef PRBMAP_IMPL
+
+#include <stdlib.h>
+
+NODE_T FN(Sentinel) = {.left = &FN(Sentinel), .right = &FN(Sentinel), .colour = BLACK, .refs = 0};
+
+static int        FN(InsertNode)  (MAP_T * tnew, KEY_T x, VALUE_T v);
+static NODE_T   * FN(MakeNode)    (KEY_T k, VALUE_T v);
+static NODE_T   * FN(CloneNode)   (NODE_T * x);
+static inline int FN(IsNull)      (NODE_T * x);
+static void       FN(FreeNode)    (NODE_T * x);
+static void       FN(ReleaseNode) (NODE_T * x);
+static void       FN(CommitNode)  (NODE_T * x);
+
+/* Updates of the maps (see prbtemplate.h) */
+#define PRBT_FN(x)      RB(x)
+#define PRBT_TREE       MAP_T
+#define PRBT_REF        NODE_T *
+#define PRBT_PATH       PATH_T
+#define PRBT_NULL       NIL
+#define PRBT_LEFT(x)    ((x)->left)
+#define PRBT_RIGHT(x)   ((x)->right)
+#define PRBT_COLOUR(x)  ((x)->colour)
+#define PRBT_KEY_T      KEY_T
+#define PRBT_KEY(x)     ((x)->key)
+#define PRBT_LESS(a, b) PRBMAP_LESS(a, b)
+#define PRBT_MOVE(x, y) ((x)->key = (y)->key, (x)->value = (y)->value)
+#define PRBT_CLONE(x)   FN(CloneNode)(x)
+#define PRBT_FREE(x)    FN(FreeNode)(x)
+#include "prbtemplate.h"
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates an empty persistent map.
+ */
+MAP_T * FN(Make) (void)
+{
+  MAP_T * ret = (MAP_T *)malloc(sizeof(MAP_T));
+  ret->root = NIL;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a map formed by setting the value of given key (inserting the key if it is not there).
+ * The access path is copied once in both cases.
+ */
+MAP_T * FN(Upsert) (MAP_T * t, KEY_T k, VALUE_T v)
+{
+  MAP_T * tnew = FN(Make)();
+  tnew->root = t->root;
+  FN(InsertNode)(tnew, k, v);
+  FN(CommitNode)(tnew->root);
+  return tnew;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a map formed by deleting given key from given map.
+ */
+MAP_T * FN(Erase) (MAP_T * t, KEY_T k)
+{
+  MAP_T * tnew = FN(Make)();
+  tnew->root = t->root;
+  RB(eraseNode)(tnew, k);
+  FN(CommitNode)(tnew->root);
+  return tnew;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a pointer to the value of given key (NULL if the key is not in the map).
+ * The value belongs to the version and stays valid as long as the version is not released.
+ */
+const VALUE_T * FN(Get) (MAP_T * t, KEY_T k)
+{
+  NODE_T * cur = t->root;
+  while (!FN(IsNull)(cur))
+  {
+    if (PRBMAP_LESS(k, cur->key)) cur = cur->left;
+    else if (PRBMAP_LESS(cur->key, k)) cur = cur->right;
+    else return &cur->value;
+  }
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Releases given version of a map (see releaseTree).
+ */
+void FN(Release) (MAP_T * t)
+{
+  if (!t) return;
+  FN(ReleaseNode)(t->root);
+  free(t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Inserts given key with given value to a new version of a map, which is not published yet.
+ * Nodes of other versions on the access path are copied, the ones created by the running
+ * update are reused. The value of a key which is already there is replaced.
+ * Returns whether the key was inserted (it was not in the map).
+ */
+static int FN(InsertNode) (MAP_T * tnew, KEY_T x, VALUE_T v)
+{
+  PATH_T path;
+  if (RB(findPath)(tnew, x, &path))
+  {
+    //the key is there -- only its value is replaced in the copy of the path
+    RB(copyPath)(tnew, &path);
+    path.list[path.cnt - 1]->value = v;
+    return 0;
+  }
+  RB(insertFixup)(tnew, RB(insertTreePers)(tnew, FN(MakeNode)(x, v), &path), &path);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a node of a map with given key and value.
+ */
+static NODE_T * FN(MakeNode) (KEY_T k, VALUE_T v)
+{
+  NODE_T * ret = (NODE_T *)malloc(sizeof(NODE_T));
+  ret->left = NIL;
+  ret->right = NIL;
+  ret->colour = BLACK;
+  ret->refs = 0;
+  ret->key = k;
+  ret->value = v;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a copy of given node, a node created by the running update is returned as it is (see cloneNode).
+ */
+static NODE_T * FN(CloneNode) (NODE_T * x)
+{
+  if (FN(IsNull)(x)) return NIL;
+  if (__atomic_load_n(&x->refs, __ATOMIC_RELAXED) == 0) return x;
+  NODE_T * ret = FN(MakeNode)(x->key, x->value);
+  ret->colour = x->colour;
+  ret->left = x->left;
+  ret->right = x->right;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether a node is the null leaf node of the map.
+ */
+static inline int FN(IsNull) (NODE_T * x)
+{
+  return x == NIL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Gives given node back to the allocator (the node must not be referenced).
+ */
+static void FN(FreeNode) (NODE_T * x)
+{
+  free(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Drops a reference to given node, unshared nodes are freed recursively (see releaseNode).
+ */
+static void FN(ReleaseNode) (NODE_T * x)
+{
+  if (FN(IsNull)(x)) return;
+  if (__atomic_sub_fetch(&x->refs, 1, __ATOMIC_ACQ_REL)) return;
+  FN(ReleaseNode)(x->left);
+  FN(ReleaseNode)(x->right);
+  FN(FreeNode)(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Publishes the nodes created by an update (see commitNode).
+ */
+static void FN(CommitNode) (NODE_T * x)
+{
+  if (FN(IsNull)(x)) return;
+  if (__atomic_load_n(&x->refs, __ATOMIC_RELAXED))
+  {
+    __atomic_add_fetch(&x->refs, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  x->refs = 1;
+  FN(CommitNode)(x->left);
+  FN(CommitNode)(x->right);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#endif /*PRBMAP_IMPL*/
+
+#undef PRBMAP_NAME
+#undef PRBMAP_KEY
+#undef PRBMAP_VALUE
+#undef PRBMAP_LESS
+#undef FN
+#undef RB
+#undef MAP_T
+#undef NODE_T
+#undef PATH_T
+#undef KEY_T
+#undef VALUE_T
+#undef NIL
@@ -0,0 +1,459 @@
+/*-------------------------------------------------------------*
+ * prbtemplate.h - template of updates of confluently          *
+ *                 persistent red-black trees                  *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * The file holds the path copying insertion and deletion shared by all kinds
+ * of red-black trees (prbtree.c, prbctree.c and prbmap.h), which differ only
+ * in how nodes are referenced and allocated. It is included by a translation
+ * unit, which then gets static definitions of the functions, with these
+ * macros defined:
+ *
+ *   PRBT_FN(x)      name of the function x of the specialization
+ *   PRBT_TREE       type of trees (with a member root)
+ *   PRBT_REF        type of references to nodes
+ *   PRBT_PATH       name of the type of access paths declared here
+ *   PRBT_NULL       reference to the sentinel node representing NULL
+ *   PRBT_LEFT(x)    left link of a node (an lvalue)
+ *   PRBT_RIGHT(x)   right link of a node (an lvalue)
+ *   PRBT_COLOUR(x)  colour of a node (an lvalue)
+ *   PRBT_KEY_T      type of keys
+ *   PRBT_KEY(x)     key of a node
+ *   PRBT_LESS(a, b) comparison of keys (optional, < by default)
+ *   PRBT_MOVE(x, y) copies the key (and the value) of node y to node x
+ *   PRBT_CLONE(x)   copy of a node for the running update (see cloneNode)
+ *   PRBT_FREE(x)    gives a node which is not referenced back to the allocator
+ *
+ * An insertion is findPath, then insertTreePers with a new node and insertFixup,
+ * a deletion is eraseNode. The nodes are published by the includer afterwards.
+ * The macros are undefined at the end.
+ */
+
+#ifndef PRBT_LESS
+#define PRBT_LESS(a, b) ((a) < (b))
+#endif
+
+#define LEFT(x)    PRBT_LEFT(x)
+#define RIGHT(x)   PRBT_RIGHT(x)
+#define COLOUR(x)  PRBT_COLOUR(x)
+#define IS_NULL(x) ((x) == PRBT_NULL)
+
+/* List of predecessors of one update (long enough for a tree with 2^99 nodes) */
+typedef struct
+{
+  PRBT_REF list[100];
+  int      cnt;
+} PRBT_PATH;
+
+static int             PRBT_FN(findPath)        (PRBT_TREE * t, PRBT_KEY_T x, PRBT_PATH * path);
+static void            PRBT_FN(copyPath)        (PRBT_TREE * t, PRBT_PATH * path);
+static PRBT_REF        PRBT_FN(insertTreePers)  (PRBT_TREE * t, PRBT_REF x, PRBT_PATH * path);
+static void            PRBT_FN(insertFixup)     (PRBT_TREE * tnew, PRBT_REF cur, PRBT_PATH * path);
+static int             PRBT_FN(eraseNode)       (PRBT_TREE * tnew, PRBT_KEY_T x);
+static void            PRBT_FN(cloneChild)      (PRBT_REF x, PRBT_REF y);
+static void            PRBT_FN(rotateLeft)      (PRBT_REF x, PRBT_REF y, PRBT_REF z, PRBT_TREE * t);
+static void            PRBT_FN(rotateRight)     (PRBT_REF x, PRBT_REF y, PRBT_REF z, PRBT_TREE * t);
+static void            PRBT_FN(relinkOutParent) (PRBT_REF x, PRBT_REF y, PRBT_REF z, PRBT_TREE * t);
+static inline PRBT_REF PRBT_FN(parent)          (PRBT_PATH * path);
+static inline PRBT_REF PRBT_FN(gparent)         (PRBT_PATH * path);
+static inline PRBT_REF PRBT_FN(ggparent)        (PRBT_PATH * path);
+static inline PRBT_REF PRBT_FN(uncle)           (PRBT_PATH * path);
+static inline PRBT_REF PRBT_FN(sibling)         (PRBT_PATH * path, PRBT_REF x);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Descends from the root towards given key and records every visited node in given path
+ * (after the sentinel standing for the parent of the root).
+ * Returns whether the key was found (the node containing it is then the last one recorded).
+ */
+static int PRBT_FN(findPath) (PRBT_TREE * t, PRBT_KEY_T x, PRBT_PATH * path)
+{
+  path->cnt = 0;
+  path->list[path->cnt++] = PRBT_NULL;
+  PRBT_REF cur = t->root;
+  while (!IS_NULL(cur))
+  {
+    path->list[path->cnt++] = cur;
+    if (PRBT_LESS(x, PRBT_KEY(cur))) cur = LEFT(cur);
+    else if (PRBT_LESS(PRBT_KEY(cur), x)) cur = RIGHT(cur);
+    else return 1;
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Copies the access path recorded by findPath to given tree, so that the path
+ * then lists the new copies and the original tree remains untouched.
+ */
+static void PRBT_FN(copyPath) (PRBT_TREE * t, PRBT_PATH * path)
+{
+  if (path->cnt < 2) return;
+  t->root = path->list[1] = PRBT_CLONE(path->list[1]);
+  for (int i = 2; i < path->cnt; i++)
+  {
+    PRBT_REF y = path->list[i - 1];
+    if (path->list[i] == LEFT(y)) path->list[i] = LEFT(y) = PRBT_CLONE(LEFT(y));
+    else path->list[i] = RIGHT(y) = PRBT_CLONE(RIGHT(y));
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * This function adds given new node to a right place along with copying whole access path.
+ * The addition is thus performed on a new copy (given tree). The path must be recorded by findPath.
+ * Returns the new node.
+ */
+static PRBT_REF PRBT_FN(insertTreePers) (PRBT_TREE * t, PRBT_REF x, PRBT_PATH * path)
+{
+  PRBT_FN(copyPath)(t, path);
+  PRBT_REF prev = path->list[path->cnt - 1];
+  if (!IS_NULL(prev))
+  {
+    if (PRBT_LESS(PRBT_KEY(x), PRBT_KEY(prev))) LEFT(prev) = x;
+    else RIGHT(prev) = x;
+  }
+  else t->root = x; //inserting to an empty tree
+  return x;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Restores the red-black properties of a new version of a tree, which is not published yet,
+ * after given node was added by insertTreePers. Nodes of other versions which change
+ * are copied, the ones created by the running update are reused.
+ */
+static void PRBT_FN(insertFixup) (PRBT_TREE * tnew, PRBT_REF cur, PRBT_PATH * path)
+{
+  COLOUR(cur) = RED;
+  while (COLOUR(cur) == RED && cur != tnew->root && COLOUR(PRBT_FN(parent)(path)) == RED)
+  {
+    if (LEFT(PRBT_FN(gparent)(path)) == PRBT_FN(parent)(path))
+    {
+      if (!IS_NULL(PRBT_FN(uncle)(path)) && COLOUR(PRBT_FN(uncle)(path)) == RED)
+      {
+        COLOUR(PRBT_FN(parent)(path)) = BLACK;
+        COLOUR(PRBT_FN(gparent)(path)) = RED;
+        PRBT_FN(cloneChild)(PRBT_FN(uncle)(path), PRBT_FN(gparent)(path));
+        COLOUR(PRBT_FN(uncle)(path)) = BLACK;
+        cur = PRBT_FN(gparent)(path);
+        path->cnt -= 2;
+      }
+      else
+      {
+        if (cur == RIGHT(PRBT_FN(parent)(path)))
+        {
+          PRBT_FN(rotateLeft)(PRBT_FN(parent)(path), cur, PRBT_FN(gparent)(path), tnew);
+          PRBT_REF tmp = cur;
+          cur = PRBT_FN(parent)(path); //old parent at new position
+          path->list[path->cnt - 1] = tmp; //new parent
+        }
+        else
+        {
+          PRBT_FN(rotateRight)(PRBT_FN(gparent)(path), PRBT_FN(parent)(path), PRBT_FN(ggparent)(path), tnew);
+          COLOUR(PRBT_FN(parent)(path)) = BLACK;
+          COLOUR(PRBT_FN(gparent)(path)) = RED;
+          //remove grandparent from predecessors
+          path->list[path->cnt - 2] = path->list[path->cnt - 1];
+          --path->cnt;
+        }
+      }
+    }
+    else
+    {
+      if (!IS_NULL(PRBT_FN(uncle)(path)) && COLOUR(PRBT_FN(uncle)(path)) == RED)
+      {
+        COLOUR(PRBT_FN(parent)(path)) = BLACK;
+        COLOUR(PRBT_FN(gparent)(path)) = RED;
+        PRBT_FN(cloneChild)(PRBT_FN(uncle)(path), PRBT_FN(gparent)(path));
+        COLOUR(PRBT_FN(uncle)(path)) = BLACK;
+        cur = PRBT_FN(gparent)(path);
+        path->cnt -= 2;
+      }
+      else
+      {
+        if (cur == LEFT(PRBT_FN(parent)(path)))
+        {
+          PRBT_FN(rotateRight)(PRBT_FN(parent)(path), cur, PRBT_FN(gparent)(path), tnew);
+          PRBT_REF tmp = cur;
+          cur = PRBT_FN(parent)(path); //old parent at new position
+          path->list[path->cnt - 1] = tmp; //new parent
+        }
+        else
+        {
+          PRBT_FN(rotateLeft)(PRBT_FN(gparent)(path), PRBT_FN(parent)(path), PRBT_FN(ggparent)(path), tnew);
+          COLOUR(PRBT_FN(parent)(path)) = BLACK;
+          COLOUR(PRBT_FN(gparent)(path)) = RED;
+          //remove grandparent from predecessors
+          path->list[path->cnt - 2] = path->list[path->cnt - 1];
+          --path->cnt;
+        }
+      }
+    }
+  }
+  COLOUR(tnew->root) = BLACK;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Deletes given key from a new version of a tree, which is not published yet (see insertFixup).
+ * Returns whether the key was deleted (it was in the tree).
+ */
+static int PRBT_FN(eraseNode) (PRBT_TREE * tnew, PRBT_KEY_T x)
+{
+  PRBT_PATH path;
+  if (!PRBT_FN(findPath)(tnew, x, &path)) return 0;
+  PRBT_FN(copyPath)(tnew, &path);
+  PRBT_REF cur = path.list[--path.cnt];
+  if (!IS_NULL(LEFT(cur)) && !IS_NULL(RIGHT(cur)))
+  {
+    path.list[path.cnt++] = cur;
+    PRBT_REF pred = LEFT(cur) = PRBT_CLONE(LEFT(cur));
+    while (!IS_NULL(RIGHT(pred)))
+    {
+      path.list[path.cnt++] = pred;
+      pred = RIGHT(pred) = PRBT_CLONE(RIGHT(pred));
+    }
+    PRBT_MOVE(cur, pred);
+    cur = pred;
+  }
+  PRBT_REF next;
+  if (!IS_NULL(LEFT(cur))) next = LEFT(cur) = PRBT_CLONE(LEFT(cur));
+  else next = RIGHT(cur) = PRBT_CLONE(RIGHT(cur));
+  if (IS_NULL(PRBT_FN(parent)(&path))) tnew->root = next;
+  else
+  {
+    if (cur == LEFT(PRBT_FN(parent)(&path))) LEFT(PRBT_FN(parent)(&path)) = next;
+    else RIGHT(PRBT_FN(parent)(&path)) = next;
+  }
+  //the copy of removed node is not reachable from any version
+  PRBT_REF removed = cur;
+  if (COLOUR(cur) == BLACK)
+  {
+    cur = next;
+    while (COLOUR(cur) == BLACK && cur != tnew->root)
+    {
+      if (cur == LEFT(PRBT_FN(parent)(&path)))
+      {
+        if (COLOUR(PRBT_FN(sibling)(&path, cur)) == RED)
+        {
+          PRBT_FN(cloneChild)(PRBT_FN(sibling)(&path, cur), PRBT_FN(parent)(&path));
+          COLOUR(PRBT_FN(sibling)(&path, cur)) = BLACK;
+          COLOUR(PRBT_FN(parent)(&path)) = RED;
+          PRBT_REF tmp = PRBT_FN(sibling)(&path, cur);
+          PRBT_FN(rotateLeft)(PRBT_FN(parent)(&path), PRBT_FN(sibling)(&path, cur), PRBT_FN(gparent)(&path), tnew);
+          //insert new predecessor above parent
+          path.list[path.cnt] = PRBT_FN(parent)(&path);
+          path.list[path.cnt - 1] = tmp;
+          ++path.cnt;
+        }
+        if (COLOUR(LEFT(PRBT_FN(sibling)(&path, cur))) == BLACK && COLOUR(RIGHT(PRBT_FN(sibling)(&path, cur))) == BLACK)
+        {
+          PRBT_FN(cloneChild)(PRBT_FN(sibling)(&path, cur), PRBT_FN(parent)(&path));
+          COLOUR(PRBT_FN(sibling)(&path, cur)) = RED;
+          cur = PRBT_FN(parent)(&path);
+          --path.cnt;
+        }
+        else
+        {
+          if (COLOUR(RIGHT(PRBT_FN(sibling)(&path, cur))) == BLACK)
+          {
+            PRBT_FN(cloneChild)(PRBT_FN(sibling)(&path, cur), PRBT_FN(parent)(&path));
+            PRBT_FN(cloneChild)(LEFT(PRBT_FN(sibling)(&path, cur)), PRBT_FN(sibling)(&path, cur));
+            COLOUR(LEFT(PRBT_FN(sibling)(&path, cur))) = BLACK;
+            COLOUR(PRBT_FN(sibling)(&path, cur)) = RED;
+            PRBT_FN(rotateRight)(PRBT_FN(sibling)(&path, cur), LEFT(PRBT_FN(sibling)(&path, cur)), PRBT_FN(parent)(&path), tnew);
+          }
+          PRBT_FN(cloneChild)(PRBT_FN(sibling)(&path, cur), PRBT_FN(parent)(&path));
+          PRBT_FN(cloneChild)(RIGHT(PRBT_FN(sibling)(&path, cur)), PRBT_FN(sibling)(&path, cur));
+          COLOUR(PRBT_FN(sibling)(&path, cur)) = COLOUR(PRBT_FN(parent)(&path));
+          COLOUR(PRBT_FN(parent)(&path)) = BLACK;
+          COLOUR(RIGHT(PRBT_FN(sibling)(&path, cur))) = BLACK;
+          PRBT_FN(rotateLeft)(PRBT_FN(parent)(&path), PRBT_FN(sibling)(&path, cur), PRBT_FN(gparent)(&path), tnew);
+          cur = tnew->root;
+        }
+      }
+      else
+      {
+        if (COLOUR(PRBT_FN(sibling)(&path, cur)) == RED)
+        {
+          PRBT_FN(cloneChild)(PRBT_FN(sibling)(&path, cur), PRBT_FN(parent)(&path));
+          COLOUR(PRBT_FN(sibling)(&path, cur)) = BLACK;
+          COLOUR(PRBT_FN(parent)(&path)) = RED;
+          PRBT_REF tmp = PRBT_FN(sibling)(&path, cur);
+          PRBT_FN(rotateRight)(PRBT_FN(parent)(&path), PRBT_FN(sibling)(&path, cur), PRBT_FN(gparent)(&path), tnew);
+          //insert new predecessor above parent
+          path.list[path.cnt] = PRBT_FN(parent)(&path);
+          path.list[path.cnt - 1] = tmp;
+          ++path.cnt;
+        }
+        if (COLOUR(LEFT(PRBT_FN(sibling)(&path, cur))) == BLACK && COLOUR(RIGHT(PRBT_FN(sibling)(&path, cur))) == BLACK)
+        {
+          PRBT_FN(cloneChild)(PRBT_FN(sibling)(&path, cur), PRBT_FN(parent)(&path));
+          COLOUR(PRBT_FN(sibling)(&path, cur)) = RED;
+          cur = PRBT_FN(parent)(&path);
+          --path.cnt;
+        }
+        else
+        {
+          if (COLOUR(LEFT(PRBT_FN(sibling)(&path, cur))) == BLACK)
+          {
+            PRBT_FN(cloneChild)(PRBT_FN(sibling)(&path, cur), PRBT_FN(parent)(&path));
+            PRBT_FN(cloneChild)(RIGHT(PRBT_FN(sibling)(&path, cur)), PRBT_FN(sibling)(&path, cur));
+            COLOUR(RIGHT(PRBT_FN(sibling)(&path, cur))) = BLACK;
+            COLOUR(PRBT_FN(sibling)(&path, cur)) = RED;
+            PRBT_FN(rotateLeft)(PRBT_FN(sibling)(&path, cur), RIGHT(PRBT_FN(sibling)(&path, cur)), PRBT_FN(parent)(&path), tnew);
+          }
+          PRBT_FN(cloneChild)(PRBT_FN(sibling)(&path, cur), PRBT_FN(parent)(&path));
+          PRBT_FN(cloneChild)(LEFT(PRBT_FN(sibling)(&path, cur)), PRBT_FN(sibling)(&path, cur));
+          COLOUR(PRBT_FN(sibling)(&path, cur)) = COLOUR(PRBT_FN(parent)(&path));
+          COLOUR(PRBT_FN(parent)(&path)) = BLACK;
+          COLOUR(LEFT(PRBT_FN(sibling)(&path, cur))) = BLACK;
+          PRBT_FN(rotateRight)(PRBT_FN(parent)(&path), PRBT_FN(sibling)(&path, cur), PRBT_FN(gparent)(&path), tnew);
+          cur = tnew->root;
+        }
+      }
+    }
+  }
+  if (!IS_NULL(cur)) COLOUR(cur) = BLACK;
+  PRBT_FREE(removed);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Makes a copy of y's child x and automatically links it with y (see cloneSpec).
+ */
+static void PRBT_FN(cloneChild) (PRBT_REF x, PRBT_REF y)
+{
+  if (x == LEFT(y)) LEFT(y) = PRBT_CLONE(x);
+  else RIGHT(y) = PRBT_CLONE(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Performs a left rotation of given node, its right child and its parent over given tree.
+ */
+static void PRBT_FN(rotateLeft) (PRBT_REF x, PRBT_REF y, PRBT_REF z, PRBT_TREE * t)
+{
+  if (!IS_NULL(y)) RIGHT(x) = LEFT(y);
+  if (!IS_NULL(y)) LEFT(y) = x;
+  PRBT_FN(relinkOutParent)(x, y, z, t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Performs a right rotation of given node, its left child and its parent over given tree.
+ */
+static void PRBT_FN(rotateRight) (PRBT_REF x, PRBT_REF y, PRBT_REF z, PRBT_TREE * t)
+{
+  if (!IS_NULL(y)) LEFT(x) = RIGHT(y);
+  if (!IS_NULL(y)) RIGHT(y) = x;
+  PRBT_FN(relinkOutParent)(x, y, z, t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Links correctly rotated nodes with the parent node above the rotation.
+ */
+static void PRBT_FN(relinkOutParent) (PRBT_REF x, PRBT_REF y, PRBT_REF z, PRBT_TREE * t)
+{
+  if (!IS_NULL(z))
+  {
+    if (x == LEFT(z)) LEFT(z) = y;
+    else RIGHT(z) = y;
+  }
+  else t->root = y;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a parent node in current status of the bottom-up traversal.
+ */
+static inline PRBT_REF PRBT_FN(parent) (PRBT_PATH * path)
+{
+  return path->list[path->cnt - 1];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a grandparent node in current status of the bottom-up traversal.
+ */
+static inline PRBT_REF PRBT_FN(gparent) (PRBT_PATH * path)
+{
+  return path->list[path->cnt - 2];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a parent of grandparent node in current status of the bottom-up traversal.
+ */
+static inline PRBT_REF PRBT_FN(ggparent) (PRBT_PATH * path)
+{
+  return path->list[path->cnt - 3];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns an uncle node in current status of the bottom-up traversal.
+ * This function assumes that grandparent node exists at that time.
+ */
+static inline PRBT_REF PRBT_FN(uncle) (PRBT_PATH * path)
+{
+  PRBT_REF g = PRBT_FN(gparent)(path);
+  PRBT_REF p = PRBT_FN(parent)(path);
+  if (LEFT(g) == p) return RIGHT(g);
+  return LEFT(g);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a sibling node of given node.
+ * This function assumes that its parent node exists.
+ */
+static inline PRBT_REF PRBT_FN(sibling) (PRBT_PATH * path, PRBT_REF x)
+{
+  PRBT_REF p = PRBT_FN(parent)(path);
+  if (LEFT(p) == x) return RIGHT(p);
+  return LEFT(p);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#undef PRBT_FN
+#undef PRBT_TREE
+#undef PRBT_REF
+#undef PRBT_PATH
+#undef PRBT_NULL
+#undef PRBT_LEFT
+#undef PRBT_RIGHT
+#undef PRBT_COLOUR
+#undef PRBT_KEY_T
+#undef PRBT_KEY
+#undef PRBT_LESS
+#undef PRBT_MOVE
+#undef PRBT_CLONE
+#undef PRBT_FREE
+#undef LEFT
+#undef RIGHT
+#undef COLOUR
+#undef IS_NULL
@@ -9,30 +9,54 @@
  */
 
 #include "prbtree.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-/* List of predecessors (long enough for a tree with 2^99 nodes)*/
-PRBTreeNode * pList[100];
-
-/* Actual position in predecessors' list */
-int pcnt;
-
-/* Initialization of sentinel node representing NULL */
-PRBTreeNode sentinel = {RED, NA, &sentinel, &sentinel};
+/* Initialization of sentinel node representing NULL (it is never written to) */
+PRBTreeNode sentinel = {BLACK, NA, &sentinel, &sentinel, 0, 0};
 
 /* Definition of pointer to sentinel node */
 PRBTreeNode * const nullNode = &sentinel;
 
-static PRBTree            * insertTreePers  (PRBTree * t, VAL_TYPE x, PRBTreeNode ** end);
-static void                 rotateLeft      (PRBTreeNode * x, PRBTreeNode * y, PRBTreeNode * z, PRBTree * t);
-static void                 rotateRight     (PRBTreeNode * x, PRBTreeNode * y, PRBTreeNode * z, PRBTree * t);
-static void                 relinkOutParent (PRBTreeNode * x, PRBTreeNode * y, PRBTreeNode * z, PRBTree * t);
-static inline PRBTreeNode * parent          (void);
-static inline PRBTreeNode * gparent         (void);
-static inline PRBTreeNode * ggparent        (void);
-static inline PRBTreeNode * uncle           (void);
-static inline PRBTreeNode * sibling         (PRBTreeNode * x);
+/* Work description of one thread of a parallel bulk load */
+typedef struct
+{
+  const VAL_TYPE * a;
+  size_t           lo;
+  size_t           hi;
+  int              depth;
+  int              red;
+  int              threads;
+  PRBTreeNode    * ret;
+} PRBTreeBuild;
+
+/* Smallest subtree which is worth building in its own thread, it may be set at compile time (-DBUILD_PAR_MIN=n) */
+#ifndef BUILD_PAR_MIN
+#define BUILD_PAR_MIN 65536
+#endif
+
+/* Updates of the trees (see prbtemplate.h) */
+#define PRBT_FN(x)      x
+#define PRBT_TREE       PRBTree
+#define PRBT_REF        PRBTreeNode *
+#define PRBT_PATH       PRBTreePath
+#define PRBT_NULL       nullNode
+#define PRBT_LEFT(x)    ((x)->left)
+#define PRBT_RIGHT(x)   ((x)->right)
+#define PRBT_COLOUR(x)  ((x)->colour)
+#define PRBT_KEY_T      VAL_TYPE
+#define PRBT_KEY(x)     ((x)->content)
+#define PRBT_MOVE(x, y) ((x)->content = (y)->content)
+#define PRBT_CLONE(x)   cloneNode(x)
+#define PRBT_FREE(x)    freeNode(x)
+#include "prbtemplate.h"
+
+static int                  redDepth        (size_t n);
+static size_t               countLess       (PRBTree * t, VAL_TYPE x, int inclusive);
+static PRBTreeNode        * buildNodes      (const VAL_TYPE * a, size_t lo, size_t hi, int depth, int red);
+static void               * buildPar        (void * arg);
+static int                  insertNode      (PRBTree * tnew, VAL_TYPE x);
 
 /*---------------------------------------------------------------------------*/
 
@@ -48,83 +72,43 @@ PRBTree * makeTree (void)
 
 /*---------------------------------------------------------------------------*/
 
+/**
+ * Creates a tree of n values of given array, which must be sorted in ascending order
+ * without duplicates. The tree is built directly in linear time with one allocation
+ * per node -- it is perfectly balanced and only the nodes under the last full level are red.
+ */
+PRBTree * prbtreeFromSorted (const VAL_TYPE * a, size_t n)
+{
+  PRBTree * ret = makeTree();
+  ret->root = buildNodes(a, 0, n, 0, redDepth(n));
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Same as prbtreeFromSorted, but the subtrees are built by up to given number of threads.
+ */
+PRBTree * prbtreeFromSortedPar (const VAL_TYPE * a, size_t n, int threads)
+{
+  PRBTreeBuild b = {a, 0, n, 0, redDepth(n), threads, NULL};
+  buildPar(&b);
+  PRBTree * ret = makeTree();
+  ret->root = b.ret;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
 /**
  * Returns a tree formed by inserting given value to given tree.
  */
 PRBTree * insert (PRBTree * t, VAL_TYPE x)
 {
-  pcnt = 0;
-  pList[pcnt++] = nullNode;
-  if (find(t, x)) return t;
-  PRBTreeNode * cur;
-  PRBTree * tnew = insertTreePers(t, x, &cur);
-  cur->colour = RED;
-  while (cur->colour == RED && cur != tnew->root && parent()->colour == RED)
-  {
-    if (gparent()->left == parent())
-    {
-      if (!isNull(uncle()) && uncle()->colour == RED)
-      {
-        parent()->colour = BLACK;
-        gparent()->colour = RED;
-        cloneSpec(uncle(), gparent());
-        uncle()->colour = BLACK;
-        cur = gparent();
-        pcnt -= 2;
-      }
-      else
-      {
-        if (cur == parent()->right)
-        {
-          rotateLeft(parent(), cur, gparent(), tnew);
-          PRBTreeNode * tmp = cur;
-          cur = parent(); //old parent at new position
-          pList[pcnt - 1] = tmp; //new parent
-        }
-        else
-        {
-          rotateRight(gparent(), parent(), ggparent(), tnew);
-          parent()->colour = BLACK;
-          gparent()->colour = RED;
-          //remove grandparent from predecessors
-          pList[pcnt - 2] = pList[pcnt - 1];
-          --pcnt;
-        }
-      }
-    }
-    else
-    {
-      if (!isNull(uncle()) && uncle()->colour == RED)
-      {
-        parent()->colour = BLACK;
-        gparent()->colour = RED;
-        cloneSpec(uncle(), gparent());
-        uncle()->colour = BLACK;
-        cur = gparent();
-        pcnt -= 2;
-      }
-      else
-      {
-        if (cur == parent()->left)
-        {
-          rotateRight(parent(), cur, gparent(), tnew);
-          PRBTreeNode * tmp = cur;
-          cur = parent(); //old parent at new position
-          pList[pcnt - 1] = tmp; //new parent
-        }
-        else
-        {
-          rotateLeft(gparent(), parent(), ggparent(), tnew);
-          parent()->colour = BLACK;
-          gparent()->colour = RED;
-          //remove grandparent from predecessors
-          pList[pcnt - 2] = pList[pcnt - 1];
-          --pcnt;
-        }
-      }
-    }
-  }
-  tnew->root->colour = BLACK;
+  PRBTree * tnew = makeTree();
+  tnew->root = t->root;
+  insertNode(tnew, x);
+  tnew->root = commitNode(tnew->root);
   return tnew;
 }
 
@@ -135,283 +119,245 @@ PRBTree * insert (PRBTree * t, VAL_TYPE x)
  */
 PRBTree * erase (PRBTree * t, VAL_TYPE x)
 {
-  pcnt = 0;
-  pList[pcnt++] = nullNode;
-  if (!find(t, x)) return t;
   PRBTree * tnew = makeTree();
-  PRBTreeNode * cur = tnew->root = cloneNode(t->root);
-  while (cur->content != x)
-  {
-    pList[pcnt++] = cur;
-    if (x < cur->content) cur = cur->left = cloneNode(cur->left);
-    else if (x > cur->content) cur = cur->right = cloneNode(cur->right);
-  }
-  if (!isNull(cur->left) && !isNull(cur->right))
-  {
-    pList[pcnt++] = cur;
-    PRBTreeNode * pred = cur->left = cloneNode(cur->left);
-    while (!isNull(pred->right)) 
-    {
-      pList[pcnt++] = pred;
-      pred = pred->right = cloneNode(pred->right);
-    }
-    cur->content = pred->content;
-    cur = pred;
-  }
-  PRBTreeNode * next;
-  if (!isNull(cur->left)) next = cur->left = cloneNode(cur->left);
-  else next = cur->right = cloneNode(cur->right);
-  if (isNull(parent())) tnew->root = next;
-  else
-  {
-    if (cur == parent()->left) parent()->left = next;
-    else parent()->right = next;
-  }
-  if (cur->colour == BLACK)
-  {
-    cur = next;
-    while (cur->colour == BLACK && cur != tnew->root)
-    {
-      if (cur == parent()->left)
-      {
-        if (sibling(cur)->colour == RED)
-        {
-          cloneSpec(sibling(cur), parent());
-          sibling(cur)->colour = BLACK;
-          parent()->colour = RED;
-          PRBTreeNode * tmp = sibling(cur);
-          rotateLeft(parent(), sibling(cur), gparent(), tnew);
-          //insert new predecessor above parent
-          pList[pcnt] = parent();
-          pList[pcnt - 1] = tmp;
-          ++pcnt;
-        }
-        if (sibling(cur)->left->colour == BLACK && sibling(cur)->right->colour == BLACK)
-        {
-          cloneSpec(sibling(cur), parent());
-          sibling(cur)->colour = RED;
-          cur = parent();
-          --pcnt;
-        }
-        else 
-        {
-          if (sibling(cur)->right->colour == BLACK)
-          {
-            cloneSpec(sibling(cur), parent());
-            cloneSpec(sibling(cur)->left, sibling(cur));
-            sibling(cur)->left->colour = BLACK;
-            sibling(cur)->colour = RED;
-            rotateRight(sibling(cur), sibling(cur)->left, parent(), tnew);
-          }
-          cloneSpec(sibling(cur), parent());
-          cloneSpec(sibling(cur)->right, sibling(cur));
-          sibling(cur)->colour = parent()->colour;
-          parent()->colour = BLACK;
-          sibling(cur)->right->colour = BLACK;
-          rotateLeft(parent(), sibling(cur), gparent(), tnew);
-          cur = tnew->root;
-        }
-      }
-      else
-      {
-        if (sibling(cur)->colour == RED)
-        {
-          cloneSpec(sibling(cur), parent());
-          sibling(cur)->colour = BLACK;
-          parent()->colour = RED;
-          PRBTreeNode * tmp = sibling(cur);
-          rotateRight(parent(), sibling(cur), gparent(), tnew);
-          //insert new predecessor above parent
-          pList[pcnt] = parent();
-          pList[pcnt - 1] = tmp;
-          ++pcnt;
-        }
-        if (sibling(cur)->left->colour == BLACK && sibling(cur)->right->colour == BLACK)
-        {
-          cloneSpec(sibling(cur), parent());
-          sibling(cur)->colour = RED;
-          cur = parent();
-          --pcnt;
-        }
-        else 
-        {
-          if (sibling(cur)->left->colour == BLACK)
-          {
-            cloneSpec(sibling(cur), parent());
-            cloneSpec(sibling(cur)->right, sibling(cur));
-            sibling(cur)->right->colour = BLACK;
-            sibling(cur)->colour = RED;
-            rotateLeft(sibling(cur), sibling(cur)->right, parent(), tnew);
-          }
-          cloneSpec(sibling(cur), parent());
-          cloneSpec(sibling(cur)->left, sibling(cur));
-          sibling(cur)->colour = parent()->colour;
-          parent()->colour = BLACK;
-          sibling(cur)->left->colour = BLACK;
-          rotateRight(parent(), sibling(cur), gparent(), tnew);
-          cur = tnew->root;
-        }
-      }        
-    }
-  }
-  cur->colour = BLACK;
+  tnew->root = t->root;
+  eraseNode(tnew, x);
+  tnew->root = commitNode(tnew->root);
   return tnew;
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Returns whether given tree contains certain value or not.
+ * Returns a tree formed by inserting k values to given tree as one update.
+ * Nodes copied by one insertion are not published until the whole batch is done,
+ * so the following insertions update them in place -- every node is copied at most once.
+ * The batch should be sorted, so that consecutive insertions share most of their paths.
  */
-int find (PRBTree * t, VAL_TYPE x)
+PRBTree * insertBatch (PRBTree * t, const VAL_TYPE * keys, size_t k)
 {
-  PRBTreeNode * cur = t->root;
-  while (!isNull(cur))
-  {
-    if (x < cur->content) cur = cur->left;
-    else if (x > cur->content) cur = cur->right;
-    else return 1;
-  }
-  return 0;
+  PRBTree * tnew = makeTree();
+  tnew->root = t->root;
+  for (size_t i = 0; i < k; i++) insertNode(tnew, keys[i]);
+  tnew->root = commitNode(tnew->root);
+  return tnew;
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * This function adds new element to a right place along with copying whole access path.
- * The addition is thus performed on a new copy.
+ * Returns a tree formed by deleting k values from given tree as one update (see insertBatch).
  */
-static PRBTree * insertTreePers (PRBTree * t, VAL_TYPE x, PRBTreeNode ** end)
+PRBTree * eraseBatch (PRBTree * t, const VAL_TYPE * keys, size_t k)
 {
-  PRBTree * ret = makeTree();
-  PRBTreeNode * cur = ret->root = cloneNode(t->root);
-  PRBTreeNode * prev = nullNode;
-  while (!isNull(cur))
-  {
-    prev = cur;
-    pList[pcnt++] = cur;
-    if (x < cur->content) cur = cur->left = cloneNode(cur->left);
-    else if (x > cur->content) cur = cur->right = cloneNode(cur->right);
-    else return t;
-  }
-  cur = makeNode(x);
-  if (!isNull(prev))
+  PRBTree * tnew = makeTree();
+  tnew->root = t->root;
+  for (size_t i = 0; i < k; i++) eraseNode(tnew, keys[i]);
+  tnew->root = commitNode(tnew->root);
+  return tnew;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree formed by applying k insertions and deletions (in given order)
+ * to given tree as one update (see insertBatch).
+ */
+PRBTree * applyBatch (PRBTree * t, const PRBTreeOp * ops, size_t k)
+{
+  PRBTree * tnew = makeTree();
+  tnew->root = t->root;
+  for (size_t i = 0; i < k; i++)
   {
-    if (x < prev->content) prev->left = cur;
-    else if (x > prev->content) prev->right = cur; 
+    if (ops[i].kind == PRBTREE_ERASE) eraseNode(tnew, ops[i].key);
+    else insertNode(tnew, ops[i].key);
   }
-  if (isNull(ret->root)) ret->root = cur; //inserting to an empty tree
-  *end = cur;
-  return ret;
+  tnew->root = commitNode(tnew->root);
+  return tnew;
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Prints a subtree rooted at given node (by inorder traversal).
+ * Inserts given value to a new version of a tree, which is not published yet. Nodes of other
+ * versions on the access path are copied, the ones created by the running update are reused.
+ * Returns whether the value was inserted (it was not in the tree).
  */
-void printPRBTree (PRBTreeNode * a)
+static int insertNode (PRBTree * tnew, VAL_TYPE x)
 {
-  if (isNull(a)) return;
-  printPRBTree(a->left);
-  printf("%d ", a->content);
-  printPRBTree(a->right);
+  PRBTreePath path;
+  if (findPath(tnew, x, &path)) return 0;
+  insertFixup(tnew, insertTreePers(tnew, makeNode(x), &path), &path);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Releases given version of a tree. Exactly the nodes which are not shared
+ * with any other live version are freed. The handle must not be used afterwards.
+ */
+void releaseTree (PRBTree * t)
+{
+  if (!t) return;
+  releaseNode(t->root);
+  free(t);
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Performs a left rotation of given node, its right child and its parent over given tree.
+ * Returns whether given tree contains certain value or not.
  */
-static void rotateLeft (PRBTreeNode * x, PRBTreeNode * y, PRBTreeNode * z, PRBTree * t)
+int find (PRBTree * t, VAL_TYPE x)
 {
-  if (!isNull(y)) x->right = y->left;
-  if (!isNull(y)) y->left = x;
-  relinkOutParent(x, y, z, t);
+  PRBTreeNode * cur = t->root;
+  while (!isNull(cur))
+  {
+    if (x < cur->content) cur = cur->left;
+    else if (x > cur->content) cur = cur->right;
+    else return 1;
+  }
+  return 0;
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Performs a right rotation of given node, its left child and its parent over given tree.
+ * Returns the number of values of a tree which are less than x.
  */
-static void rotateRight (PRBTreeNode * x, PRBTreeNode * y, PRBTreeNode * z, PRBTree * t)
+size_t rank (PRBTree * t, VAL_TYPE x)
 {
-  if (!isNull(y)) x->left = y->right;
-  if (!isNull(y)) y->right = x;
-  relinkOutParent(x, y, z, t);
+  return countLess(t, x, 0);
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Links correctly rotated nodes with the parent node above the rotation.
+ * Returns the k-th smallest value of a tree, counted from 0 (NA if there is none).
  */
-static void relinkOutParent (PRBTreeNode * x, PRBTreeNode * y, PRBTreeNode * z, PRBTree * t)
+VAL_TYPE selectKth (PRBTree * t, size_t k)
 {
-  if (!isNull(z))
+  PRBTreeNode * cur = t->root;
+  while (!isNull(cur))
   {
-    if (x == z->left) z->left = y;
-    else z->right = y;
+    if (k < cur->left->size) cur = cur->left;
+    else if (k == cur->left->size) return cur->content;
+    else
+    {
+      k -= cur->left->size + 1;
+      cur = cur->right;
+    }
   }
-  else t->root = y;
+  return NA;
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Returns a parent node in current status of the bottom-up traversal.
+ * Returns the number of values of a tree from the interval [lo, hi].
  */
-static inline PRBTreeNode * parent (void)
+size_t countRange (PRBTree * t, VAL_TYPE lo, VAL_TYPE hi)
 {
-  return pList[pcnt - 1];
+  if (lo > hi) return 0;
+  return countLess(t, hi, 1) - countLess(t, lo, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of values of a tree which are less than x (or equal to x if inclusive is set).
+ */
+static size_t countLess (PRBTree * t, VAL_TYPE x, int inclusive)
+{
+  PRBTreeNode * cur = t->root;
+  size_t ret = 0;
+  while (!isNull(cur))
+  {
+    if (x < cur->content || (x == cur->content && !inclusive)) cur = cur->left;
+    else
+    {
+      ret += cur->left->size + 1;
+      cur = cur->right;
+    }
+  }
+  return ret;
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Returns a grandparent node in current status of the bottom-up traversal.
+ * Returns the depth of nodes, which are red in a balanced tree of n nodes
+ * (the number of its full levels).
  */
-static inline PRBTreeNode * gparent (void)
+static int redDepth (size_t n)
 {
-  return pList[pcnt - 2];
+  int h = 0;
+  while (((size_t)2 << h) - 1 <= n) h++;
+  return h;
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Returns a parent of grandparent node in current status of the bottom-up traversal.
+ * Builds a balanced subtree of values a[lo..hi-1] which is rooted at given depth.
+ * The nodes are published right away (they have their only parent).
  */
-static inline PRBTreeNode * ggparent (void)
+static PRBTreeNode * buildNodes (const VAL_TYPE * a, size_t lo, size_t hi, int depth, int red)
 {
-  return pList[pcnt - 3];
+  if (lo >= hi) return nullNode;
+  size_t mid = lo + (hi - lo) / 2;
+  PRBTreeNode * ret = makeNode(a[mid]);
+  ret->colour = depth == red ? RED : BLACK;
+  ret->left = buildNodes(a, lo, mid, depth + 1, red);
+  ret->right = buildNodes(a, mid + 1, hi, depth + 1, red);
+  ret->size = (unsigned int)(hi - lo);
+  return internNode(ret);
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Returns an uncle node in current status of the bottom-up traversal.
- * This function assumes that grandparent node exists at that time.
+ * Body of a thread of a parallel bulk load -- the left subtree is given to a new thread
+ * with half of the threads, the right one is built by the current thread.
  */
-static inline PRBTreeNode * uncle (void)
+static void * buildPar (void * arg)
 {
-  PRBTreeNode * g = gparent();
-  PRBTreeNode * p = parent();
-  if (g->left == p) return g->right;
-  return g->left;
+  PRBTreeBuild * b = (PRBTreeBuild *)arg;
+  if (b->threads < 2 || b->hi - b->lo < BUILD_PAR_MIN)
+  {
+    b->ret = buildNodes(b->a, b->lo, b->hi, b->depth, b->red);
+    return NULL;
+  }
+  size_t mid = b->lo + (b->hi - b->lo) / 2;
+  PRBTreeBuild left = {b->a, b->lo, mid, b->depth + 1, b->red, b->threads / 2, NULL};
+  PRBTreeBuild right = {b->a, mid + 1, b->hi, b->depth + 1, b->red, b->threads - b->threads / 2, NULL};
+  pthread_t th;
+  int spawned = !pthread_create(&th, NULL, buildPar, &left);
+  if (!spawned) buildPar(&left);
+  buildPar(&right);
+  if (spawned) pthread_join(th, NULL);
+  b->ret = makeNode(b->a[mid]);
+  b->ret->colour = b->depth == b->red ? RED : BLACK;
+  b->ret->left = left.ret;
+  b->ret->right = right.ret;
+  b->ret->size = (unsigned int)(b->hi - b->lo);
+  b->ret = internNode(b->ret);
+  return NULL;
 }
 
 /*---------------------------------------------------------------------------*/
 
 /**
- * Returns a sibling node of given node.
- * This function assumes that its parent node exists.
+ * Prints a subtree rooted at given node (by inorder traversal).
  */
-static inline PRBTreeNode * sibling (PRBTreeNode * x)
+void printPRBTree (PRBTreeNode * a)
 {
-  PRBTreeNode * p = parent();
-  if (p->left == x) return p->right;
-  return p->left;
+  if (isNull(a)) return;
+  printPRBTree(a->left);
+  printf("%d ", a->content);
+  printPRBTree(a->right);
 }
 
 /*---------------------------------------------------------------------------*/
+
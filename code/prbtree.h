@@ -11,6 +11,12 @@
 #ifndef __PRBTREE_H__
 #define __PRBTREE_H__
 
+/* Trees built with -DPRBTREE_BTREE are B+-trees with the basic operations only (see pbtree.h) */
+#ifdef PRBTREE_BTREE
+#include "pbtree.h"
+#else
+
+#include <stddef.h>
 #include "common.h"
 #include "prbtreenode.h"
 
@@ -19,10 +25,32 @@ struct PRBTree_struct
   PRBTreeNode * root;
 };
 
+/* Kinds of updates of a batch */
+#define PRBTREE_INSERT 0
+#define PRBTREE_ERASE  1
+
+/* One update of a batch */
+typedef struct
+{
+  int      kind;
+  VAL_TYPE key;
+} PRBTreeOp;
+
 PRBTree * makeTree     (void);
+PRBTree * prbtreeFromSorted    (const VAL_TYPE * a, size_t n);
+PRBTree * prbtreeFromSortedPar (const VAL_TYPE * a, size_t n, int threads);
 PRBTree * insert       (PRBTree * t, VAL_TYPE x);
 PRBTree * erase        (PRBTree * t, VAL_TYPE x);
+PRBTree * insertBatch  (PRBTree * t, const VAL_TYPE * keys, size_t k);
+PRBTree * eraseBatch   (PRBTree * t, const VAL_TYPE * keys, size_t k);
+PRBTree * applyBatch   (PRBTree * t, const PRBTreeOp * ops, size_t k);
 int       find         (PRBTree * t, VAL_TYPE x);
+size_t    rank         (PRBTree * t, VAL_TYPE x);
+VAL_TYPE  selectKth    (PRBTree * t, size_t k);
+size_t    countRange   (PRBTree * t, VAL_TYPE lo, VAL_TYPE hi);
+void      releaseTree  (PRBTree * t);
 void      printPRBTree (PRBTreeNode * a);
 
+#endif /*PRBTREE_BTREE*/
+
 #endif /*__PRBTREE_H__*/
@@ -0,0 +1,454 @@
+/*-------------------------------------------------------------*
+ * prbtreefat.c - implementation of partially persistent       *
+ *                red-black trees made by node copying         *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * The node-copying method of Driscoll, Sarnak, Sleator and Tarjan. Only the
+ * latest version is updated, the older ones are read-only and are selected
+ * by their numbers. A changed child link of a node is written to the spare
+ * modification slot of the node, stamped with the new version number. Only
+ * when the slot is taken already, the node is copied (with its latest links)
+ * and the copy is linked to the parent the same way, which may copy the parent
+ * as well. Every update writes O(1) links (a red-black tree needs at most three
+ * rotations per update), so it allocates O(1) nodes amortized instead of
+ * the O(log n) copies of the whole access path made by prbtree.c.
+ *
+ * There are no parent links (a node has just one parent in the latest version),
+ * the predecessors are kept on the access path, which lists only the nodes
+ * of the latest version. Colours are used by the updates only, so they are
+ * kept just for the latest version. The successor of an erased node is moved
+ * to its place, so that the contents of the nodes never change.
+ */
+
+#include "prbtreefat.h"
+#include <stdlib.h>
+
+/* Directions of child links */
+#define LEFT  0
+#define RIGHT 1
+
+/* Access path of one update -- the nodes and the directions taken from them
+   (long enough for a tree with 2^49 nodes) */
+typedef struct
+{
+  PRBFatNode  * list[100];
+  unsigned char dir[100];
+  int           cnt;
+} PRBFatPath;
+
+static PRBFatNode * makeFatNode (PRBFatTree * t, VAL_TYPE x);
+static void         newVersion  (PRBFatTree * t);
+static PRBFatNode * latest      (PRBFatNode * x, int d);
+static PRBFatNode * childAt     (PRBFatNode * x, int d, unsigned int v);
+static int          colourOf    (PRBFatNode * x);
+static PRBFatNode * setChild    (PRBFatTree * t, PRBFatNode * x, int d, PRBFatNode * y);
+static void         relink      (PRBFatTree * t, PRBFatPath * path, int i, PRBFatNode * y);
+static void         rotate      (PRBFatTree * t, PRBFatPath * path, int i, int d);
+static int          findPath    (PRBFatTree * t, VAL_TYPE x, PRBFatPath * path);
+static size_t       toArray     (PRBFatNode * x, unsigned int v, VAL_TYPE * out);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a partially persistent red-black tree with the empty version 0.
+ */
+PRBFatTree * makeFatTree (void)
+{
+  PRBFatTree * ret = (PRBFatTree *)malloc(sizeof(PRBFatTree));
+  ret->cap = 16;
+  ret->roots = (PRBFatNode **)malloc(ret->cap * sizeof(PRBFatNode *));
+  ret->sizes = (size_t *)malloc(ret->cap * sizeof(size_t));
+  ret->roots[0] = NULL;
+  ret->sizes[0] = 0;
+  ret->last = 0;
+  ret->chunks = NULL;
+  ret->nchunks = 0;
+  ret->used = FAT_CHUNK;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Inserts given value to the latest version of a tree, which makes a new version.
+ * Returns the number of the new version, or of the latest one if the value was there
+ * already (no version is made then).
+ */
+unsigned int fatInsert (PRBFatTree * t, VAL_TYPE x)
+{
+  PRBFatPath path;
+  if (findPath(t, x, &path)) return t->last;
+  newVersion(t);
+  PRBFatNode * cur = makeFatNode(t, x);
+  cur->colour = RED;
+  int i = path.cnt;
+  relink(t, &path, i, cur);
+  t->sizes[t->last]++;
+  //the parent of a red node is never the root, so the grandparent exists
+  while (i > 0 && path.list[i - 1]->colour == RED)
+  {
+    int d = path.dir[i - 2];
+    PRBFatNode * u = latest(path.list[i - 2], 1 - d);
+    if (colourOf(u) == RED)
+    {
+      path.list[i - 1]->colour = BLACK;
+      u->colour = BLACK;
+      path.list[i - 2]->colour = RED;
+      i -= 2;
+      continue;
+    }
+    //an inner grandchild is rotated outside, its old parent then takes its place on the path
+    if (path.dir[i - 1] != d) rotate(t, &path, i - 1, d);
+    path.list[i - 1]->colour = BLACK;
+    path.list[i - 2]->colour = RED;
+    rotate(t, &path, i - 2, 1 - d);
+    break;
+  }
+  t->roots[t->last]->colour = BLACK;
+  return t->last;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Deletes given value from the latest version of a tree, which makes a new version.
+ * Returns the number of the new version, or of the latest one if the value was not there
+ * (no version is made then).
+ */
+unsigned int fatErase (PRBFatTree * t, VAL_TYPE x)
+{
+  PRBFatPath path;
+  if (!findPath(t, x, &path)) return t->last;
+  newVersion(t);
+  t->sizes[t->last]--;
+  int k = path.cnt - 1, i = k;
+  PRBFatNode * cur = path.list[k];
+  int colour = cur->colour;
+  if (!latest(cur, LEFT) || !latest(cur, RIGHT))
+    relink(t, &path, k, latest(cur, latest(cur, LEFT) ? LEFT : RIGHT));
+  else
+  {
+    //the successor is unlinked and then moved to the place of the erased node
+    path.dir[k] = RIGHT;
+    PRBFatNode * succ = path.list[++i] = latest(cur, RIGHT);
+    while (latest(succ, LEFT))
+    {
+      path.dir[i] = LEFT;
+      succ = path.list[++i] = latest(succ, LEFT);
+    }
+    colour = succ->colour;
+    relink(t, &path, i, latest(succ, RIGHT));
+    cur = path.list[k];
+    succ = setChild(t, succ, RIGHT, latest(cur, RIGHT));
+    succ = setChild(t, succ, LEFT, latest(cur, LEFT));
+    succ->colour = cur->colour;
+    relink(t, &path, k, succ);
+  }
+  if (colour == RED) return t->last;
+  //the node at position i of the path (possibly null) misses one black node
+  while (i > 0 && colourOf(path.list[i]) == BLACK)
+  {
+    int d = path.dir[i - 1];
+    PRBFatNode * p = path.list[i - 1];
+    PRBFatNode * w = latest(p, 1 - d);
+    if (w->colour == RED)
+    {
+      PRBFatNode * tmp = path.list[i];
+      w->colour = BLACK;
+      p->colour = RED;
+      rotate(t, &path, i - 1, d);
+      //the sibling is a new predecessor above the parent
+      path.list[++i] = tmp;
+      path.dir[i - 1] = d;
+      p = path.list[i - 1];
+      w = latest(p, 1 - d);
+    }
+    if (colourOf(latest(w, LEFT)) == BLACK && colourOf(latest(w, RIGHT)) == BLACK)
+    {
+      w->colour = RED;
+      i--;
+      continue;
+    }
+    if (colourOf(latest(w, 1 - d)) == BLACK)
+    {
+      //the sibling is rotated as if it were on the path
+      PRBFatNode * tmp = path.list[i];
+      latest(w, d)->colour = BLACK;
+      w->colour = RED;
+      path.list[i] = w;
+      path.dir[i - 1] = 1 - d;
+      rotate(t, &path, i, 1 - d);
+      path.list[i] = tmp;
+      path.dir[i - 1] = d;
+      p = path.list[i - 1];
+      w = latest(p, 1 - d);
+    }
+    w->colour = p->colour;
+    p->colour = BLACK;
+    latest(w, 1 - d)->colour = BLACK;
+    rotate(t, &path, i - 1, d);
+    i = 0;
+  }
+  if (path.list[i]) path.list[i]->colour = BLACK;
+  return t->last;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether given version of a tree contains certain value or not.
+ */
+int fatFind (PRBFatTree * t, unsigned int v, VAL_TYPE x)
+{
+  PRBFatNode * cur = t->roots[v];
+  while (cur)
+  {
+    if (x < cur->content) cur = childAt(cur, LEFT, v);
+    else if (x > cur->content) cur = childAt(cur, RIGHT, v);
+    else return 1;
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of values of given version of a tree.
+ */
+size_t fatSize (PRBFatTree * t, unsigned int v)
+{
+  return t->sizes[v];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes the values of given version of a tree in ascending order to given array
+ * (of at least fatSize values). Returns the number of values written.
+ */
+size_t fatToArray (PRBFatTree * t, unsigned int v, VAL_TYPE * out)
+{
+  return toArray(t->roots[v], v, out);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of the latest version of a tree.
+ */
+unsigned int fatVersion (PRBFatTree * t)
+{
+  return t->last;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of bytes held by all versions of a tree.
+ */
+size_t fatTreeBytes (PRBFatTree * t)
+{
+  return sizeof(PRBFatTree) + t->cap * (sizeof(PRBFatNode *) + sizeof(size_t))
+         + t->nchunks * (FAT_CHUNK * sizeof(PRBFatNode) + sizeof(PRBFatNode *));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Releases all versions of a tree at once.
+ */
+void releaseFatTree (PRBFatTree * t)
+{
+  if (!t) return;
+  for (size_t i = 0; i < t->nchunks; i++) free(t->chunks[i]);
+  free(t->chunks);
+  free(t->roots);
+  free(t->sizes);
+  free(t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a red node of the latest version of a tree.
+ */
+static PRBFatNode * makeFatNode (PRBFatTree * t, VAL_TYPE x)
+{
+  if (t->used == FAT_CHUNK)
+  {
+    t->chunks = (PRBFatNode **)realloc(t->chunks, (t->nchunks + 1) * sizeof(PRBFatNode *));
+    t->chunks[t->nchunks++] = (PRBFatNode *)malloc(FAT_CHUNK * sizeof(PRBFatNode));
+    t->used = 0;
+  }
+  PRBFatNode * ret = &t->chunks[t->nchunks - 1][t->used++];
+  ret->content = x;
+  ret->version = t->last;
+  ret->mod_version = 0;
+  ret->mod_dir = FAT_NONE;
+  ret->colour = RED;
+  ret->child[LEFT] = NULL;
+  ret->child[RIGHT] = NULL;
+  ret->mod_child = NULL;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Starts a new version of a tree equal to the latest one.
+ */
+static void newVersion (PRBFatTree * t)
+{
+  if (t->last + 1 == t->cap)
+  {
+    t->cap *= 2;
+    t->roots = (PRBFatNode **)realloc(t->roots, t->cap * sizeof(PRBFatNode *));
+    t->sizes = (size_t *)realloc(t->sizes, t->cap * sizeof(size_t));
+  }
+  t->roots[t->last + 1] = t->roots[t->last];
+  t->sizes[t->last + 1] = t->sizes[t->last];
+  t->last++;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a child of given node in the latest version.
+ */
+static PRBFatNode * latest (PRBFatNode * x, int d)
+{
+  return x->mod_dir == d ? x->mod_child : x->child[d];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a child of given node in given version.
+ */
+static PRBFatNode * childAt (PRBFatNode * x, int d, unsigned int v)
+{
+  return x->mod_dir == d && x->mod_version <= v ? x->mod_child : x->child[d];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the colour of given node (null leaves are black).
+ */
+static int colourOf (PRBFatNode * x)
+{
+  return x ? x->colour : BLACK;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Makes y a child of given node of the latest version. A node created by the running
+ * update is changed in place, any other one gets the change to its modification slot.
+ * If the slot is taken by an older version, a copy of the node is made instead.
+ * Returns the node or its copy, which must be then linked to the parent by the caller.
+ */
+static PRBFatNode * setChild (PRBFatTree * t, PRBFatNode * x, int d, PRBFatNode * y)
+{
+  if (latest(x, d) == y) return x;
+  if (x->version == t->last)
+  {
+    x->child[d] = y;
+    return x;
+  }
+  if (x->mod_dir == FAT_NONE || (x->mod_dir == d && x->mod_version == t->last))
+  {
+    x->mod_dir = d;
+    x->mod_version = t->last;
+    x->mod_child = y;
+    return x;
+  }
+  PRBFatNode * ret = makeFatNode(t, x->content);
+  ret->colour = x->colour;
+  ret->child[LEFT] = latest(x, LEFT);
+  ret->child[RIGHT] = latest(x, RIGHT);
+  ret->child[d] = y;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Puts y to position i of the path and links it to its predecessor (or makes it
+ * the root). Copies of the predecessors are linked upwards as long as they are made.
+ */
+static void relink (PRBFatTree * t, PRBFatPath * path, int i, PRBFatNode * y)
+{
+  path->list[i] = y;
+  for (; i > 0; i--)
+  {
+    PRBFatNode * p = path->list[i - 1];
+    PRBFatNode * q = setChild(t, p, path->dir[i - 1], path->list[i]);
+    if (q == p) return;
+    path->list[i - 1] = q;
+  }
+  t->roots[t->last] = path->list[0];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Rotates the node at position i of the path in given direction (its child
+ * from the other side goes up). The path then continues from the risen
+ * child to the rotated node.
+ */
+static void rotate (PRBFatTree * t, PRBFatPath * path, int i, int d)
+{
+  PRBFatNode * x = path->list[i];
+  PRBFatNode * y = latest(x, 1 - d);
+  x = setChild(t, x, 1 - d, latest(y, d));
+  y = setChild(t, y, d, x);
+  relink(t, path, i, y);
+  path->list[i + 1] = x;
+  path->dir[i] = d;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Descends the latest version from the root towards given value and records the path.
+ * Returns whether the value was found (the node containing it is then the last one recorded),
+ * otherwise the last direction recorded leads to the place of the value.
+ */
+static int findPath (PRBFatTree * t, VAL_TYPE x, PRBFatPath * path)
+{
+  PRBFatNode * cur = t->roots[t->last];
+  path->cnt = 0;
+  while (cur)
+  {
+    path->list[path->cnt] = cur;
+    if (x == cur->content)
+    {
+      path->cnt++;
+      return 1;
+    }
+    path->dir[path->cnt++] = x > cur->content;
+    cur = latest(cur, x > cur->content);
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes the values of a subtree of given version in ascending order to given array.
+ */
+static size_t toArray (PRBFatNode * x, unsigned int v, VAL_TYPE * out)
+{
+  if (!x) return 0;
+  size_t n = toArray(childAt(x, LEFT, v), v, out);
+  out[n++] = x->content;
+  return n + toArray(childAt(x, RIGHT, v), v, out + n);
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,61 @@
+/*-------------------------------------------------------------*
+ * prbtreefat.h - header for partially persistent red-black    *
+ *                trees made by node copying (fat nodes)       *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PRBTREEFAT_H__
+#define __PRBTREEFAT_H__
+
+#include <stddef.h>
+#include "common.h"
+
+/* Number of nodes allocated at once by a tree */
+#define FAT_CHUNK 4096
+
+/* Value of the direction of an empty modification slot */
+#define FAT_NONE 2
+
+/* Node with one modification slot -- a child link changed in version mod_version
+   or later is read from mod_child instead of child[mod_dir]. The colour is
+   significant for the latest version only, which is the only one updated. */
+struct PRBFatNode_struct
+{
+  VAL_TYPE                   content;
+  unsigned int               version;
+  unsigned int               mod_version;
+  unsigned char              mod_dir;
+  unsigned char              colour;
+  struct PRBFatNode_struct * child[2];
+  struct PRBFatNode_struct * mod_child;
+};
+
+/* All versions of a tree -- the roots and sizes are indexed by version numbers
+   (version 0 is the empty tree), the nodes are owned by the tree and live in chunks */
+struct PRBFatTree_struct
+{
+  PRBFatNode  ** roots;
+  size_t       * sizes;
+  unsigned int   last;
+  unsigned int   cap;
+  PRBFatNode  ** chunks;
+  size_t         nchunks;
+  size_t         used;
+};
+
+PRBFatTree * makeFatTree    (void);
+unsigned int fatInsert      (PRBFatTree * t, VAL_TYPE x);
+unsigned int fatErase       (PRBFatTree * t, VAL_TYPE x);
+int          fatFind        (PRBFatTree * t, unsigned int v, VAL_TYPE x);
+size_t       fatSize        (PRBFatTree * t, unsigned int v);
+size_t       fatToArray     (PRBFatTree * t, unsigned int v, VAL_TYPE * out);
+unsigned int fatVersion     (PRBFatTree * t);
+size_t       fatTreeBytes   (PRBFatTree * t);
+void         releaseFatTree (PRBFatTree * t);
+
+#endif /*__PRBTREEFAT_H__*/
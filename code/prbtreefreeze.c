@@ -0,0 +1,208 @@
+/*-------------------------------------------------------------*
+ * prbtreefreeze.c - frozen (read-only) snapshots of PRBTree   *
+ *                   versions in Eytzinger layout              *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * A frozen version is a complete binary search tree stored by levels in one
+ * array, so that a search needs no pointers: from index k it continues to
+ * 2k or 2k + 1 by the result of one comparison, which is computed without
+ * a branch. The 16 descendants four levels below k share one cache line,
+ * which is prefetched while the levels above are searched. The index of the
+ * answer is recovered from the path at the end (the bits after the last right turn).
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "prbtreefreeze.h"
+#include <stdlib.h>
+
+/* Size of a cache line (in bytes) */
+#define CACHE_LINE 64
+
+/* Number of values of one cache line -- the descendants of k four levels below start at k * FROZEN_LINE */
+#define FROZEN_LINE (CACHE_LINE / sizeof(VAL_TYPE))
+
+static size_t fillSorted  (PRBTreeNode * x, VAL_TYPE * out);
+static size_t fillLayout  (PRBTreeFrozen * f, const VAL_TYPE * sorted, size_t i, size_t k);
+static size_t readLayout  (PRBTreeFrozen * f, VAL_TYPE * sorted, size_t i, size_t k);
+static size_t lowerIndex  (PRBTreeFrozen * f, VAL_TYPE x);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Makes a frozen snapshot of given version. It takes linear time and does not
+ * depend on the version any more, which may be released.
+ * Returns NULL if the aligned array cannot be allocated.
+ */
+PRBTreeFrozen * prbtreeFreeze (PRBTree * t)
+{
+  size_t n = t->root->size;
+  void * mem;
+  if (posix_memalign(&mem, CACHE_LINE, (n + 1) * sizeof(VAL_TYPE))) return NULL;
+  PRBTreeFrozen * ret = (PRBTreeFrozen *)malloc(sizeof(PRBTreeFrozen));
+  VAL_TYPE * sorted = (VAL_TYPE *)malloc((n + 1) * sizeof(VAL_TYPE));
+  ret->a = (VAL_TYPE *)mem;
+  ret->n = n;
+  fillSorted(t->root, sorted);
+  fillLayout(ret, sorted, 0, 1);
+  free(sorted);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a new version of a tree with the values of a frozen snapshot, so that it can be updated again.
+ */
+PRBTree * prbtreeThaw (PRBTreeFrozen * f)
+{
+  VAL_TYPE * sorted = (VAL_TYPE *)malloc((f->n + 1) * sizeof(VAL_TYPE));
+  size_t cnt = readLayout(f, sorted, 0, 1);
+  PRBTree * ret = prbtreeFromSorted(sorted, cnt);
+  free(sorted);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether a frozen snapshot contains certain value or not.
+ */
+int frozenFind (PRBTreeFrozen * f, VAL_TYPE x)
+{
+  size_t k = lowerIndex(f, x);
+  return k && f->a[k] == x;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Stores the smallest value of a frozen snapshot, which is not less than x, to out.
+ * Returns 0 if there is no such value.
+ */
+int frozenLowerBound (PRBTreeFrozen * f, VAL_TYPE x, VAL_TYPE * out)
+{
+  size_t k = lowerIndex(f, x);
+  if (!k) return 0;
+  *out = f->a[k];
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Looks up k values at once, found[i] is set to whether keys[i] is in the snapshot.
+ * Groups of FROZEN_BATCH lookups descend level by level side by side, so that
+ * their cache misses overlap instead of following one another.
+ */
+void frozenFindBatch (PRBTreeFrozen * f, const VAL_TYPE * keys, size_t k, char * found)
+{
+  const VAL_TYPE * a = f->a;
+  size_t n = f->n;
+  //number of levels, which are complete (every search passes through them)
+  int full = 0;
+  while (((size_t)2 << full) - 1 <= n) full++;
+  for (size_t b = 0; b < k; b += FROZEN_BATCH)
+  {
+    size_t m = k - b < FROZEN_BATCH ? k - b : FROZEN_BATCH;
+    size_t idx [FROZEN_BATCH];
+    for (size_t i = 0; i < m; i++) idx[i] = 1;
+    for (int l = 0; l < full; l++)
+      for (size_t i = 0; i < m; i++)
+      {
+        __builtin_prefetch(a + idx[i] * FROZEN_LINE);
+        idx[i] = 2 * idx[i] + (a[idx[i]] < keys[b + i]);
+      }
+    for (size_t i = 0; i < m; i++)
+    {
+      size_t j = idx[i];
+      if (j <= n) j = 2 * j + (a[j] < keys[b + i]);
+      j >>= __builtin_ffsl((long)~j);
+      found[b + i] = j && a[j] == keys[b + i];
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Frees a frozen snapshot.
+ */
+void releaseFrozen (PRBTreeFrozen * f)
+{
+  if (!f) return;
+  free(f->a);
+  free(f);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Stores the values of a subtree to out in ascending order, returns their number.
+ */
+static size_t fillSorted (PRBTreeNode * x, VAL_TYPE * out)
+{
+  size_t cnt = 0;
+  while (!isNull(x))
+  {
+    cnt += fillSorted(x->left, out + cnt);
+    out[cnt++] = x->content;
+    x = x->right;
+  }
+  return cnt;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Places the sorted values from index i on to the subtree of a snapshot rooted at k
+ * (in-order walk of the implicit tree). Returns the index of the next value to be placed.
+ */
+static size_t fillLayout (PRBTreeFrozen * f, const VAL_TYPE * sorted, size_t i, size_t k)
+{
+  if (k > f->n) return i;
+  i = fillLayout(f, sorted, i, 2 * k);
+  f->a[k] = sorted[i++];
+  return fillLayout(f, sorted, i, 2 * k + 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Reverse of fillLayout -- stores the values of the subtree of a snapshot rooted at k
+ * to sorted from index i on. Returns the index after the last stored value.
+ */
+static size_t readLayout (PRBTreeFrozen * f, VAL_TYPE * sorted, size_t i, size_t k)
+{
+  if (k > f->n) return i;
+  i = readLayout(f, sorted, i, 2 * k);
+  sorted[i++] = f->a[k];
+  return readLayout(f, sorted, i, 2 * k + 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the index of the smallest value of a snapshot, which is not less than x (0 if there is none).
+ * Every step goes to the left child when the value is not less than x and it is the last one
+ * of the path so far -- it is recovered by dropping the trailing right turns (1 bits) and one more bit.
+ */
+static size_t lowerIndex (PRBTreeFrozen * f, VAL_TYPE x)
+{
+  const VAL_TYPE * a = f->a;
+  size_t k = 1;
+  while (k <= f->n)
+  {
+    //a prefetch past the end of the array is harmless, it never faults
+    __builtin_prefetch(a + k * FROZEN_LINE);
+    k = 2 * k + (a[k] < x);
+  }
+  return k >> __builtin_ffsl((long)~k);
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------*
+ * prbtreefreeze.h - header for frozen (read-only) snapshots   *
+ *                   of PRBTree versions                       *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PRBTREEFREEZE_H__
+#define __PRBTREEFREEZE_H__
+
+#include <stddef.h>
+#include "common.h"
+#include "prbtree.h"
+
+/* Number of lookups of a batch, which descend the snapshot side by side */
+#define FROZEN_BATCH 16
+
+/* Snapshot of a version in Eytzinger order -- a[1] is the root, a[2k] and a[2k + 1]
+   are the children of a[k] (a[0] is unused, the array is aligned to a cache line) */
+struct PRBTreeFrozen_struct
+{
+  VAL_TYPE * a;
+  size_t     n;
+};
+
+PRBTreeFrozen * prbtreeFreeze     (PRBTree * t);
+PRBTree       * prbtreeThaw       (PRBTreeFrozen * f);
+int             frozenFind        (PRBTreeFrozen * f, VAL_TYPE x);
+int             frozenLowerBound  (PRBTreeFrozen * f, VAL_TYPE x, VAL_TYPE * out);
+void            frozenFindBatch   (PRBTreeFrozen * f, const VAL_TYPE * keys, size_t k, char * found);
+void            releaseFrozen     (PRBTreeFrozen * f);
+
+#endif /*__PRBTREEFREEZE_H__*/
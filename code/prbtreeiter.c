@@ -0,0 +1,294 @@
+/*-------------------------------------------------------------*
+ * prbtreeiter.c - implementation of ordered cursors over      *
+ *                 PRBTree versions                            *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#include "prbtreeiter.h"
+
+/* Rest of one version in order, as a stack of whole subtrees and single values
+   (every level of the tree leaves at most a right subtree and a value there) */
+typedef struct
+{
+  PRBTreeNode * node[2 * PRBTREE_ITER_DEPTH + 1];
+  char          whole[2 * PRBTREE_ITER_DEPTH + 1];
+  int           top;
+} PRBTreeStream;
+
+static int  descend    (PRBTreeIter * it, PRBTreeNode * x, int right);
+static void streamPush (PRBTreeStream * s, PRBTreeNode * x, int whole);
+static void streamOpen (PRBTreeStream * s);
+static void ignoreDiff (int kind, VAL_TYPE x, void * arg);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves a cursor to the smallest value of a tree. Returns 0 if the tree is empty.
+ */
+int treeMin (PRBTreeIter * it, PRBTree * t)
+{
+  it->top = 0;
+  return descend(it, t->root, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves a cursor to the largest value of a tree. Returns 0 if the tree is empty.
+ */
+int treeMax (PRBTreeIter * it, PRBTree * t)
+{
+  it->top = 0;
+  return descend(it, t->root, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves a cursor to the smallest value of a tree which is not less than x.
+ * Returns 0 if there is no such value.
+ */
+int lowerBound (PRBTreeIter * it, PRBTree * t, VAL_TYPE x)
+{
+  PRBTreeNode * cur = t->root;
+  int found = 0;
+  it->top = 0;
+  //the path is recorded down to the last node, which is not less than x
+  while (!isNull(cur))
+  {
+    it->path[it->top++] = cur;
+    if (x <= cur->content)
+    {
+      found = it->top;
+      if (x == cur->content) break;
+      cur = cur->left;
+    }
+    else cur = cur->right;
+  }
+  it->top = found;
+  return found != 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves a cursor to the smallest value of a tree which is greater than x.
+ * Returns 0 if there is no such value.
+ */
+int upperBound (PRBTreeIter * it, PRBTree * t, VAL_TYPE x)
+{
+  PRBTreeNode * cur = t->root;
+  int found = 0;
+  it->top = 0;
+  while (!isNull(cur))
+  {
+    it->path[it->top++] = cur;
+    if (x < cur->content)
+    {
+      found = it->top;
+      cur = cur->left;
+    }
+    else cur = cur->right;
+  }
+  it->top = found;
+  return found != 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves a cursor to the next value in order. Returns 0 when it runs off the end.
+ */
+int treeNext (PRBTreeIter * it)
+{
+  if (!it->top) return 0;
+  PRBTreeNode * cur = it->path[it->top - 1];
+  if (!isNull(cur->right)) return descend(it, cur->right, 0);
+  //climb up while coming from a right subtree
+  while (--it->top && it->path[it->top - 1]->right == cur) cur = it->path[it->top - 1];
+  return it->top != 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Moves a cursor to the previous value in order. Returns 0 when it runs off the beginning.
+ */
+int treePrev (PRBTreeIter * it)
+{
+  if (!it->top) return 0;
+  PRBTreeNode * cur = it->path[it->top - 1];
+  if (!isNull(cur->left)) return descend(it, cur->left, 1);
+  //climb up while coming from a left subtree
+  while (--it->top && it->path[it->top - 1]->left == cur) cur = it->path[it->top - 1];
+  return it->top != 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the value under a cursor (NA if the cursor is off the tree).
+ */
+VAL_TYPE treeValue (PRBTreeIter * it)
+{
+  if (!it->top) return NA;
+  return it->path[it->top - 1]->content;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Copies values of a tree from the interval [lo, hi] in ascending order
+ * to given array, at most cap of them. Returns how many were written.
+ * Nothing is allocated, a scan that filled the array can continue from the last value written.
+ */
+size_t rangeScan (PRBTree * t, VAL_TYPE lo, VAL_TYPE hi, VAL_TYPE * out, size_t cap)
+{
+  PRBTreeIter it;
+  size_t cnt = 0;
+  if (!cap || !lowerBound(&it, t, lo)) return 0;
+  do
+  {
+    VAL_TYPE x = it.path[it.top - 1]->content;
+    if (x > hi) break;
+    out[cnt++] = x;
+  }
+  while (cnt < cap && treeNext(&it));
+  return cnt;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Calls fn for every value, which is only in one of two versions, in ascending order.
+ * Both versions are walked at once as streams of subtrees -- when both streams begin with
+ * the same node, the whole subtree is skipped without being visited, otherwise the larger
+ * one is opened. The cost is thus proportional to the number of nodes copied between
+ * the versions (about the number of changes times log n). Returns the number of differences.
+ */
+size_t diff (PRBTree * t_old, PRBTree * t_new, PRBTreeDiffFn fn, void * arg)
+{
+  PRBTreeStream a, b;
+  size_t ret = 0;
+  a.top = b.top = 0;
+  streamPush(&a, t_old->root, 1);
+  streamPush(&b, t_new->root, 1);
+  while (a.top || b.top)
+  {
+    PRBTreeNode * x = a.top ? a.node[a.top - 1] : NULL;
+    PRBTreeNode * y = b.top ? b.node[b.top - 1] : NULL;
+    int xw = x && a.whole[a.top - 1];
+    int yw = y && b.whole[b.top - 1];
+    if (xw && yw)
+    {
+      if (x == y)
+      {
+        a.top--;
+        b.top--;
+      }
+      else if (x->size > y->size) streamOpen(&a);
+      else if (x->size < y->size) streamOpen(&b);
+      else
+      {
+        streamOpen(&a);
+        streamOpen(&b);
+      }
+    }
+    else if (xw) streamOpen(&a);
+    else if (yw) streamOpen(&b);
+    //both streams begin with single values (or one of them is empty)
+    else if (y && (!x || y->content < x->content))
+    {
+      fn(PRBTREE_INSERT, y->content, arg);
+      b.top--;
+      ret++;
+    }
+    else if (x && (!y || x->content < y->content))
+    {
+      fn(PRBTREE_ERASE, x->content, arg);
+      a.top--;
+      ret++;
+    }
+    else
+    {
+      a.top--;
+      b.top--;
+    }
+  }
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether two versions hold the same values. Versions with the same root are
+ * equal at once -- with hash-consing (PRBTREE_HASHCONS) equal trees of the same shape always
+ * have the same root. Otherwise the versions are compared by diff, which skips their shared subtrees.
+ */
+int treeEquals (PRBTree * t1, PRBTree * t2)
+{
+  if (t1->root == t2->root) return 1;
+  if (t1->root->size != t2->root->size) return 0;
+  return diff(t1, t2, ignoreDiff, NULL) == 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Descends from given node to the leftmost (rightmost if right is set) node of its subtree
+ * and appends the way to the path of a cursor. Returns 0 for an empty subtree.
+ */
+static int descend (PRBTreeIter * it, PRBTreeNode * x, int right)
+{
+  while (!isNull(x))
+  {
+    it->path[it->top++] = x;
+    x = right ? x->right : x->left;
+  }
+  return it->top != 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Puts a whole subtree or a single value (whole is 0) to the beginning of a stream.
+ */
+static void streamPush (PRBTreeStream * s, PRBTreeNode * x, int whole)
+{
+  if (isNull(x)) return;
+  s->node[s->top] = x;
+  s->whole[s->top++] = whole;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Replaces the subtree at the beginning of a stream by its left subtree, its root value
+ * and its right subtree.
+ */
+static void streamOpen (PRBTreeStream * s)
+{
+  PRBTreeNode * x = s->node[--s->top];
+  streamPush(s, x->right, 1);
+  streamPush(s, x, 0);
+  streamPush(s, x->left, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Receiver of differences, which only lets them be counted.
+ */
+static void ignoreDiff (int kind, VAL_TYPE x, void * arg)
+{
+  (void)kind;
+  (void)x;
+  (void)arg;
+}
+
+/*---------------------------------------------------------------------------*/
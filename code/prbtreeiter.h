@@ -0,0 +1,44 @@
+/*-------------------------------------------------------------*
+ * prbtreeiter.h - header for ordered cursors over PRBTree     *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PRBTREEITER_H__
+#define __PRBTREEITER_H__
+
+#include <stddef.h>
+#include "common.h"
+#include "prbtree.h"
+
+/* Longest path a cursor can hold (enough for a red-black tree with 2^49 nodes) */
+#define PRBTREE_ITER_DEPTH 100
+
+/* In-order cursor over one version of a tree -- the path from the root
+   to the current node (no current node when top is 0) */
+struct PRBTreeIter_struct
+{
+  PRBTreeNode * path[PRBTREE_ITER_DEPTH];
+  int           top;
+};
+
+/* Receiver of the differences of two versions -- kind is PRBTREE_INSERT
+   for a value added by the newer version and PRBTREE_ERASE for a removed one */
+typedef void (* PRBTreeDiffFn) (int kind, VAL_TYPE x, void * arg);
+
+int      treeMin    (PRBTreeIter * it, PRBTree * t);
+int      treeMax    (PRBTreeIter * it, PRBTree * t);
+int      lowerBound (PRBTreeIter * it, PRBTree * t, VAL_TYPE x);
+int      upperBound (PRBTreeIter * it, PRBTree * t, VAL_TYPE x);
+int      treeNext   (PRBTreeIter * it);
+int      treePrev   (PRBTreeIter * it);
+VAL_TYPE treeValue  (PRBTreeIter * it);
+size_t   rangeScan  (PRBTree * t, VAL_TYPE lo, VAL_TYPE hi, VAL_TYPE * out, size_t cap);
+size_t   diff       (PRBTree * t_old, PRBTree * t_new, PRBTreeDiffFn fn, void * arg);
+int      treeEquals (PRBTree * t1, PRBTree * t2);
+
+#endif /*__PRBTREEITER_H__*/
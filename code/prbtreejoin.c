@@ -0,0 +1,464 @@
+/*-------------------------------------------------------------*
+ * prbtreejoin.c - split and join of persistent red-black      *
+ *                 trees, range deletion and set operations    *
+ *                 built on them                               *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * Join of trees l < k < r walks down the spine of the higher one to a black
+ * node of the same black height as the other one and hangs both there under
+ * a new red node with k, the red-red conflict is repaired by rotations on the
+ * way back. Split descends to k and joins the subtrees left aside on the way.
+ * Both copy only the nodes on one path and share everything else with the
+ * given versions -- nodes created by the running operation (without references)
+ * are changed in place and the ones it drops are freed at once.
+ *
+ * Set operations split one tree by the root of the other one and recurse to both
+ * halves, which are independent, so the larger ones are run by a pool of threads.
+ * A pair of identical subtrees is done at once without being visited -- versions
+ * derived from each other share most of their subtrees.
+ */
+
+#include "prbtreejoin.h"
+#include <stdlib.h>
+
+/* Kinds of set operations */
+#define SET_UNION        0
+#define SET_INTERSECTION 1
+#define SET_DIFFERENCE   2
+
+/* Least black height of the trees of a set operation, for which it forks (about 2^12 nodes) */
+#ifndef SET_PAR_HEIGHT
+#define SET_PAR_HEIGHT 12
+#endif
+
+/* Arguments and result of one (forked) set operation */
+typedef struct
+{
+  int           kind;
+  PRBTreePool * pool;
+  PRBTreeNode * a;
+  int           ha;
+  PRBTreeNode * b;
+  int           hb;
+  PRBTreeNode * ret;
+  int           h;
+} PRBTreeSetOp;
+
+static int           blackHeight (PRBTreeNode * x);
+static PRBTreeNode * blacken     (PRBTreeNode * x, int * h);
+static PRBTreeNode * joinRight   (PRBTreeNode * l, int hl, VAL_TYPE k, PRBTreeNode * r, int hr);
+static PRBTreeNode * joinLeft    (PRBTreeNode * l, int hl, VAL_TYPE k, PRBTreeNode * r, int hr);
+static PRBTreeNode * joinNodes   (PRBTreeNode * l, int hl, VAL_TYPE k, PRBTreeNode * r, int hr, int * h);
+static PRBTreeNode * join2Nodes  (PRBTreeNode * l, int hl, PRBTreeNode * r, int hr, int * h);
+static int           splitNodes  (PRBTreeNode * x, int hx, VAL_TYPE k,
+                                  PRBTreeNode ** l, int * hl, PRBTreeNode ** r, int * hr);
+static PRBTreeNode * setNodes    (int kind, PRBTreePool * pool, PRBTreeNode * a, int ha,
+                                  PRBTreeNode * b, int hb, int * h);
+static void          setTask     (void * arg);
+static PRBTree     * setTrees    (int kind, PRBTree * t1, PRBTree * t2, PRBTreePool * pool);
+static void          dropFresh   (PRBTreeNode * x);
+static PRBTree     * publish     (PRBTreeNode * x);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Splits a tree to the trees of values less and greater than k, which are stored
+ * to less and greater. Returns whether k was in the tree. Takes O(log n) time.
+ */
+int split (PRBTree * t, VAL_TYPE k, PRBTree ** less, PRBTree ** greater)
+{
+  PRBTreeNode * l, * r;
+  int hl, hr;
+  int ret = splitNodes(t->root, blackHeight(t->root), k, &l, &hl, &r, &hr);
+  *less = publish(l);
+  *greater = publish(r);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree of the values of t1, k and the values of t2. All values of t1
+ * must be less than k and all values of t2 greater. Takes O(log n) time.
+ */
+PRBTree * join (PRBTree * t1, VAL_TYPE k, PRBTree * t2)
+{
+  int h;
+  return publish(joinNodes(t1->root, blackHeight(t1->root), k, t2->root, blackHeight(t2->root), &h));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree formed by deleting all values from the interval [lo, hi] from given tree.
+ * It costs two splits and one join regardless of the number of deleted values.
+ */
+PRBTree * eraseRange (PRBTree * t, VAL_TYPE lo, VAL_TYPE hi)
+{
+  if (lo > hi) return publish(t->root);
+  PRBTreeNode * a, * b, * c, * d;
+  int ha, hb, hc, hd, h;
+  splitNodes(t->root, blackHeight(t->root), lo, &a, &ha, &b, &hb);
+  splitNodes(b, hb, hi, &c, &hc, &d, &hd);
+  dropFresh(c);
+  return publish(join2Nodes(a, ha, d, hd, &h));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree of the values of given tree from the interval [lo, hi]. If rest
+ * is not NULL, the tree of the remaining values is stored there (the same one
+ * eraseRange would return), both of them are made by the same two splits.
+ */
+PRBTree * extractRange (PRBTree * t, VAL_TYPE lo, VAL_TYPE hi, PRBTree ** rest)
+{
+  if (lo > hi)
+  {
+    if (rest) *rest = publish(t->root);
+    return makeTree();
+  }
+  PRBTreeNode * a, * b, * c, * d;
+  int ha, hb, hc, hd, h;
+  int found_lo = splitNodes(t->root, blackHeight(t->root), lo, &a, &ha, &b, &hb);
+  int found_hi = splitNodes(b, hb, hi, &c, &hc, &d, &hd);
+  //the bounds themselves were left out by the splits
+  if (found_lo) c = joinNodes(nullNode, 0, lo, c, hc, &hc);
+  if (found_hi) c = joinNodes(c, hc, hi, nullNode, 0, &hc);
+  if (rest) *rest = publish(join2Nodes(a, ha, d, hd, &h));
+  else
+  {
+    dropFresh(a);
+    dropFresh(d);
+  }
+  return publish(c);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree of the values which are in t1 or in t2. The trees are merged in
+ * O(m log(n/m + 1)) time for sizes m <= n, the halves of large trees are done in parallel
+ * by given pool (which may be NULL).
+ */
+PRBTree * treeUnion (PRBTree * t1, PRBTree * t2, PRBTreePool * pool)
+{
+  return setTrees(SET_UNION, t1, t2, pool);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree of the values which are both in t1 and t2 (see treeUnion).
+ */
+PRBTree * treeIntersection (PRBTree * t1, PRBTree * t2, PRBTreePool * pool)
+{
+  return setTrees(SET_INTERSECTION, t1, t2, pool);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a tree of the values of t1 which are not in t2 (see treeUnion).
+ */
+PRBTree * treeDifference (PRBTree * t1, PRBTree * t2, PRBTreePool * pool)
+{
+  return setTrees(SET_DIFFERENCE, t1, t2, pool);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of black nodes on a path from x down to a leaf (x included).
+ */
+static int blackHeight (PRBTreeNode * x)
+{
+  int h = 0;
+  for (; !isNull(x); x = x->left) if (x->colour == BLACK) h++;
+  return h;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Makes the root of a subtree black (copying it if it is shared), its black height h grows by one.
+ */
+static PRBTreeNode * blacken (PRBTreeNode * x, int * h)
+{
+  if (isNull(x) || x->colour == BLACK) return x;
+  x = cloneNode(x);
+  x->colour = BLACK;
+  (*h)++;
+  return x;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Joins subtree r with k to the right spine of a higher subtree l (hl >= hr, the root of r is black).
+ * The result has black height hl, its root may be red, but it has black children then.
+ */
+static PRBTreeNode * joinRight (PRBTreeNode * l, int hl, VAL_TYPE k, PRBTreeNode * r, int hr)
+{
+  if (l->colour == BLACK && hl == hr)
+  {
+    PRBTreeNode * ret = makeNode(k);
+    ret->colour = RED;
+    ret->left = l;
+    ret->right = r;
+    return ret;
+  }
+  PRBTreeNode * x = cloneNode(l);
+  x->right = joinRight(l->right, hl - (l->colour == BLACK), k, r, hr);
+  if (x->colour == BLACK && x->right->colour == RED && x->right->right->colour == RED)
+  {
+    //red-red conflict below a black node, it is repaired by a rotation
+    PRBTreeNode * y = x->right;
+    cloneSpec(y->right, y);
+    y->right->colour = BLACK;
+    x->right = y->left;
+    y->left = x;
+    return y;
+  }
+  return x;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Mirror image of joinRight (hr >= hl, the root of l is black).
+ */
+static PRBTreeNode * joinLeft (PRBTreeNode * l, int hl, VAL_TYPE k, PRBTreeNode * r, int hr)
+{
+  if (r->colour == BLACK && hl == hr)
+  {
+    PRBTreeNode * ret = makeNode(k);
+    ret->colour = RED;
+    ret->left = l;
+    ret->right = r;
+    return ret;
+  }
+  PRBTreeNode * x = cloneNode(r);
+  x->left = joinLeft(l, hl, k, r->left, hr - (r->colour == BLACK));
+  if (x->colour == BLACK && x->left->colour == RED && x->left->left->colour == RED)
+  {
+    PRBTreeNode * y = x->left;
+    cloneSpec(y->left, y);
+    y->left->colour = BLACK;
+    x->left = y->right;
+    y->right = x;
+    return y;
+  }
+  return x;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a subtree of the values of l, k and r (of black heights hl and hr),
+ * its black height is stored to h.
+ */
+static PRBTreeNode * joinNodes (PRBTreeNode * l, int hl, VAL_TYPE k, PRBTreeNode * r, int hr, int * h)
+{
+  l = blacken(l, &hl);
+  r = blacken(r, &hr);
+  if (hl > hr)
+  {
+    *h = hl;
+    return joinRight(l, hl, k, r, hr);
+  }
+  *h = hr;
+  return joinLeft(l, hl, k, r, hr);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a subtree of the values of l and r without a value between them --
+ * the least value of r is split off and used as one.
+ */
+static PRBTreeNode * join2Nodes (PRBTreeNode * l, int hl, PRBTreeNode * r, int hr, int * h)
+{
+  if (isNull(r))
+  {
+    *h = hl;
+    return l;
+  }
+  PRBTreeNode * x = r;
+  while (!isNull(x->left)) x = x->left;
+  VAL_TYPE k = x->content;
+  PRBTreeNode * e, * g;
+  int he, hg;
+  splitNodes(r, hr, k, &e, &he, &g, &hg);
+  return joinNodes(l, hl, k, g, hg, h);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Splits subtree x (of black height hx) to the subtrees of values less and greater
+ * than k, which are stored to l and r with their black heights. Returns whether k was found.
+ * Nodes on the path are not used any more, so the ones created by the running update are freed.
+ */
+static int splitNodes (PRBTreeNode * x, int hx, VAL_TYPE k,
+                       PRBTreeNode ** l, int * hl, PRBTreeNode ** r, int * hr)
+{
+  if (isNull(x))
+  {
+    *l = *r = nullNode;
+    *hl = *hr = 0;
+    return 0;
+  }
+  int hc = hx - (x->colour == BLACK);
+  VAL_TYPE key = x->content;
+  PRBTreeNode * xl = x->left;
+  PRBTreeNode * xr = x->right;
+  if (!__atomic_load_n(&x->refs, __ATOMIC_RELAXED)) freeNode(x);
+  PRBTreeNode * m;
+  int hm, ret;
+  if (k < key)
+  {
+    ret = splitNodes(xl, hc, k, l, hl, &m, &hm);
+    *r = joinNodes(m, hm, key, xr, hc, hr);
+  }
+  else if (k > key)
+  {
+    ret = splitNodes(xr, hc, k, &m, &hm, r, hr);
+    *l = joinNodes(xl, hc, key, m, hm, hl);
+  }
+  else
+  {
+    *l = xl;
+    *r = xr;
+    *hl = *hr = hc;
+    ret = 1;
+  }
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Runs a set operation on the roots of two versions and publishes the result.
+ */
+static PRBTree * setTrees (int kind, PRBTree * t1, PRBTree * t2, PRBTreePool * pool)
+{
+  int h;
+  return publish(setNodes(kind, pool, t1->root, blackHeight(t1->root), t2->root, blackHeight(t2->root), &h));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the result of a set operation on subtrees a and b (of black heights ha and hb),
+ * its black height is stored to h. Subtree a is split by the root of b in case
+ * of the difference, otherwise b is split by the root of a.
+ */
+static PRBTreeNode * setNodes (int kind, PRBTreePool * pool, PRBTreeNode * a, int ha,
+                               PRBTreeNode * b, int hb, int * h)
+{
+  if (a == b)
+  {
+    *h = kind == SET_DIFFERENCE ? 0 : ha;
+    return kind == SET_DIFFERENCE ? nullNode : a;
+  }
+  if (isNull(a) || isNull(b))
+  {
+    PRBTreeNode * keep = isNull(a) ? b : a;
+    if (kind == SET_UNION || (kind == SET_DIFFERENCE && keep == a))
+    {
+      *h = isNull(a) ? hb : ha;
+      return keep;
+    }
+    dropFresh(keep);
+    *h = 0;
+    return nullNode;
+  }
+  if (kind == SET_DIFFERENCE)
+  {
+    //b is taken apart and a is split
+    PRBTreeNode * x = a;
+    int hx = ha;
+    a = b;
+    ha = hb;
+    b = x;
+    hb = hx;
+  }
+  int hc = ha - (a->colour == BLACK);
+  VAL_TYPE k = a->content;
+  PRBTreeNode * al = a->left;
+  PRBTreeNode * ar = a->right;
+  if (!__atomic_load_n(&a->refs, __ATOMIC_RELAXED)) freeNode(a);
+  PRBTreeNode * bl, * br;
+  int hbl, hbr;
+  int found = splitNodes(b, hb, k, &bl, &hbl, &br, &hbr);
+  //operands of the halves in the original order
+  PRBTreeSetOp left = {kind, pool, al, hc, bl, hbl, NULL, 0};
+  PRBTreeSetOp right = {kind, pool, ar, hc, br, hbr, NULL, 0};
+  if (kind == SET_DIFFERENCE)
+  {
+    left = (PRBTreeSetOp){kind, pool, bl, hbl, al, hc, NULL, 0};
+    right = (PRBTreeSetOp){kind, pool, br, hbr, ar, hc, NULL, 0};
+  }
+  if (pool && (ha >= SET_PAR_HEIGHT || hb >= SET_PAR_HEIGHT))
+  {
+    PRBTreeTask task;
+    forkTask(pool, &task, setTask, &left);
+    setTask(&right);
+    joinTask(pool, &task);
+  }
+  else
+  {
+    setTask(&left);
+    setTask(&right);
+  }
+  if (kind == SET_UNION || (kind == SET_INTERSECTION && found))
+    return joinNodes(left.ret, left.h, k, right.ret, right.h, h);
+  return join2Nodes(left.ret, left.h, right.ret, right.h, h);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Runs one set operation described by arg (of type PRBTreeSetOp).
+ */
+static void setTask (void * arg)
+{
+  PRBTreeSetOp * s = (PRBTreeSetOp *)arg;
+  s->ret = setNodes(s->kind, s->pool, s->a, s->ha, s->b, s->hb, &s->h);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Frees the nodes of a subtree, which were created by the running update
+ * (the shared ones belong to other versions).
+ */
+static void dropFresh (PRBTreeNode * x)
+{
+  if (isNull(x) || __atomic_load_n(&x->refs, __ATOMIC_RELAXED)) return;
+  dropFresh(x->left);
+  dropFresh(x->right);
+  freeNode(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Wraps a subtree made by the running update to a new version of a tree. The root is made black.
+ */
+static PRBTree * publish (PRBTreeNode * x)
+{
+  int h = 0;
+  PRBTree * ret = makeTree();
+  ret->root = blacken(x, &h);
+  ret->root = commitNode(ret->root);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,27 @@
+/*-------------------------------------------------------------*
+ * prbtreejoin.h - header for split and join of PRBTree        *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PRBTREEJOIN_H__
+#define __PRBTREEJOIN_H__
+
+#include "common.h"
+#include "prbtree.h"
+#include "prbtreepool.h"
+
+int       split        (PRBTree * t, VAL_TYPE k, PRBTree ** less, PRBTree ** greater);
+PRBTree * join         (PRBTree * t1, VAL_TYPE k, PRBTree * t2);
+PRBTree * eraseRange   (PRBTree * t, VAL_TYPE lo, VAL_TYPE hi);
+PRBTree * extractRange (PRBTree * t, VAL_TYPE lo, VAL_TYPE hi, PRBTree ** rest);
+
+PRBTree * treeUnion        (PRBTree * t1, PRBTree * t2, PRBTreePool * pool);
+PRBTree * treeIntersection (PRBTree * t1, PRBTree * t2, PRBTreePool * pool);
+PRBTree * treeDifference   (PRBTree * t1, PRBTree * t2, PRBTreePool * pool);
+
+#endif /*__PRBTREEJOIN_H__*/
@@ -11,6 +11,26 @@
 #include "prbtreenode.h"
 #include <stdlib.h>
 
+#ifdef PRBTREE_HASHCONS
+#include <pthread.h>
+#include <stdint.h>
+
+/* Initial number of slots of the intern table (a power of two) */
+#define INTERN_MIN 1024
+
+/* Intern table of all published nodes -- open addressing with linear probing,
+   a node is identified by its colour, content and (already interned) children */
+static PRBTreeNode   ** intern_tab = NULL;
+static size_t           intern_cap = 0;
+static size_t           intern_cnt = 0;
+static pthread_mutex_t  intern_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t internHash   (int colour, VAL_TYPE content, PRBTreeNode * left, PRBTreeNode * right);
+static size_t internFind   (PRBTreeNode * x);
+static void   internGrow   (void);
+static void   internRemove (PRBTreeNode * x);
+#endif
+
 /*---------------------------------------------------------------------------*/
 
 /**
@@ -23,6 +43,8 @@ PRBTreeNode * makeNode (VAL_TYPE x)
   ret->content = x;
   ret->left = nullNode;
   ret->right = nullNode;
+  ret->refs = 0;
+  ret->size = 1;
   return ret;
 }
 
@@ -30,14 +52,17 @@ PRBTreeNode * makeNode (VAL_TYPE x)
 
 /**
  * Returns a copy of given node (in case it is not null leaf).
+ * A node created by the running update is not shared yet, so it is returned as it is.
  */
 PRBTreeNode * cloneNode (PRBTreeNode * x)
 {
   if (isNull(x)) return nullNode;
+  if (__atomic_load_n(&x->refs, __ATOMIC_RELAXED) == 0) return x;
   PRBTreeNode * ret = makeNode(x->content);
   ret->colour = x->colour;
   ret->left = x->left;
   ret->right = x->right;
+  ret->size = x->size;
   return ret;
 }
 
@@ -63,3 +88,207 @@ int isNull (PRBTreeNode * x)
 }
 
 /*---------------------------------------------------------------------------*/
+
+/**
+ * Gives given node back to the allocator (the node must not be referenced).
+ */
+void freeNode (PRBTreeNode * x)
+{
+  free(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Adds a reference to given node.
+ */
+void retainNode (PRBTreeNode * x)
+{
+  if (isNull(x)) return;
+  __atomic_add_fetch(&x->refs, 1, __ATOMIC_RELAXED);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Drops a reference to given node. The node is freed when the last reference
+ * is gone, and so are (recursively) the children that are not shared elsewhere.
+ * With hash-consing the last reference is dropped under the lock of the intern table,
+ * so that the node cannot be found and shared again while it is being freed.
+ */
+void releaseNode (PRBTreeNode * x)
+{
+  if (isNull(x)) return;
+#ifdef PRBTREE_HASHCONS
+  int r = __atomic_load_n(&x->refs, __ATOMIC_RELAXED);
+  while (r > 1)
+    if (__atomic_compare_exchange_n(&x->refs, &r, r - 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) return;
+  pthread_mutex_lock(&intern_lock);
+  if (__atomic_sub_fetch(&x->refs, 1, __ATOMIC_ACQ_REL))
+  {
+    pthread_mutex_unlock(&intern_lock);
+    return;
+  }
+  internRemove(x);
+  pthread_mutex_unlock(&intern_lock);
+#else
+  if (__atomic_sub_fetch(&x->refs, 1, __ATOMIC_ACQ_REL)) return;
+#endif
+  releaseNode(x->left);
+  releaseNode(x->right);
+  freeNode(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Publishes a node reachable from a new version. Nodes created by the update
+ * (still without references) get their only parent and are published recursively,
+ * the old nodes which they point to are shared by one more parent.
+ * Subtree sizes of the new nodes are recomputed on the way back -- every node
+ * whose subtree was changed by the update is a new one.
+ * The cost is thus proportional to the number of new nodes.
+ * Returns the published node, which differs from x only with hash-consing (see internNode).
+ */
+PRBTreeNode * commitNode (PRBTreeNode * x)
+{
+  if (isNull(x)) return x;
+  if (__atomic_load_n(&x->refs, __ATOMIC_RELAXED))
+  {
+    retainNode(x);
+    return x;
+  }
+  x->left = commitNode(x->left);
+  x->right = commitNode(x->right);
+  x->size = x->left->size + x->right->size + 1;
+  return internNode(x);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Publishes a new node, whose children are published already. Without hash-consing
+ * it just gets its first reference. With hash-consing (PRBTREE_HASHCONS) an equal node
+ * (of the same colour, content and children) is looked up in the intern table --
+ * if there is one, it is shared instead and the new node is freed. Equal subtrees of
+ * all versions are thus stored once, however they were derived.
+ */
+PRBTreeNode * internNode (PRBTreeNode * x)
+{
+#ifdef PRBTREE_HASHCONS
+  pthread_mutex_lock(&intern_lock);
+  if (2 * (intern_cnt + 1) > intern_cap) internGrow();
+  size_t i = internFind(x);
+  PRBTreeNode * y = intern_tab[i];
+  if (y)
+  {
+    __atomic_add_fetch(&y->refs, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&intern_lock);
+    releaseNode(x->left);
+    releaseNode(x->right);
+    freeNode(x);
+    return y;
+  }
+  x->refs = 1;
+  intern_tab[i] = x;
+  intern_cnt++;
+  pthread_mutex_unlock(&intern_lock);
+#else
+  x->refs = 1;
+#endif
+  return x;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of nodes in the intern table (0 without hash-consing).
+ */
+size_t internedNodes (void)
+{
+#ifdef PRBTREE_HASHCONS
+  pthread_mutex_lock(&intern_lock);
+  size_t ret = intern_cnt;
+  pthread_mutex_unlock(&intern_lock);
+  return ret;
+#else
+  return 0;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef PRBTREE_HASHCONS
+
+/**
+ * Returns the hash of a node with given fields.
+ */
+static size_t internHash (int colour, VAL_TYPE content, PRBTreeNode * left, PRBTreeNode * right)
+{
+  uint64_t h = (uint64_t)(uintptr_t)left * 0x9e3779b97f4a7c15ULL;
+  h ^= ((uint64_t)(uintptr_t)right + 0x632be59bd9b4e019ULL) * 0xc2b2ae3d27d4eb4fULL;
+  h ^= ((uint64_t)(unsigned int)content << 1 | (uint64_t)colour) * 0x165667b19e3779f9ULL;
+  return (size_t)(h ^ (h >> 29));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the slot of the intern table holding a node equal to x, or the empty slot
+ * where it belongs. The lock of the table must be held.
+ */
+static size_t internFind (PRBTreeNode * x)
+{
+  size_t i = internHash(x->colour, x->content, x->left, x->right) & (intern_cap - 1);
+  for (PRBTreeNode * y; (y = intern_tab[i]); i = (i + 1) & (intern_cap - 1))
+    if (y->colour == x->colour && y->content == x->content && y->left == x->left && y->right == x->right)
+      break;
+  return i;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Doubles the intern table. The lock of the table must be held.
+ */
+static void internGrow (void)
+{
+  PRBTreeNode ** old = intern_tab;
+  size_t old_cap = intern_cap;
+  intern_cap = old_cap ? 2 * old_cap : INTERN_MIN;
+  intern_tab = (PRBTreeNode **)calloc(intern_cap, sizeof(PRBTreeNode *));
+  for (size_t i = 0; i < old_cap; i++)
+    if (old[i]) intern_tab[internFind(old[i])] = old[i];
+  free(old);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Removes given node from the intern table, the following nodes of its cluster
+ * are shifted back, so that no tombstones are needed. The lock of the table must be held.
+ */
+static void internRemove (PRBTreeNode * x)
+{
+  size_t mask = intern_cap - 1;
+  size_t i = internHash(x->colour, x->content, x->left, x->right) & mask;
+  while (intern_tab[i] != x) i = (i + 1) & mask;
+  intern_tab[i] = NULL;
+  intern_cnt--;
+  for (size_t j = (i + 1) & mask; intern_tab[j]; j = (j + 1) & mask)
+  {
+    PRBTreeNode * y = intern_tab[j];
+    size_t home = internHash(y->colour, y->content, y->left, y->right) & mask;
+    //y may move to the hole, unless its home lies cyclically in (i, j]
+    if (((j - home) & mask) >= ((j - i) & mask))
+    {
+      intern_tab[i] = y;
+      intern_tab[j] = NULL;
+      i = j;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+#endif /*PRBTREE_HASHCONS*/
@@ -11,19 +11,30 @@
 #ifndef __PRBTREENODE_H__
 #define __PRBTREENODE_H__
 
+#include <stddef.h>
 #include "common.h"
 
+/* Nodes are hash-consed when the trees are built with -DPRBTREE_HASHCONS -- every published
+   node is unique, so that equal subtrees of all versions are shared (see internNode) */
 struct PRBTreeNode_struct
 {
   int                         colour;
   VAL_TYPE                    content;
   struct PRBTreeNode_struct * left;
   struct PRBTreeNode_struct * right;       
+  int                         refs;
+  unsigned int                size;
 };
 
-PRBTreeNode * makeNode  (VAL_TYPE x);
-PRBTreeNode * cloneNode (PRBTreeNode * a);
-void          cloneSpec (PRBTreeNode * x, PRBTreeNode * y);
-int           isNull    (PRBTreeNode * a);
+PRBTreeNode * makeNode      (VAL_TYPE x);
+PRBTreeNode * cloneNode     (PRBTreeNode * a);
+void          cloneSpec     (PRBTreeNode * x, PRBTreeNode * y);
+int           isNull        (PRBTreeNode * a);
+void          freeNode      (PRBTreeNode * a);
+void          retainNode    (PRBTreeNode * a);
+void          releaseNode   (PRBTreeNode * a);
+PRBTreeNode * commitNode    (PRBTreeNode * a);
+PRBTreeNode * internNode    (PRBTreeNode * a);
+size_t        internedNodes (void);
 
 #endif /*__PRBTREENODE_H__*/
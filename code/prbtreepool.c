@@ -0,0 +1,163 @@
+/*-------------------------------------------------------------*
+ * prbtreepool.c - fork-join thread pool used by parallel      *
+ *                 operations of PRBTree                       *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * Forked tasks wait in one queue guarded by a lock. Idle workers take the oldest
+ * ones (the largest in divide and conquer). The forker joins its task either by
+ * taking it back from the queue and running it itself, or, if a worker has already
+ * started it, by running other queued tasks until it is done, so no thread is ever
+ * blocked while there is work to do.
+ */
+
+#include "prbtreepool.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void * worker  (void * arg);
+static void   runTask (PRBTreePool * p, PRBTreeTask * t);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates a pool, where forked tasks are run by given number of threads
+ * (the joining thread included, so threads - 1 workers are started).
+ */
+PRBTreePool * makePool (int threads)
+{
+  PRBTreePool * ret = (PRBTreePool *)malloc(sizeof(PRBTreePool));
+  pthread_mutex_init(&ret->lock, NULL);
+  pthread_cond_init(&ret->cond, NULL);
+  ret->cnt = 0;
+  ret->stop = 0;
+  ret->threads = 0;
+  ret->workers = (pthread_t *)malloc(sizeof(pthread_t) * (threads > 1 ? threads - 1 : 1));
+  for (int i = 0; i < threads - 1; i++)
+    if (!pthread_create(&ret->workers[ret->threads], NULL, worker, ret)) ret->threads++;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Stops the workers of a pool and frees it. No task may be pending.
+ */
+void releasePool (PRBTreePool * p)
+{
+  if (!p) return;
+  pthread_mutex_lock(&p->lock);
+  p->stop = 1;
+  pthread_cond_broadcast(&p->cond);
+  pthread_mutex_unlock(&p->lock);
+  for (int i = 0; i < p->threads; i++) pthread_join(p->workers[i], NULL);
+  pthread_cond_destroy(&p->cond);
+  pthread_mutex_destroy(&p->lock);
+  free(p->workers);
+  free(p);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Offers fn(arg) to the workers of a pool. Without a pool (or with a full queue)
+ * it is run at once. Every forked task must be joined by joinTask.
+ */
+void forkTask (PRBTreePool * p, PRBTreeTask * t, void (* fn) (void *), void * arg)
+{
+  t->fn = fn;
+  t->arg = arg;
+  t->state = TASK_QUEUED;
+  if (p && p->threads)
+  {
+    pthread_mutex_lock(&p->lock);
+    if (p->cnt < POOL_QUEUE)
+    {
+      p->queue[p->cnt++] = t;
+      pthread_cond_signal(&p->cond);
+      pthread_mutex_unlock(&p->lock);
+      return;
+    }
+    pthread_mutex_unlock(&p->lock);
+  }
+  t->state = TASK_RUNNING;
+  fn(arg);
+  t->state = TASK_DONE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Waits until given task is done, helping with the queued tasks meanwhile.
+ */
+void joinTask (PRBTreePool * p, PRBTreeTask * t)
+{
+  if (!p || !p->threads) return;
+  pthread_mutex_lock(&p->lock);
+  if (t->state == TASK_QUEUED)
+  {
+    //nobody took it yet, it is run by the joining thread
+    for (int i = p->cnt - 1; i >= 0; i--)
+      if (p->queue[i] == t)
+      {
+        memmove(&p->queue[i], &p->queue[i + 1], sizeof(PRBTreeTask *) * (p->cnt - i - 1));
+        p->cnt--;
+        break;
+      }
+    t->state = TASK_RUNNING;
+    pthread_mutex_unlock(&p->lock);
+    t->fn(t->arg);
+    pthread_mutex_lock(&p->lock);
+    t->state = TASK_DONE;
+    pthread_mutex_unlock(&p->lock);
+    return;
+  }
+  while (t->state != TASK_DONE)
+  {
+    if (p->cnt) runTask(p, p->queue[0]);
+    else pthread_cond_wait(&p->cond, &p->lock);
+  }
+  pthread_mutex_unlock(&p->lock);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Main loop of a worker of a pool.
+ */
+static void * worker (void * arg)
+{
+  PRBTreePool * p = (PRBTreePool *)arg;
+  pthread_mutex_lock(&p->lock);
+  while (!p->stop)
+  {
+    if (p->cnt) runTask(p, p->queue[0]);
+    else pthread_cond_wait(&p->cond, &p->lock);
+  }
+  pthread_mutex_unlock(&p->lock);
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Takes given task (the oldest one) out of the queue and runs it. It is called
+ * with the lock of the pool held, the lock is released while the task runs.
+ */
+static void runTask (PRBTreePool * p, PRBTreeTask * t)
+{
+  memmove(&p->queue[0], &p->queue[1], sizeof(PRBTreeTask *) * (p->cnt - 1));
+  p->cnt--;
+  t->state = TASK_RUNNING;
+  pthread_mutex_unlock(&p->lock);
+  t->fn(t->arg);
+  pthread_mutex_lock(&p->lock);
+  t->state = TASK_DONE;
+  pthread_cond_broadcast(&p->cond);
+}
+
+/*---------------------------------------------------------------------------*/
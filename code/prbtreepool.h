@@ -0,0 +1,50 @@
+/*-------------------------------------------------------------*
+ * prbtreepool.h - header for fork-join thread pool used by    *
+ *                 parallel operations of PRBTree              *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PRBTREEPOOL_H__
+#define __PRBTREEPOOL_H__
+
+#include <pthread.h>
+#include "common.h"
+
+/* Largest number of tasks waiting in a pool, further ones are run at once by their forker */
+#define POOL_QUEUE 256
+
+/* States of a task */
+#define TASK_QUEUED  0
+#define TASK_RUNNING 1
+#define TASK_DONE    2
+
+/* Task forked to a pool -- it lives in the frame of the forker until it is joined */
+struct PRBTreeTask_struct
+{
+  void   (* fn) (void *);
+  void    * arg;
+  int       state;
+};
+
+struct PRBTreePool_struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+  PRBTreeTask   * queue[POOL_QUEUE];
+  int             cnt;
+  int             stop;
+  int             threads;
+  pthread_t     * workers;
+};
+
+PRBTreePool * makePool    (int threads);
+void          releasePool (PRBTreePool * p);
+void          forkTask    (PRBTreePool * p, PRBTreeTask * t, void (* fn) (void *), void * arg);
+void          joinTask    (PRBTreePool * p, PRBTreeTask * t);
+
+#endif /*__PRBTREEPOOL_H__*/
@@ -0,0 +1,950 @@
+/*-------------------------------------------------------------*
+ * psnapshot.c - implementation of on-disk snapshots of        *
+ *               versions of persistent red-black trees        *
+ *               and deques                                    *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * A set of versions is written as the DAG it forms in memory -- every node,
+ * buffer and triple reachable from more versions is written once (the written
+ * ones are remembered by their addresses). The records use offsets instead of
+ * pointers, so a file is mapped to memory as it is and searched and traversed
+ * in place without any deserialization. The versions can also be loaded back
+ * to memory, the parts shared in the file are then shared again.
+ * The byte order and the size of values have to match the writing machine.
+ * Nothing else of a mapped file is trusted: a search or an indexing checks
+ * every record it reads to lie in the file before the record referring to it
+ * (so it always ends), a traversal or a load first checks the whole versions
+ * (the kinds of their records, their lengths, red-black trees), and a truncated
+ * or corrupt file makes them fail instead of reading outside it.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "psnapshot.h"
+#include "pclist.h"
+#include "pclistarena.h"
+#include "pclistelem.h"
+#include "prbtree.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Record at given offset of a mapped snapshot (see inFile) */
+#define AT(s, off, T) ((const T *)((s)->base + (off)))
+
+/* Deepest tree accepted in a file, red-black trees of 2^31 values are lower */
+#define SNAP_TREE_DEPTH 64
+
+/* Deepest nesting of deques, buffers and triples accepted in a file (the check
+   and the traversals recurse through it, so it has to fit the stack) */
+#define SNAP_DEQUE_DEPTH 16384
+
+/* A checked part of a deque is remembered by its length, the level of its buffers
+   (see validDeque) and its kind packed in one word */
+#define PACK(len, level, kind) ((uint64_t)(len) << 24 | (uint64_t)(level) << 2 | (kind))
+#define SNAP_LEN_MAX   (((uint64_t)1 << 40) - 1)
+#define SNAP_LEVEL_MAX ((1 << 22) - 1)
+#define KIND_DEQUE  1
+#define KIND_BUFFER 2
+#define KIND_TRIPLE 3
+
+/* Values are stored in the 8 byte slots of leaf buffers */
+typedef char SlotTypeCheck [sizeof(VAL_TYPE) <= sizeof(uint64_t) ? 1 : -1];
+
+/* Map of parts already written or loaded -- from addresses to offsets
+   when writing, from offsets to addresses when loading (open addressing) */
+typedef struct
+{
+  uint64_t * keys;
+  uint64_t * vals;
+  size_t     cap;
+  size_t     cnt;
+} PSnapMap;
+
+/* State of a running write */
+typedef struct
+{
+  FILE     * f;
+  uint64_t   off;
+  int        err;
+  PSnapMap   map;
+} PSnapWriter;
+
+static uint64_t              writeRecord (PSnapWriter * w, const void * rec, size_t size);
+static uint64_t              writeNode   (PSnapWriter * w, PRBTreeNode * x);
+static uint64_t              writeDeque  (PSnapWriter * w, PCList * d);
+static uint64_t              writeBuffer (PSnapWriter * w, PCListBuffer * b);
+static uint64_t              writeTriple (PSnapWriter * w, PCListElem * e);
+static int                   inFile      (PSnapshot * s, uint64_t off, uint64_t size, uint64_t below);
+static const PSnapBuffer   * bufferAt    (PSnapshot * s, uint64_t off, uint64_t below);
+static size_t                snapListLen (PSnapshot * s, uint64_t off, uint64_t below);
+static size_t                snapBufLen  (PSnapshot * s, uint64_t off, uint64_t below);
+static int                   validTree   (PSnapshot * s, uint64_t off, PSnapMap * map);
+static int                   validNode   (PSnapshot * s, uint64_t off, uint64_t below, const VAL_TYPE * lo, const VAL_TYPE * hi, int depth, PSnapMap * map);
+static const PSnapNode     * spineEnd    (PSnapshot * s, uint64_t off, int right);
+static size_t                validDeque  (PSnapshot * s, uint64_t off, uint64_t below, size_t level, int depth, PSnapMap * map);
+static size_t                validBuffer (PSnapshot * s, uint64_t off, uint64_t below, size_t level, int depth, PSnapMap * map);
+static size_t                validTriple (PSnapshot * s, uint64_t off, uint64_t below, size_t level, int depth, PSnapMap * map);
+static int                   bufSize     (PSnapshot * s, uint64_t off);
+static int                   checkedLen  (PSnapMap * map, uint64_t off, size_t level, int kind, size_t * len);
+static size_t                addLen      (size_t a, size_t b);
+static size_t                nodeToArray (PSnapshot * s, uint64_t off, VAL_TYPE * out);
+static size_t                listToArray (PSnapshot * s, uint64_t off, VAL_TYPE * out);
+static size_t                bufToArray  (PSnapshot * s, uint64_t off, VAL_TYPE * out);
+static PRBTreeNode         * loadNode    (PSnapshot * s, uint64_t off, PSnapMap * map);
+static PCList              * loadDeque   (PSnapshot * s, uint64_t off, PSnapMap * map);
+static PCListBuffer        * loadBuffer  (PSnapshot * s, uint64_t off, PSnapMap * map);
+static PCListElem          * loadTriple  (PSnapshot * s, uint64_t off, PSnapMap * map);
+static void                  initMap     (PSnapMap * map);
+static size_t                mapSlot     (PSnapMap * map, uint64_t key);
+static int                   mapGet      (PSnapMap * map, uint64_t key, uint64_t * val);
+static void                  mapPut      (PSnapMap * map, uint64_t key, uint64_t val);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes given versions of trees and deques to a snapshot file.
+ * Returns whether the whole file was written.
+ */
+int saveSnapshot (const char * path, PRBTree ** trees, size_t ntrees, PCList ** lists, size_t nlists)
+{
+  PSnapWriter w;
+  PSnapHeader h;
+  memset(&h, 0, sizeof(PSnapHeader));
+  w.f = fopen(path, "wb");
+  if (!w.f) return 0;
+  w.off = 0;
+  w.err = 0;
+  initMap(&w.map);
+  //the header is written again when the tables are known
+  writeRecord(&w, &h, sizeof(PSnapHeader));
+  uint64_t * roots = (uint64_t *)malloc((ntrees + nlists + 1) * sizeof(uint64_t));
+  for (size_t i = 0; i < ntrees; i++) roots[i] = writeNode(&w, trees[i]->root);
+  for (size_t i = 0; i < nlists; i++) roots[ntrees + i] = writeDeque(&w, lists[i]);
+  memcpy(h.magic, SNAP_MAGIC, sizeof(h.magic));
+  h.order = SNAP_ORDER;
+  h.val_size = sizeof(VAL_TYPE);
+  h.ntrees = ntrees;
+  h.nlists = nlists;
+  h.trees = writeRecord(&w, roots, ntrees * sizeof(uint64_t));
+  h.lists = writeRecord(&w, roots + ntrees, nlists * sizeof(uint64_t));
+  h.size = w.off;
+  if (fseek(w.f, 0, SEEK_SET) || fwrite(&h, sizeof(PSnapHeader), 1, w.f) != 1) w.err = 1;
+  if (fclose(w.f)) w.err = 1;
+  free(roots);
+  free(w.map.keys);
+  free(w.map.vals);
+  return !w.err;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Maps a snapshot file to memory (read-only). Returns NULL if it cannot be mapped,
+ * it is not a snapshot written by a machine of the same kind or its tables
+ * do not fit in it.
+ */
+PSnapshot * openSnapshot (const char * path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  void * base = MAP_FAILED;
+  if (!fstat(fd, &st) && (size_t)st.st_size >= sizeof(PSnapHeader))
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) return NULL;
+  const PSnapHeader * h = (const PSnapHeader *)base;
+  PSnapshot * ret = NULL;
+  if (!memcmp(h->magic, SNAP_MAGIC, sizeof(h->magic)) && h->order == SNAP_ORDER
+      && h->val_size == sizeof(VAL_TYPE) && h->size == (uint64_t)st.st_size)
+  {
+    ret = (PSnapshot *)malloc(sizeof(PSnapshot));
+    ret->base = (const char *)base;
+    ret->size = st.st_size;
+    ret->hdr = h;
+    if (!inFile(ret, h->trees, 0, ret->size) || h->ntrees > (ret->size - h->trees) / sizeof(uint64_t)
+        || !inFile(ret, h->lists, 0, ret->size) || h->nlists > (ret->size - h->lists) / sizeof(uint64_t))
+    {
+      free(ret);
+      ret = NULL;
+    }
+  }
+  if (!ret) munmap(base, st.st_size);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of versions of trees in a snapshot.
+ */
+size_t snapshotTrees (PSnapshot * s)
+{
+  return s->hdr->ntrees;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of versions of deques in a snapshot.
+ */
+size_t snapshotLists (PSnapshot * s)
+{
+  return s->hdr->nlists;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether i-th tree of a snapshot contains certain value or not,
+ * -1 if the path to it is corrupt.
+ */
+int snapshotFind (PSnapshot * s, size_t i, VAL_TYPE x)
+{
+  uint64_t below = s->hdr->trees, off = AT(s, below, uint64_t)[i];
+  for (int depth = 0; off; depth++)
+  {
+    if (depth == SNAP_TREE_DEPTH || !inFile(s, off, sizeof(PSnapNode), below)) return -1;
+    const PSnapNode * n = AT(s, off, PSnapNode);
+    below = off;
+    if (x < n->content) off = n->left;
+    else if (x > n->content) off = n->right;
+    else return 1;
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of values of i-th tree of a snapshot (SNAP_ERROR if its root is corrupt).
+ */
+size_t snapshotTreeSize (PSnapshot * s, size_t i)
+{
+  uint64_t off = AT(s, s->hdr->trees, uint64_t)[i];
+  if (!off) return 0;
+  return inFile(s, off, sizeof(PSnapNode), s->hdr->trees) ? AT(s, off, PSnapNode)->meta >> 1 : SNAP_ERROR;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes the values of i-th tree of a snapshot in ascending order to given array
+ * (of at least snapshotTreeSize values). Returns the number of values written,
+ * SNAP_ERROR if the tree is corrupt (nothing is written then).
+ */
+size_t snapshotTreeToArray (PSnapshot * s, size_t i, VAL_TYPE * out)
+{
+  PSnapMap map;
+  uint64_t off = AT(s, s->hdr->trees, uint64_t)[i];
+  initMap(&map);
+  int valid = validTree(s, off, &map);
+  free(map.keys);
+  free(map.vals);
+  return valid ? nodeToArray(s, off, out) : SNAP_ERROR;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the length of i-th deque of a snapshot (SNAP_ERROR if its record is corrupt).
+ */
+size_t snapshotListLength (PSnapshot * s, size_t i)
+{
+  return snapListLen(s, AT(s, s->hdr->lists, uint64_t)[i], s->hdr->lists);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the value at given position of i-th deque of a snapshot (NA if there is none
+ * or the path to it is corrupt). The descent is the one of nth.
+ */
+VAL_TYPE snapshotNth (PSnapshot * s, size_t i, size_t k)
+{
+  uint64_t off = AT(s, s->hdr->lists, uint64_t)[i];
+  size_t len = snapListLen(s, off, s->hdr->lists);
+  if (len == SNAP_ERROR || k >= len) return NA;
+  //every step goes to a record written before the current one
+  while (1)
+  {
+    const PSnapList * d = AT(s, off, PSnapList);
+    uint64_t part [5] = {d->p, d->l, d->m, d->r, d->s};
+    int c = 0;
+    for (; c < 4; c++)
+    {
+      len = (c & 1) ? snapListLen(s, part[c], off) : snapBufLen(s, part[c], off);
+      if (len == SNAP_ERROR) return NA;
+      if (k < len) break;
+      k -= len;
+    }
+    if (c & 1)
+    {
+      off = part[c];
+      continue;
+    }
+    //descend through buffers and triples until a value or a nested deque is reached
+    uint64_t b = part[c], above = off;
+    while (1)
+    {
+      const PSnapBuffer * buf = bufferAt(s, b, above);
+      if (!buf) return NA;
+      if (buf->is_leaf) return k < buf->size ? (VAL_TYPE)buf->slot[k] : NA;
+      uint32_t j = 0;
+      for (; j < buf->size; j++)
+      {
+        if (!inFile(s, buf->slot[j], sizeof(PSnapTriple), b)) return NA;
+        if (k < AT(s, buf->slot[j], PSnapTriple)->len) break;
+        k -= AT(s, buf->slot[j], PSnapTriple)->len;
+      }
+      if (j == buf->size) return NA;
+      const PSnapTriple * t = AT(s, buf->slot[j], PSnapTriple);
+      above = buf->slot[j];
+      size_t lenf = snapBufLen(s, t->fmb, above);
+      if (lenf == SNAP_ERROR) return NA;
+      if (k < lenf)
+      {
+        b = t->fmb;
+        continue;
+      }
+      k -= lenf;
+      size_t lenl = snapListLen(s, t->rl, above);
+      if (lenl == SNAP_ERROR) return NA;
+      if (k < lenl)
+      {
+        off = t->rl;
+        break;
+      }
+      k -= lenl;
+      b = t->lmb;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes the values of i-th deque of a snapshot from the front to given array
+ * (of at least snapshotListLength values). Returns the number of values written,
+ * SNAP_ERROR if the deque is corrupt (nothing is written then).
+ */
+size_t snapshotListToArray (PSnapshot * s, size_t i, VAL_TYPE * out)
+{
+  PSnapMap map;
+  uint64_t off = AT(s, s->hdr->lists, uint64_t)[i];
+  initMap(&map);
+  size_t len = validDeque(s, off, s->hdr->lists, 0, 0, &map);
+  free(map.keys);
+  free(map.vals);
+  return len == SNAP_ERROR ? SNAP_ERROR : listToArray(s, off, out);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Loads all trees of a snapshot to memory (to given array of snapshotTrees handles).
+ * Nodes shared in the file are shared by the loaded versions as well.
+ * Returns 0 if some tree is corrupt, nothing is loaded then.
+ */
+int snapshotLoadTrees (PSnapshot * s, PRBTree ** out)
+{
+  PSnapMap map;
+  const uint64_t * roots = AT(s, s->hdr->trees, uint64_t);
+  int valid = 1;
+  initMap(&map);
+  for (size_t i = 0; valid && i < s->hdr->ntrees; i++) valid = validTree(s, roots[i], &map);
+  free(map.keys);
+  free(map.vals);
+  if (!valid) return 0;
+  initMap(&map);
+  for (size_t i = 0; i < s->hdr->ntrees; i++)
+  {
+    out[i] = makeTree();
+    out[i]->root = loadNode(s, roots[i], &map);
+  }
+  free(map.keys);
+  free(map.vals);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Loads all deques of a snapshot to memory (to given array of snapshotLists handles),
+ * they are allocated as any other deque (see useArena). Parts shared in the file
+ * are shared by the loaded versions as well. Returns 0 if some deque is corrupt,
+ * nothing is loaded then.
+ */
+int snapshotLoadLists (PSnapshot * s, PCList ** out)
+{
+  PSnapMap map;
+  const uint64_t * roots = AT(s, s->hdr->lists, uint64_t);
+  int valid = 1;
+  initMap(&map);
+  for (size_t i = 0; valid && i < s->hdr->nlists; i++)
+    valid = validDeque(s, roots[i], s->hdr->lists, 0, 0, &map) != SNAP_ERROR;
+  free(map.keys);
+  free(map.vals);
+  if (!valid) return 0;
+  initMap(&map);
+  for (size_t i = 0; i < s->hdr->nlists; i++) out[i] = loadDeque(s, roots[i], &map);
+  free(map.keys);
+  free(map.vals);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Unmaps a snapshot. Nothing that was read in place may be used afterwards.
+ */
+void closeSnapshot (PSnapshot * s)
+{
+  if (!s) return;
+  munmap((void *)s->base, s->size);
+  free(s);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Appends a record to the file (all records are multiples of 8 bytes). Returns its offset.
+ */
+static uint64_t writeRecord (PSnapWriter * w, const void * rec, size_t size)
+{
+  uint64_t ret = w->off;
+  if (size && fwrite(rec, size, 1, w->f) != 1) w->err = 1;
+  w->off += size;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes a subtree unless it was written already. Returns the offset of its root.
+ */
+static uint64_t writeNode (PSnapWriter * w, PRBTreeNode * x)
+{
+  uint64_t ret;
+  if (isNull(x)) return 0;
+  if (mapGet(&w->map, (uint64_t)(uintptr_t)x, &ret)) return ret;
+  PSnapNode n;
+  n.left = writeNode(w, x->left);
+  n.right = writeNode(w, x->right);
+  n.content = x->content;
+  n.meta = x->size << 1 | x->colour;
+  ret = writeRecord(w, &n, sizeof(PSnapNode));
+  mapPut(&w->map, (uint64_t)(uintptr_t)x, ret);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes a deque unless it was written already. Returns its offset.
+ */
+static uint64_t writeDeque (PSnapWriter * w, PCList * d)
+{
+  uint64_t ret;
+  if (!d) return 0;
+  if (mapGet(&w->map, (uint64_t)(uintptr_t)d, &ret)) return ret;
+  PSnapList r;
+  r.p = writeBuffer(w, d->p);
+  r.l = writeDeque(w, d->l);
+  r.m = writeBuffer(w, d->m);
+  r.r = writeDeque(w, d->r);
+  r.s = writeBuffer(w, d->s);
+  r.len = d->len;
+  r.suffix_only = d->suffix_only;
+  ret = writeRecord(w, &r, sizeof(PSnapList));
+  mapPut(&w->map, (uint64_t)(uintptr_t)d, ret);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes a buffer unless it was written already. Returns its offset.
+ */
+static uint64_t writeBuffer (PSnapWriter * w, PCListBuffer * b)
+{
+  uint64_t ret;
+  if (!b) return 0;
+  if (mapGet(&w->map, (uint64_t)(uintptr_t)b, &ret)) return ret;
+  PSnapBuffer * r = (PSnapBuffer *)malloc(sizeof(PSnapBuffer) + b->size * sizeof(uint64_t));
+  r->size = b->size;
+  r->is_leaf = b->is_leaf;
+  for (int i = 0; i < b->size; i++)
+  {
+    PCListSlot x = getBufCont(b, i);
+    r->slot[i] = b->is_leaf ? (uint64_t)(int64_t)x.val : writeTriple(w, x.elem);
+  }
+  ret = writeRecord(w, r, sizeof(PSnapBuffer) + b->size * sizeof(uint64_t));
+  free(r);
+  mapPut(&w->map, (uint64_t)(uintptr_t)b, ret);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes a triple unless it was written already. Returns its offset.
+ */
+static uint64_t writeTriple (PSnapWriter * w, PCListElem * e)
+{
+  uint64_t ret;
+  if (mapGet(&w->map, (uint64_t)(uintptr_t)e, &ret)) return ret;
+  PSnapTriple r;
+  r.fmb = writeBuffer(w, e->fmb);
+  r.rl = writeDeque(w, e->rl);
+  r.lmb = writeBuffer(w, e->lmb);
+  r.len = e->len;
+  ret = writeRecord(w, &r, sizeof(PSnapTriple));
+  mapPut(&w->map, (uint64_t)(uintptr_t)e, ret);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether a record of given size at offset off is aligned and lies in the file
+ * behind the header and before offset below (where the record referring to it starts).
+ */
+static int inFile (PSnapshot * s, uint64_t off, uint64_t size, uint64_t below)
+{
+  return off >= sizeof(PSnapHeader) && off % 8 == 0 && below <= s->size && off <= below && size <= below - off;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the buffer at given offset if it lies in the file before offset below
+ * and it is not larger than any buffer can be, NULL otherwise.
+ */
+static const PSnapBuffer * bufferAt (PSnapshot * s, uint64_t off, uint64_t below)
+{
+  if (!inFile(s, off, sizeof(PSnapBuffer), below)) return NULL;
+  const PSnapBuffer * b = AT(s, off, PSnapBuffer);
+  if (b->size > PCLIST_BUF_CAP || !inFile(s, off, sizeof(PSnapBuffer) + b->size * sizeof(uint64_t), below)) return NULL;
+  return b;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the recorded length of a mapped deque lying before offset below, SNAP_ERROR
+ * if it does not.
+ */
+static size_t snapListLen (PSnapshot * s, uint64_t off, uint64_t below)
+{
+  if (!off) return 0;
+  return inFile(s, off, sizeof(PSnapList), below) ? AT(s, off, PSnapList)->len : SNAP_ERROR;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of values in a mapped buffer lying before offset below (see bufferLen),
+ * SNAP_ERROR if it or one of its triples does not lie so.
+ */
+static size_t snapBufLen (PSnapshot * s, uint64_t off, uint64_t below)
+{
+  if (!off) return 0;
+  const PSnapBuffer * b = bufferAt(s, off, below);
+  if (!b) return SNAP_ERROR;
+  if (b->is_leaf) return b->size;
+  size_t ret = 0;
+  for (uint32_t i = 0; i < b->size && ret != SNAP_ERROR; i++)
+    ret = inFile(s, b->slot[i], sizeof(PSnapTriple), off) ? addLen(ret, AT(s, b->slot[i], PSnapTriple)->len) : SNAP_ERROR;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Checks a mapped tree, the subtrees checked already are remembered in given map.
+ * Returns whether it is a red-black tree lying in the file before the table of trees.
+ */
+static int validTree (PSnapshot * s, uint64_t off, PSnapMap * map)
+{
+  return validNode(s, off, s->hdr->trees, NULL, NULL, 0, map) >= 0 && (!off || AT(s, off, PSnapNode)->meta & 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Checks a mapped subtree -- its records lie in the file before offset below, its values
+ * lie between *lo and *hi (NULL for no bound), its colours and sizes are those
+ * of a red-black tree. Returns its black height, or -1 if it is corrupt.
+ */
+static int validNode (PSnapshot * s, uint64_t off, uint64_t below, const VAL_TYPE * lo, const VAL_TYPE * hi, int depth, PSnapMap * map)
+{
+  uint64_t height;
+  if (!off) return 1;
+  if (depth == SNAP_TREE_DEPTH || !inFile(s, off, sizeof(PSnapNode), below)) return -1;
+  if (mapGet(map, off, &height))
+  {
+    //shared with a tree checked already, only its least and largest values are new to check
+    if ((lo && spineEnd(s, off, 0)->content <= *lo) || (hi && spineEnd(s, off, 1)->content >= *hi)) return -1;
+    return (int)height;
+  }
+  const PSnapNode * n = AT(s, off, PSnapNode);
+  if ((lo && n->content <= *lo) || (hi && n->content >= *hi)) return -1;
+  int l = validNode(s, n->left, off, lo, &n->content, depth + 1, map);
+  int r = validNode(s, n->right, off, &n->content, hi, depth + 1, map);
+  if (l < 0 || l != r) return -1;
+  const PSnapNode * x = n->left ? AT(s, n->left, PSnapNode) : NULL;
+  const PSnapNode * y = n->right ? AT(s, n->right, PSnapNode) : NULL;
+  if ((n->meta >> 1) != (x ? x->meta >> 1 : 0) + (y ? y->meta >> 1 : 0) + 1) return -1;
+  if (!(n->meta & 1) && ((x && !(x->meta & 1)) || (y && !(y->meta & 1)))) return -1;
+  mapPut(map, off, l + (n->meta & 1));
+  return l + (n->meta & 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the node holding the least (largest) value of a checked subtree.
+ */
+static const PSnapNode * spineEnd (PSnapshot * s, uint64_t off, int right)
+{
+  const PSnapNode * n = AT(s, off, PSnapNode);
+  while (right ? n->right : n->left) n = AT(s, right ? n->right : n->left, PSnapNode);
+  return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Checks a mapped deque whose buffers hold values of given level (0 for values,
+ * 1 for triples of values and so on), the parts checked already are remembered
+ * in given map. Its records have to lie in the file before offset below and be
+ * of the right kinds, their lengths have to add up and its shape has to be
+ * one of a deque. Returns its length, or SNAP_ERROR if it is corrupt.
+ */
+static size_t validDeque (PSnapshot * s, uint64_t off, uint64_t below, size_t level, int depth, PSnapMap * map)
+{
+  size_t len;
+  if (!off) return 0;
+  if (depth == SNAP_DEQUE_DEPTH || level > SNAP_LEVEL_MAX || !inFile(s, off, sizeof(PSnapList), below)) return SNAP_ERROR;
+  if (checkedLen(map, off, level, KIND_DEQUE, &len)) return len;
+  const PSnapList * d = AT(s, off, PSnapList);
+  len = validBuffer(s, d->p, off, level, depth + 1, map);
+  len = addLen(len, validDeque(s, d->l, off, level + 1, depth + 1, map));
+  len = addLen(len, validBuffer(s, d->m, off, level, depth + 1, map));
+  len = addLen(len, validDeque(s, d->r, off, level + 1, depth + 1, map));
+  len = addLen(len, validBuffer(s, d->s, off, level, depth + 1, map));
+  if (len == SNAP_ERROR || len != d->len) return SNAP_ERROR;
+  //the shape the deque operations rely on (see listPop and gPrefix)
+  if (d->suffix_only ? d->suffix_only > 1 || d->p || d->l || d->m || d->r || bufSize(s, d->s) < 1
+      : bufSize(s, d->p) < 3 || bufSize(s, d->p) > PCLIST_BUF_MAX || bufSize(s, d->m) != 2
+        || bufSize(s, d->s) < 3 || bufSize(s, d->s) > PCLIST_BUF_MAX) return SNAP_ERROR;
+  mapPut(map, off, PACK(len, level, KIND_DEQUE));
+  return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Checks a mapped buffer holding values of given level (see validDeque).
+ * Returns the number of values in it, or SNAP_ERROR if it is corrupt.
+ */
+static size_t validBuffer (PSnapshot * s, uint64_t off, uint64_t below, size_t level, int depth, PSnapMap * map)
+{
+  size_t len = 0;
+  if (!off) return 0;
+  const PSnapBuffer * b = bufferAt(s, off, below);
+  if (depth == SNAP_DEQUE_DEPTH || !b || b->is_leaf != (level == 0)) return SNAP_ERROR;
+  if (checkedLen(map, off, level, KIND_BUFFER, &len)) return len;
+  if (b->is_leaf) len = b->size;
+  for (uint32_t i = 0; !b->is_leaf && i < b->size; i++)
+    len = addLen(len, validTriple(s, b->slot[i], off, level - 1, depth + 1, map));
+  if (len == SNAP_ERROR) return SNAP_ERROR;
+  mapPut(map, off, PACK(len, level, KIND_BUFFER));
+  return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Checks a mapped triple of buffers holding values of given level (see validDeque).
+ * Returns the number of values in it, or SNAP_ERROR if it is corrupt.
+ */
+static size_t validTriple (PSnapshot * s, uint64_t off, uint64_t below, size_t level, int depth, PSnapMap * map)
+{
+  size_t len;
+  if (depth == SNAP_DEQUE_DEPTH || !inFile(s, off, sizeof(PSnapTriple), below)) return SNAP_ERROR;
+  if (checkedLen(map, off, level, KIND_TRIPLE, &len)) return len;
+  const PSnapTriple * t = AT(s, off, PSnapTriple);
+  len = validBuffer(s, t->fmb, off, level, depth + 1, map);
+  len = addLen(len, validDeque(s, t->rl, off, level + 1, depth + 1, map));
+  len = addLen(len, validBuffer(s, t->lmb, off, level, depth + 1, map));
+  if (len == SNAP_ERROR || len != t->len) return SNAP_ERROR;
+  //the shape the deque operations rely on (see gPrefix)
+  int f = bufSize(s, t->fmb), l = bufSize(s, t->lmb);
+  if ((t->rl ? !t->fmb || !t->lmb : !t->fmb && !t->lmb) || (t->fmb && (f < 2 || f > 3)) || (t->lmb && (l < 2 || l > 3)))
+    return SNAP_ERROR;
+  mapPut(map, off, PACK(len, level, KIND_TRIPLE));
+  return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of slots of a checked buffer (0 for none).
+ */
+static int bufSize (PSnapshot * s, uint64_t off)
+{
+  return off ? (int)AT(s, off, PSnapBuffer)->size : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Looks up a part of a deque checked already. Returns whether it was checked, its length
+ * is then stored (SNAP_ERROR if it was checked as a different kind or level).
+ */
+static int checkedLen (PSnapMap * map, uint64_t off, size_t level, int kind, size_t * len)
+{
+  uint64_t v;
+  if (!mapGet(map, off, &v)) return 0;
+  *len = (v & ((1 << 24) - 1)) == PACK(0, level, kind) ? (size_t)(v >> 24) : SNAP_ERROR;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Adds two lengths of parts of a deque, SNAP_ERROR stands for a corrupt part
+ * as well as for a sum no deque can have.
+ */
+static size_t addLen (size_t a, size_t b)
+{
+  if (a == SNAP_ERROR || b == SNAP_ERROR || b > SNAP_LEN_MAX - a) return SNAP_ERROR;
+  return a + b;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes the values of a mapped subtree in ascending order to given array.
+ */
+static size_t nodeToArray (PSnapshot * s, uint64_t off, VAL_TYPE * out)
+{
+  if (!off) return 0;
+  const PSnapNode * n = AT(s, off, PSnapNode);
+  size_t cnt = nodeToArray(s, n->left, out);
+  out[cnt++] = n->content;
+  return cnt + nodeToArray(s, n->right, out + cnt);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes the values of a mapped deque from the front to given array.
+ */
+static size_t listToArray (PSnapshot * s, uint64_t off, VAL_TYPE * out)
+{
+  if (!off) return 0;
+  const PSnapList * d = AT(s, off, PSnapList);
+  size_t cnt = bufToArray(s, d->p, out);
+  cnt += listToArray(s, d->l, out + cnt);
+  cnt += bufToArray(s, d->m, out + cnt);
+  cnt += listToArray(s, d->r, out + cnt);
+  return cnt + bufToArray(s, d->s, out + cnt);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Writes the values of a mapped buffer (and of its triples) to given array.
+ */
+static size_t bufToArray (PSnapshot * s, uint64_t off, VAL_TYPE * out)
+{
+  if (!off) return 0;
+  const PSnapBuffer * b = AT(s, off, PSnapBuffer);
+  size_t cnt = 0;
+  for (uint32_t i = 0; i < b->size; i++)
+  {
+    if (b->is_leaf)
+    {
+      out[cnt++] = (VAL_TYPE)b->slot[i];
+      continue;
+    }
+    const PSnapTriple * t = AT(s, b->slot[i], PSnapTriple);
+    cnt += bufToArray(s, t->fmb, out + cnt);
+    cnt += listToArray(s, t->rl, out + cnt);
+    cnt += bufToArray(s, t->lmb, out + cnt);
+  }
+  return cnt;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Loads a subtree, a node loaded already gets one more parent. Returns its root.
+ */
+static PRBTreeNode * loadNode (PSnapshot * s, uint64_t off, PSnapMap * map)
+{
+  uint64_t ret;
+  if (!off) return nullNode;
+  if (mapGet(map, off, &ret))
+  {
+    retainNode((PRBTreeNode *)(uintptr_t)ret);
+    return (PRBTreeNode *)(uintptr_t)ret;
+  }
+  const PSnapNode * n = AT(s, off, PSnapNode);
+  PRBTreeNode * x = makeNode(n->content);
+  x->colour = n->meta & 1;
+  x->size = n->meta >> 1;
+  x->left = loadNode(s, n->left, map);
+  x->right = loadNode(s, n->right, map);
+  x = internNode(x);
+  mapPut(map, off, (uint64_t)(uintptr_t)x);
+  return x;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Loads a deque unless it was loaded already. Returns it.
+ */
+static PCList * loadDeque (PSnapshot * s, uint64_t off, PSnapMap * map)
+{
+  uint64_t ret;
+  if (!off) return NULL;
+  if (mapGet(map, off, &ret)) return (PCList *)(uintptr_t)ret;
+  const PSnapList * r = AT(s, off, PSnapList);
+  PCList * d = (PCList *)pclistAlloc(sizeof(PCList));
+  d->p = loadBuffer(s, r->p, map);
+  d->l = loadDeque(s, r->l, map);
+  d->m = loadBuffer(s, r->m, map);
+  d->r = loadDeque(s, r->r, map);
+  d->s = loadBuffer(s, r->s, map);
+  d->len = r->len;
+  d->suffix_only = (int)r->suffix_only;
+  mapPut(map, off, (uint64_t)(uintptr_t)d);
+  return d;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Loads a buffer unless it was loaded already. Returns it.
+ */
+static PCListBuffer * loadBuffer (PSnapshot * s, uint64_t off, PSnapMap * map)
+{
+  uint64_t ret;
+  if (!off) return NULL;
+  if (mapGet(map, off, &ret)) return (PCListBuffer *)(uintptr_t)ret;
+  const PSnapBuffer * r = AT(s, off, PSnapBuffer);
+  PCListBuffer * b = makeBuffer(r->is_leaf, r->size);
+  b->size = r->size;
+  for (uint32_t i = 0; i < r->size; i++)
+  {
+    PCListSlot x;
+    if (r->is_leaf) x.val = (VAL_TYPE)r->slot[i];
+    else x.elem = loadTriple(s, r->slot[i], map);
+    setBufCont(b, x, i);
+  }
+  mapPut(map, off, (uint64_t)(uintptr_t)b);
+  return b;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Loads a triple unless it was loaded already. Returns it.
+ */
+static PCListElem * loadTriple (PSnapshot * s, uint64_t off, PSnapMap * map)
+{
+  uint64_t ret;
+  if (mapGet(map, off, &ret)) return (PCListElem *)(uintptr_t)ret;
+  const PSnapTriple * r = AT(s, off, PSnapTriple);
+  PCListElem * e = (PCListElem *)pclistAlloc(sizeof(PCListElem));
+  e->fmb = loadBuffer(s, r->fmb, map);
+  e->rl = loadDeque(s, r->rl, map);
+  e->lmb = loadBuffer(s, r->lmb, map);
+  e->len = r->len;
+  mapPut(map, off, (uint64_t)(uintptr_t)e);
+  return e;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Initializes an empty map.
+ */
+static void initMap (PSnapMap * map)
+{
+  map->cap = 1024;
+  map->cnt = 0;
+  map->keys = (uint64_t *)calloc(map->cap, sizeof(uint64_t));
+  map->vals = (uint64_t *)malloc(map->cap * sizeof(uint64_t));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the slot of the map holding given key, or the empty one where it belongs.
+ */
+static size_t mapSlot (PSnapMap * map, uint64_t key)
+{
+  size_t i = (size_t)((key >> 3) * 0x9e3779b97f4a7c15ULL >> 20) & (map->cap - 1);
+  while (map->keys[i] && map->keys[i] != key) i = (i + 1) & (map->cap - 1);
+  return i;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Looks up the value of given key. Returns whether it is in the map.
+ */
+static int mapGet (PSnapMap * map, uint64_t key, uint64_t * val)
+{
+  size_t i = mapSlot(map, key);
+  if (!map->keys[i]) return 0;
+  *val = map->vals[i];
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Adds a key (not in the map yet) with its value, the map is doubled when it is half full.
+ */
+static void mapPut (PSnapMap * map, uint64_t key, uint64_t val)
+{
+  if (2 * (map->cnt + 1) > map->cap)
+  {
+    PSnapMap old = *map;
+    map->cap *= 2;
+    map->keys = (uint64_t *)calloc(map->cap, sizeof(uint64_t));
+    map->vals = (uint64_t *)malloc(map->cap * sizeof(uint64_t));
+    for (size_t i = 0; i < old.cap; i++)
+      if (old.keys[i])
+      {
+        size_t j = mapSlot(map, old.keys[i]);
+        map->keys[j] = old.keys[i];
+        map->vals[j] = old.vals[i];
+      }
+    free(old.keys);
+    free(old.vals);
+  }
+  size_t i = mapSlot(map, key);
+  map->keys[i] = key;
+  map->vals[i] = val;
+  map->cnt++;
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,106 @@
+/*-------------------------------------------------------------*
+ * psnapshot.h - header for on-disk snapshots of versions of   *
+ *               persistent red-black trees and deques         *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PSNAPSHOT_H__
+#define __PSNAPSHOT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "common.h"
+
+/* First bytes of a snapshot file */
+#define SNAP_MAGIC "PSNAP01"
+
+/* Value written to a header to recognize files of a different byte order */
+#define SNAP_ORDER 0x01020304u
+
+/* Returned instead of a size by the reading functions when a file is corrupt */
+#define SNAP_ERROR ((size_t)-1)
+
+/* Records of a file refer to each other by offsets from its beginning (0 means
+   null), every record is aligned to 8 bytes. Shared parts of the versions
+   are written just once, each one before all records referring to it -- the
+   reading functions take a record behind its referrer for corruption. */
+
+/* Header at offset 0 -- the tables hold offsets of the roots of the versions */
+typedef struct
+{
+  char     magic[8];
+  uint32_t order;
+  uint32_t val_size;
+  uint64_t ntrees;
+  uint64_t nlists;
+  uint64_t trees;
+  uint64_t lists;
+  uint64_t size;
+} PSnapHeader;
+
+/* Node of a tree, meta holds the subtree size shifted left and the colour */
+typedef struct
+{
+  uint64_t left;
+  uint64_t right;
+  VAL_TYPE content;
+  uint32_t meta;
+} PSnapNode;
+
+/* Deque (see PCList) */
+typedef struct
+{
+  uint64_t p;
+  uint64_t l;
+  uint64_t m;
+  uint64_t r;
+  uint64_t s;
+  uint64_t len;
+  uint64_t suffix_only;
+} PSnapList;
+
+/* Buffer, its slots hold values (in leaves) or offsets of triples */
+typedef struct
+{
+  uint32_t size;
+  uint32_t is_leaf;
+  uint64_t slot[];
+} PSnapBuffer;
+
+/* Triple (see PCListElem) */
+typedef struct
+{
+  uint64_t fmb;
+  uint64_t rl;
+  uint64_t lmb;
+  uint64_t len;
+} PSnapTriple;
+
+/* Snapshot file mapped to memory */
+struct PSnapshot_struct
+{
+  const char        * base;
+  size_t              size;
+  const PSnapHeader * hdr;
+};
+
+int         saveSnapshot        (const char * path, PRBTree ** trees, size_t ntrees, PCList ** lists, size_t nlists);
+PSnapshot * openSnapshot        (const char * path);
+size_t      snapshotTrees       (PSnapshot * s);
+size_t      snapshotLists       (PSnapshot * s);
+int         snapshotFind        (PSnapshot * s, size_t i, VAL_TYPE x);
+size_t      snapshotTreeSize    (PSnapshot * s, size_t i);
+size_t      snapshotTreeToArray (PSnapshot * s, size_t i, VAL_TYPE * out);
+size_t      snapshotListLength  (PSnapshot * s, size_t i);
+VAL_TYPE    snapshotNth         (PSnapshot * s, size_t i, size_t k);
+size_t      snapshotListToArray (PSnapshot * s, size_t i, VAL_TYPE * out);
+int         snapshotLoadTrees   (PSnapshot * s, PRBTree ** out);
+int         snapshotLoadLists   (PSnapshot * s, PCList ** out);
+void        closeSnapshot       (PSnapshot * s);
+
+#endif /*__PSNAPSHOT_H__*/
@@ -0,0 +1,454 @@
+/*-------------------------------------------------------------*
+ * pversion.c - implementation of registries of versions of    *
+ *              persistent red-black trees and deques          *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ *
+ * A registry takes over the handles of a linear history of versions, numbers
+ * them and applies retention rules to them. Expired versions of trees are
+ * released one by one, the reference counts of their nodes free exactly
+ * the nodes no retained version can reach. Deques do not count references,
+ * so a registry of deques builds them in its own arena -- the retained versions
+ * are copied to a new arena (every shared part once) and the old one is freed.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "pversion.h"
+#include "pclist.h"
+#include "pclistarena.h"
+#include "pclistelem.h"
+#include "prbtree.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Map of parts of deques already copied by a compaction (open addressing) */
+typedef struct
+{
+  void  ** from;
+  void  ** to;
+  size_t   cap;
+  size_t   cnt;
+} PVersionMap;
+
+static PVersionReg  * makeRegistry (int kind);
+static long long      nowMs        (void);
+static size_t         findIndex    (PVersionReg * r, unsigned long id);
+static int            isRetained   (PVersionReg * r, PVersion * v, long long now);
+static void           compactLists (PVersionReg * r);
+static PCList       * copyDeque    (PCList * d, PVersionMap * map);
+static PCListBuffer * copyBuffer   (PCListBuffer * b, PVersionMap * map);
+static PCListElem   * copyTriple   (PCListElem * e, PVersionMap * map);
+static void        ** mapSlot      (PVersionMap * map, void * x);
+static void           mapPut       (PVersionMap * map, void * x, void * y);
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates an empty registry of versions of persistent red-black trees.
+ */
+PVersionReg * makeTreeRegistry (void)
+{
+  return makeRegistry(PVERSION_TREE);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates an empty registry of versions of deques together with its arena
+ * (of chunks of given size, 0 means default). All versions committed to the
+ * registry must be built in it -- the caller makes it current (useArena(r->arena)),
+ * the registry itself does not change the current arena.
+ */
+PVersionReg * makeListRegistry (size_t chunk_size)
+{
+  PVersionReg * ret = makeRegistry(PVERSION_LIST);
+  ret->arena = makeArena(chunk_size);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Registers given handle as the new latest version and takes it over. The timestamp
+ * (PVERSION_NOW for the current time) must not precede the one of the previous version,
+ * it is raised to it otherwise. Returns the number of the version.
+ */
+unsigned long commitVersion (PVersionReg * r, void * handle, long long ts)
+{
+  if (ts == PVERSION_NOW) ts = nowMs();
+  if (ts < r->last_ts) ts = r->last_ts;
+  if (r->cnt == r->cap)
+  {
+    r->cap = r->cap ? 2 * r->cap : 16;
+    r->list = (PVersion *)realloc(r->list, r->cap * sizeof(PVersion));
+  }
+  //the previous version, if retained, is valid until now
+  if (r->cnt && r->list[r->cnt - 1].id == r->last) r->list[r->cnt - 1].until = ts;
+  PVersion * v = &r->list[r->cnt++];
+  v->id = ++r->last;
+  v->ts = ts;
+  v->until = -1;
+  v->handle = handle;
+  v->pins = 0;
+  r->last_ts = ts;
+  return v->id;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Finds the handle of a version with given number. Returns whether it is retained.
+ * Handles of deques are valid until the next reclamation only.
+ */
+int getVersion (PVersionReg * r, unsigned long id, void ** handle)
+{
+  size_t i = findIndex(r, id);
+  if (i == r->cnt || r->list[i].id != id) return 0;
+  *handle = r->list[i].handle;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of the version which was the latest one at given time,
+ * or 0 if there was none or it has expired since. It takes O(log V) time.
+ */
+unsigned long versionAsOf (PVersionReg * r, long long ts)
+{
+  size_t lo = 0, hi = r->cnt;
+  //the first version with a later timestamp
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (r->list[mid].ts <= ts) lo = mid + 1;
+    else hi = mid;
+  }
+  if (!lo) return 0;
+  PVersion * v = &r->list[lo - 1];
+  if (v->until != -1 && v->until <= ts) return 0;
+  return v->id;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of the latest version (0 if there is none yet).
+ */
+unsigned long latestVersion (PVersionReg * r)
+{
+  return r->last;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of retained versions.
+ */
+size_t liveVersions (PVersionReg * r)
+{
+  return r->cnt;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Pins a retained version under given name, the name is moved if it pinned another one.
+ * Returns whether the version was tagged (it is retained).
+ */
+int tagVersion (PVersionReg * r, const char * name, unsigned long id)
+{
+  size_t i = findIndex(r, id);
+  if (i == r->cnt || r->list[i].id != id) return 0;
+  untagVersion(r, name);
+  r->tags = (PVersionTag *)realloc(r->tags, (r->ntags + 1) * sizeof(PVersionTag));
+  r->tags[r->ntags].name = (char *)malloc(strlen(name) + 1);
+  strcpy(r->tags[r->ntags].name, name);
+  r->tags[r->ntags++].id = id;
+  r->list[i].pins++;
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Removes a tag, the version it pinned may then expire. Returns whether the tag existed.
+ */
+int untagVersion (PVersionReg * r, const char * name)
+{
+  for (size_t j = 0; j < r->ntags; j++)
+  {
+    if (strcmp(r->tags[j].name, name)) continue;
+    r->list[findIndex(r, r->tags[j].id)].pins--;
+    free(r->tags[j].name);
+    r->tags[j] = r->tags[--r->ntags];
+    return 1;
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the number of the version pinned by given name (0 if there is no such tag).
+ */
+unsigned long taggedVersion (PVersionReg * r, const char * name)
+{
+  for (size_t j = 0; j < r->ntags; j++)
+    if (!strcmp(r->tags[j].name, name)) return r->tags[j].id;
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Sets the retention rules of a registry, they are applied by reclaimVersions.
+ */
+void setRetention (PVersionReg * r, PVersionPolicy policy)
+{
+  r->policy = policy;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Removes the versions which are not retained at given time (PVERSION_NOW for
+ * the current one) and frees the memory only they used. Handles of deques
+ * held by the caller are not valid afterwards, they have to be looked up again,
+ * and deques built in the arena of the registry but not committed are freed.
+ * Returns the number of removed versions.
+ */
+size_t reclaimVersions (PVersionReg * r, long long now)
+{
+  if (now == PVERSION_NOW) now = nowMs();
+  size_t cnt = 0;
+  for (size_t i = 0; i < r->cnt; i++)
+  {
+    if (isRetained(r, &r->list[i], now)) r->list[cnt++] = r->list[i];
+    else if (r->kind == PVERSION_TREE) releaseTree((PRBTree *)r->list[i].handle);
+  }
+  size_t ret = r->cnt - cnt;
+  r->cnt = cnt;
+  if (ret && r->kind == PVERSION_LIST) compactLists(r);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Releases a registry together with all retained versions.
+ */
+void releaseRegistry (PVersionReg * r)
+{
+  if (!r) return;
+  if (r->kind == PVERSION_TREE)
+    for (size_t i = 0; i < r->cnt; i++) releaseTree((PRBTree *)r->list[i].handle);
+  else releaseArena(r->arena);
+  for (size_t j = 0; j < r->ntags; j++) free(r->tags[j].name);
+  free(r->tags);
+  free(r->list);
+  free(r);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Creates an empty registry of given kind without retention rules.
+ */
+static PVersionReg * makeRegistry (int kind)
+{
+  PVersionReg * ret = (PVersionReg *)malloc(sizeof(PVersionReg));
+  ret->kind = kind;
+  ret->list = NULL;
+  ret->cnt = 0;
+  ret->cap = 0;
+  ret->last = 0;
+  ret->last_ts = 0;
+  ret->tags = NULL;
+  ret->ntags = 0;
+  ret->policy.keep_last = 0;
+  ret->policy.keep_every = 0;
+  ret->policy.ttl = 0;
+  ret->arena = NULL;
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the current time of the real-time clock in milliseconds.
+ */
+static long long nowMs (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the position of the first retained version with number at least id.
+ */
+static size_t findIndex (PVersionReg * r, unsigned long id)
+{
+  size_t lo = 0, hi = r->cnt;
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (r->list[mid].id < id) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns whether a version is retained at given time by the rules of its registry.
+ */
+static int isRetained (PVersionReg * r, PVersion * v, long long now)
+{
+  PVersionPolicy * p = &r->policy;
+  if (!p->keep_last && !p->keep_every && !p->ttl) return 1;
+  if (v->pins || v->id == r->last) return 1;
+  if (p->keep_last && r->last - v->id < p->keep_last) return 1;
+  if (p->keep_every && v->id % p->keep_every == 0) return 1;
+  return p->ttl && now - v->ts < p->ttl;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Copies the retained versions of deques to a new arena and frees the old one together
+ * with the deques built in it, which were not committed.
+ */
+static void compactLists (PVersionReg * r)
+{
+  PCListArena * old = r->arena;
+  PVersionMap map;
+  map.cap = 1024;
+  map.cnt = 0;
+  map.from = (void **)calloc(map.cap, sizeof(void *));
+  map.to = (void **)malloc(map.cap * sizeof(void *));
+  r->arena = makeArena(old->chunk_size);
+  PCListArena * prev = useArena(r->arena);
+  for (size_t i = 0; i < r->cnt; i++) r->list[i].handle = copyDeque((PCList *)r->list[i].handle, &map);
+  //the previous arena is current again, unless it was the old one, which is replaced by the new one
+  useArena(prev == old ? r->arena : prev);
+  releaseArena(old);
+  free(map.from);
+  free(map.to);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a copy of a deque in the current arena, the parts copied already are reused.
+ */
+static PCList * copyDeque (PCList * d, PVersionMap * map)
+{
+  if (!d) return d;
+  void ** slot = mapSlot(map, d);
+  if (*slot) return (PCList *)map->to[slot - map->from];
+  PCList * ret = (PCList *)pclistAlloc(sizeof(PCList));
+  *ret = *d;
+  ret->p = copyBuffer(d->p, map);
+  ret->l = copyDeque(d->l, map);
+  ret->m = copyBuffer(d->m, map);
+  ret->r = copyDeque(d->r, map);
+  ret->s = copyBuffer(d->s, map);
+  mapPut(map, d, ret);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a copy of a buffer in the current arena (see copyDeque).
+ */
+static PCListBuffer * copyBuffer (PCListBuffer * b, PVersionMap * map)
+{
+  if (!b) return b;
+  void ** slot = mapSlot(map, b);
+  if (*slot) return (PCListBuffer *)map->to[slot - map->from];
+  PCListBuffer * ret = makeBuffer(b->is_leaf, b->size);
+  ret->size = b->size;
+  for (int i = 0; i < b->size; i++)
+  {
+    PCListSlot x = getBufCont(b, i);
+    if (!b->is_leaf) x.elem = copyTriple(x.elem, map);
+    setBufCont(ret, x, i);
+  }
+  mapPut(map, b, ret);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns a copy of a triple in the current arena (see copyDeque).
+ */
+static PCListElem * copyTriple (PCListElem * e, PVersionMap * map)
+{
+  if (!e) return e;
+  void ** slot = mapSlot(map, e);
+  if (*slot) return (PCListElem *)map->to[slot - map->from];
+  PCListElem * ret = (PCListElem *)pclistAlloc(sizeof(PCListElem));
+  *ret = *e;
+  ret->fmb = copyBuffer(e->fmb, map);
+  ret->rl = copyDeque(e->rl, map);
+  ret->lmb = copyBuffer(e->lmb, map);
+  mapPut(map, e, ret);
+  return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Returns the slot of the map holding given part, or the empty slot where it belongs.
+ */
+static void ** mapSlot (PVersionMap * map, void * x)
+{
+  size_t i = (size_t)(((uint64_t)(uintptr_t)x >> 3) * 0x9e3779b97f4a7c15ULL >> 20) & (map->cap - 1);
+  while (map->from[i] && map->from[i] != x) i = (i + 1) & (map->cap - 1);
+  return &map->from[i];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Records the copy y of part x, the map is doubled when it is half full.
+ */
+static void mapPut (PVersionMap * map, void * x, void * y)
+{
+  if (2 * (map->cnt + 1) > map->cap)
+  {
+    PVersionMap old = *map;
+    map->cap *= 2;
+    map->from = (void **)calloc(map->cap, sizeof(void *));
+    map->to = (void **)malloc(map->cap * sizeof(void *));
+    for (size_t i = 0; i < old.cap; i++)
+      if (old.from[i])
+      {
+        void ** slot = mapSlot(map, old.from[i]);
+        *slot = old.from[i];
+        map->to[slot - map->from] = old.to[i];
+      }
+    free(old.from);
+    free(old.to);
+  }
+  void ** slot = mapSlot(map, x);
+  *slot = x;
+  map->to[slot - map->from] = y;
+  map->cnt++;
+}
+
+/*---------------------------------------------------------------------------*/
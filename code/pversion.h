@@ -0,0 +1,88 @@
+/*-------------------------------------------------------------*
+ * pversion.h - header for registries of versions of           *
+ *              persistent red-black trees and deques          *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __PVERSION_H__
+#define __PVERSION_H__
+
+#include <stddef.h>
+#include "common.h"
+
+/* Kinds of structures whose versions a registry keeps */
+#define PVERSION_TREE 0
+#define PVERSION_LIST 1
+
+/* Timestamp standing for the current time (in milliseconds of the real-time clock) */
+#define PVERSION_NOW -1
+
+/* One registered version, it is valid from its timestamp until the timestamp
+   of the following version (the latest one is valid until further notice) */
+typedef struct
+{
+  unsigned long id;
+  long long     ts;
+  long long     until;
+  void        * handle;
+  int           pins;
+} PVersion;
+
+/* Name pinning a version */
+typedef struct
+{
+  char        * name;
+  unsigned long id;
+} PVersionTag;
+
+/* Retention rules (0 disables a rule) -- a version is retained when it is one of
+   the last keep_last ones, its number is a multiple of keep_every, it is younger
+   than ttl (in the units of the timestamps), it is tagged or it is the latest one.
+   Without any rule all versions are retained. */
+typedef struct
+{
+  size_t    keep_last;
+  size_t    keep_every;
+  long long ttl;
+} PVersionPolicy;
+
+/* Versions are kept in the order of their numbers (and timestamps), the expired
+   ones are removed. A registry of deques owns the arena they are built in, which
+   the caller makes current (see useArena). reclaimVersions moves the retained
+   versions to a new arena and frees the old one -- deques built in it but not
+   committed die with it, and the current arena of the calling thread follows
+   the registry if it was the old one. */
+struct PVersionReg_struct
+{
+  int              kind;
+  PVersion       * list;
+  size_t           cnt;
+  size_t           cap;
+  unsigned long    last;
+  long long        last_ts;
+  PVersionTag    * tags;
+  size_t           ntags;
+  PVersionPolicy   policy;
+  PCListArena    * arena;
+};
+
+PVersionReg * makeTreeRegistry (void);
+PVersionReg * makeListRegistry (size_t chunk_size);
+unsigned long commitVersion    (PVersionReg * r, void * handle, long long ts);
+int           getVersion       (PVersionReg * r, unsigned long id, void ** handle);
+unsigned long versionAsOf      (PVersionReg * r, long long ts);
+unsigned long latestVersion    (PVersionReg * r);
+size_t        liveVersions     (PVersionReg * r);
+int           tagVersion       (PVersionReg * r, const char * name, unsigned long id);
+int           untagVersion     (PVersionReg * r, const char * name);
+unsigned long taggedVersion    (PVersionReg * r, const char * name);
+void          setRetention     (PVersionReg * r, PVersionPolicy policy);
+size_t        reclaimVersions  (PVersionReg * r, long long now);
+void          releaseRegistry  (PVersionReg * r);
+
+#endif /*__PVERSION_H__*/
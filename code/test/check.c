@@ -0,0 +1,163 @@
+/*-------------------------------------------------------------*
+ * check.c - helpers shared by the model checks                *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "check.h"
+
+#ifdef PRBTREE_BTREE
+static int checkNodes (PBTreeNode * x, long lo, long hi, int root, int * cnt);
+#else
+static int checkNodes (PRBTreeNode * x, long lo, long hi, int * cnt);
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Simple xorshift generator, so that the threads do not share rand() state.
+ */
+unsigned int nextRand (unsigned int * s)
+{
+  *s ^= *s << 13;
+  *s ^= *s >> 17;
+  *s ^= *s << 5;
+  return *s;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Checks that given tree is a red-black tree (a B+-tree with PRBTREE_BTREE)
+ * holding exactly the keys of the model (has[k] for keys 0 .. keys - 1).
+ */
+void checkTree (PRBTree * t, const char * has, int keys)
+{
+  int cnt = 0, expected = 0;
+#ifdef PRBTREE_BTREE
+  if (t->root) checkNodes(t->root, -1, keys, 1, &cnt);
+#else
+  CHECK(isNull(t->root) || t->root->colour == BLACK);
+  checkNodes(t->root, -1, keys, &cnt);
+#endif
+  for (int k = 0; k < keys; k++)
+  {
+    expected += has[k];
+    CHECK(find(t, k) == has[k]);
+  }
+  CHECK(cnt == expected);
+  CHECK(!find(t, -1) && !find(t, keys));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Applies a random update (push, pop, inject, eject or catenation with itself)
+ * to given deque and to its model, returns the new version.
+ */
+PCList * updateList (PCList * d, ListModel * m, unsigned int * seed)
+{
+  VAL_TYPE x = nextRand(seed) % 1000;
+  switch (nextRand(seed) % 9)
+  {
+    case 0: case 1:
+      if (m->len == LIST_MAX) return d;
+      memmove(m->val + 1, m->val, m->len * sizeof(VAL_TYPE));
+      m->val[0] = x;
+      m->len++;
+      return push(d, x);
+    case 2: case 3:
+      if (m->len == LIST_MAX) return d;
+      m->val[m->len++] = x;
+      return inject(d, x);
+    case 4: case 5:
+      if (!m->len) return d;
+      d = pop(d, &x);
+      CHECK(x == m->val[0]);
+      memmove(m->val, m->val + 1, --m->len * sizeof(VAL_TYPE));
+      return d;
+    case 6: case 7:
+      if (!m->len) return d;
+      d = eject(d, &x);
+      CHECK(x == m->val[--m->len]);
+      return d;
+    default:
+      if (2 * m->len > LIST_MAX) return d;
+      memcpy(m->val + m->len, m->val, m->len * sizeof(VAL_TYPE));
+      m->len *= 2;
+      return catenate(d, d);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Checks that given deque holds exactly the values of the model (it pops them all,
+ * the deque itself stays untouched).
+ */
+void checkList (PCList * d, const ListModel * m)
+{
+  for (int i = 0; i < m->len; i++)
+  {
+    VAL_TYPE x;
+    CHECK(d);
+    d = pop(d, &x);
+    CHECK(x == m->val[i]);
+  }
+  CHECK(!d);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef PRBTREE_BTREE
+
+/**
+ * Checks the order, the fill, the padding and the references of a subtree with values
+ * in [lo, hi), counts its values and returns its height (all leaves have the same depth).
+ */
+static int checkNodes (PBTreeNode * x, long lo, long hi, int root, int * cnt)
+{
+  CHECK(__atomic_load_n(&x->refs, __ATOMIC_RELAXED) > 0);
+  CHECK(x->cnt <= BTREE_KEYS && x->cnt >= (root ? 1 : BTREE_MIN));
+  for (int i = 0; i < x->cnt; i++)
+    CHECK(lo <= x->keys[i] && x->keys[i] < hi && (i == 0 || x->keys[i - 1] < x->keys[i]));
+  for (int i = x->cnt; i < BTREE_KEYS; i++) CHECK(x->keys[i] == INT32_MAX);
+  if (x->leaf)
+  {
+    *cnt += x->cnt;
+    return 1;
+  }
+  int h = checkNodes(x->child[0], lo, x->keys[0], 0, cnt);
+  for (int i = 1; i <= x->cnt; i++)
+    CHECK(checkNodes(x->child[i], x->keys[i - 1], i < x->cnt ? x->keys[i] : hi, 0, cnt) == h);
+  return h + 1;
+}
+
+#else
+
+/**
+ * Checks the order, the colours, the references and the sizes of a subtree
+ * with values in (lo, hi), counts its nodes and returns its black height.
+ */
+static int checkNodes (PRBTreeNode * x, long lo, long hi, int * cnt)
+{
+  if (isNull(x)) return 1;
+  CHECK(__atomic_load_n(&x->refs, __ATOMIC_RELAXED) > 0);
+  CHECK(lo < x->content && x->content < hi);
+  if (x->colour == RED)
+    CHECK(x->left->colour == BLACK && x->right->colour == BLACK);
+  (*cnt)++;
+  int l = checkNodes(x->left, lo, x->content, cnt);
+  int r = checkNodes(x->right, x->content, hi, cnt);
+  CHECK(l == r);
+  CHECK(x->size == x->left->size + x->right->size + 1);
+  return l + (x->colour == BLACK);
+}
+
+#endif /*PRBTREE_BTREE*/
@@ -0,0 +1,38 @@
+/*-------------------------------------------------------------*
+ * check.h - header of helpers shared by the model checks      *
+ *-------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent *
+ * data structures and their applications.                     *
+ *                                                             *
+ * Author: Josef Malík                                         *
+ *-------------------------------------------------------------*
+ */
+
+#ifndef __CHECK_H__
+#define __CHECK_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pclist.h"
+#include "prbtree.h"
+
+/* Largest length of a modelled deque */
+#define LIST_MAX 4096
+
+/* Model of a deque -- its values from the front */
+typedef struct
+{
+  VAL_TYPE val[LIST_MAX];
+  int      len;
+} ListModel;
+
+/* Stops the check when a condition does not hold */
+#define CHECK(c) \
+  do { if (!(c)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+unsigned int nextRand   (unsigned int * s);
+void         checkTree  (PRBTree * t, const char * has, int keys);
+PCList     * updateList (PCList * d, ListModel * m, unsigned int * seed);
+void         checkList  (PCList * d, const ListModel * m);
+
+#endif /*__CHECK_H__*/
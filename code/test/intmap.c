@@ -0,0 +1,104 @@
+/*---------------------------------------------------------------------*
+ * intmap.c - model check of persistent ordered maps (IntMap)          *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "intmap.h"
+
+#define KEYS     512
+#define VERSIONS 16
+#define OPS      20000
+
+/* Model of a map -- the value of every key (NA is no value) */
+typedef struct
+{
+  double val[KEYS];
+} MapModel;
+
+/**
+ * Checks the order, the colours and the references of a subtree of a map
+ * with keys in (lo, hi), returns its black height.
+ */
+static int checkMapNodes (IntMapNode * x, long lo, long hi)
+{
+  if (x == &IntMapSentinel) return 1;
+  CHECK(x->refs > 0);
+  CHECK(lo < x->key && x->key < hi);
+  if (x->colour == RED) CHECK(x->left->colour == BLACK && x->right->colour == BLACK);
+  int l = checkMapNodes(x->left, lo, x->key);
+  CHECK(l == checkMapNodes(x->right, x->key, hi));
+  return l + (x->colour == BLACK);
+}
+
+/**
+ * Checks that given map holds exactly the values of the model.
+ */
+static void checkMap (IntMap * t, const MapModel * m)
+{
+  CHECK(t->root->colour == BLACK);
+  checkMapNodes(t->root, -1, KEYS);
+  for (int k = -1; k <= KEYS; k++)
+  {
+    const double * v = IntMapGet(t, k);
+    if (k < 0 || k == KEYS || m->val[k] == NA) CHECK(!v);
+    else CHECK(v && *v == m->val[k]);
+  }
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static IntMap * map [VERSIONS];
+  static MapModel model [VERSIONS], m;
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      map[v] = IntMapMake();
+      for (int k = 0; k < KEYS; k++) model[v].val[k] = NA;
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS;
+      int k = nextRand(&seed) % KEYS;
+      m = model[a];
+      IntMap * t;
+      //upserts replace the values of present keys, too
+      if (nextRand(&seed) % 3)
+      {
+        double v = (nextRand(&seed) % 1000) / 4.0;
+        t = IntMapUpsert(map[a], k, v);
+        m.val[k] = v;
+      }
+      else
+      {
+        t = IntMapErase(map[a], k);
+        m.val[k] = NA;
+      }
+      if (i % 20 == 0)
+      {
+        checkMap(t, &m);
+        checkMap(map[a], &model[a]);
+      }
+      IntMapRelease(map[b]);
+      map[b] = t;
+      model[b] = m;
+    }
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      checkMap(map[v], &model[v]);
+      IntMapRelease(map[v]);
+    }
+  }
+  printf("intmap: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*---------------------------------------------------------------------*
+ * pbtree.c - model check of persistent B+-trees behind the entry      *
+ *            points of prbtree.h (built with -DPRBTREE_BTREE)         *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+
+#define KEYS     2048
+#define VERSIONS 12
+#define OPS      6000
+
+/* Live blocks are counted by wrapping malloc and free at link time (-Wl,--wrap=...) */
+void * __real_malloc (size_t size);
+void   __real_free   (void * p);
+static long live = 0;
+
+void * __wrap_malloc (size_t size)
+{
+  live++;
+  return __real_malloc(size);
+}
+
+void __wrap_free (void * p)
+{
+  if (p) live--;
+  __real_free(p);
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PRBTree * tree [VERSIONS];
+  static char has [VERSIONS][KEYS], h [KEYS];
+  long start = live;
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      tree[v] = makeTree();
+      memset(has[v], 0, KEYS);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS;
+      //runs of updates grow and shrink the trees by many levels, keys outside the model are searched too
+      int n = 1 + nextRand(&seed) % (i % 20 ? 4 : 600);
+      int ins = (i / 500 + r) % 3 != 2;
+      PRBTree * t = tree[a];
+      memcpy(h, has[a], KEYS);
+      for (int j = 0; j < n; j++)
+      {
+        VAL_TYPE x = nextRand(&seed) % KEYS;
+        int up = nextRand(&seed) % 4 ? ins : !ins;
+        PRBTree * tnew = up ? insert(t, x) : erase(t, x);
+        if (t != tree[a]) releaseTree(t);
+        t = tnew;
+        h[x] = up;
+      }
+      checkTree(t, h, KEYS);
+      checkTree(tree[a], has[a], KEYS);
+      releaseTree(tree[b]);
+      tree[b] = t;
+      memcpy(has[b], h, KEYS);
+    }
+    for (int v = 0; v < VERSIONS; v++) releaseTree(tree[v]);
+    //nodes made and dropped by the updates were freed as well
+    CHECK(live == start);
+  }
+  printf("pbtree: %d rounds ok\n", rounds);
+  return 0;
+}
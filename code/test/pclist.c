@@ -0,0 +1,49 @@
+/*---------------------------------------------------------------------*
+ * pclist.c - model check of persistent deques, updates are applied    *
+ *            to random older versions, every round in its own arena   *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include "check.h"
+#include "pclistarena.h"
+
+#define VERSIONS 24
+#define OPS      5000
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PCList * list [VERSIONS];
+  static ListModel model [VERSIONS], m;
+  for (int r = 0; r < rounds; r++)
+  {
+    //the versions of a round are dropped with its arena
+    PCListArena * a = makeArena(0);
+    useArena(a);
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      list[v] = NULL;
+      model[v].len = 0;
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS;
+      m = model[a];
+      list[b] = updateList(list[a], &m, &seed);
+      model[b] = m;
+      if (i % 500 == 0)
+        for (int v = 0; v < VERSIONS; v++) checkList(list[v], &model[v]);
+    }
+    for (int v = 0; v < VERSIONS; v++) checkList(list[v], &model[v]);
+    useArena(NULL);
+    releaseArena(a);
+  }
+  printf("pclist: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,84 @@
+/*---------------------------------------------------------------------*
+ * pclist_arena.c - model check of deque versions kept in arenas,      *
+ *                  every thread with its own arena                    *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <pthread.h>
+
+#include "check.h"
+#include "pclistarena.h"
+
+#define THREADS  4
+#define GENS     20
+#define VERSIONS 16
+#define OPS      100
+
+/* Work of one thread -- the base deque (allocated by malloc) and the versions of a generation */
+typedef struct
+{
+  PCList *     base;
+  ListModel    base_model;
+  unsigned int seed;
+  PCList *     list[VERSIONS];
+  ListModel    model[VERSIONS];
+} Work;
+
+/**
+ * Body of a thread -- every generation derives versions of the base deque in a new
+ * arena, checks them and drops the whole arena at once.
+ */
+static void * generations (void * arg)
+{
+  Work * w = (Work *)arg;
+  for (int g = 0; g < GENS; g++)
+  {
+    PCListArena * a = makeArena(g % 2 ? 256 : 0);
+    CHECK(useArena(a) == NULL);
+    PCList * d = w->base;
+    ListModel m = w->base_model;
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      for (int i = 0; i < OPS; i++) d = updateList(d, &m, &w->seed);
+      w->list[v] = d;
+      w->model[v] = m;
+    }
+    for (int v = 0; v < VERSIONS; v++) checkList(w->list[v], &w->model[v]);
+    CHECK(a->bytes > 0);
+    CHECK(useArena(NULL) == a);
+    releaseArena(a);
+    //the base deque does not depend on the released arena
+    checkList(w->base, &w->base_model);
+  }
+  return NULL;
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  Work * w = (Work *)malloc(THREADS * sizeof(Work));
+  for (int r = 0; r < rounds; r++)
+  {
+    pthread_t th [THREADS];
+    for (int i = 0; i < THREADS; i++)
+    {
+      w[i].base = NULL;
+      w[i].base_model.len = 0;
+      w[i].seed = seed + r * THREADS + i;
+      for (int k = 0; k < 500; k++) w[i].base = updateList(w[i].base, &w[i].base_model, &w[i].seed);
+      pthread_create(&th[i], NULL, generations, &w[i]);
+    }
+    for (int i = 0; i < THREADS; i++) pthread_join(th[i], NULL);
+    //the arenas of the threads never became the one of the main thread
+    CHECK(useArena(NULL) == NULL);
+  }
+  free(w);
+  printf("pclist_arena: %d rounds ok\n", rounds);
+  return 0;
+}
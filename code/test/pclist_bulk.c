@@ -0,0 +1,76 @@
+/*---------------------------------------------------------------------*
+ * pclist_bulk.c - model check of deques built from arrays and of      *
+ *                 pushMany/injectMany                                 *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "pclistarena.h"
+
+#define OPS 400
+
+/**
+ * Applies random updates to a deque and checks it against its model afterwards, so that the layout made by the bulk build is exercised by the usual operations.
+ */
+static void updateAll (PCList * d, ListModel * m, unsigned int * seed)
+{
+  for (int i = 0; i < OPS; i++) d = updateList(d, m, seed);
+  checkList(d, m);
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static ListModel m, model;
+  static VAL_TYPE a [LIST_MAX];
+  for (int r = 0; r < rounds; r++)
+  {
+    //every small length and some random ones, each one in its own arena
+    for (int n = 0; n < 400 + 8; n++)
+    {
+      PCListArena * arena = makeArena(0);
+      useArena(arena);
+      m.len = n < 400 ? n : (int)(nextRand(&seed) % (LIST_MAX / 2));
+      for (int i = 0; i < m.len; i++) a[i] = m.val[i] = nextRand(&seed) % 1000;
+      PCList * d = pclistFromArray(a, m.len);
+      checkList(d, &m);
+      model = m;
+      updateAll(d, &model, &seed);
+      //the built deque is an immutable version too
+      checkList(d, &m);
+      //values added to both ends of a random version of it
+      for (int k = 0; k < 3; k++)
+      {
+        PCList * e = d;
+        model = m;
+        for (int i = nextRand(&seed) % 50; i > 0; i--) e = updateList(e, &model, &seed);
+        size_t cnt = nextRand(&seed) % (k < 2 ? 20 : LIST_MAX / 4);
+        if (cnt > (size_t)(LIST_MAX - model.len)) cnt = LIST_MAX - model.len;
+        for (size_t i = 0; i < cnt; i++) a[i] = nextRand(&seed) % 1000;
+        int front = nextRand(&seed) & 1;
+        PCList * f = front ? pushMany(e, a, cnt) : injectMany(e, a, cnt);
+        if (front)
+        {
+          memmove(model.val + cnt, model.val, model.len * sizeof(VAL_TYPE));
+          memcpy(model.val, a, cnt * sizeof(VAL_TYPE));
+        }
+        else memcpy(model.val + model.len, a, cnt * sizeof(VAL_TYPE));
+        model.len += cnt;
+        checkList(f, &model);
+        updateAll(f, &model, &seed);
+      }
+      useArena(NULL);
+      releaseArena(arena);
+    }
+  }
+  printf("pclist_bulk: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*---------------------------------------------------------------------*
+ * pclist_iter.c - model check of deque cursors, batched export and    *
+ *                 front/back peeks                                    *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "pclistarena.h"
+#include "pclistiter.h"
+
+#define OPS   3000
+#define PIECE (PCLIST_SUFFIX_MAX + 4)
+
+static VAL_TYPE out [LIST_MAX + 1];
+
+/**
+ * Checks all ways of reading given deque against its model.
+ */
+static void checkRead (PCList * d, const ListModel * m, unsigned int * seed)
+{
+  PCListIter it;
+  VAL_TYPE x;
+  CHECK(front(d) == (m->len ? m->val[0] : NA));
+  CHECK(back(d) == (m->len ? m->val[m->len - 1] : NA));
+  //one value at a time in both directions
+  for (int backward = 0; backward <= 1; backward++)
+  {
+    initIter(&it, d, backward);
+    for (int i = 0; i < m->len; i++)
+    {
+      CHECK(iterNext(&it, &x));
+      CHECK(x == m->val[backward ? m->len - 1 - i : i]);
+    }
+    CHECK(!iterNext(&it, &x));
+    endIter(&it);
+  }
+  //batches of random sizes
+  int backward = nextRand(seed) & 1;
+  size_t done = 0, k;
+  initIter(&it, d, backward);
+  while ((k = nextBatch(&it, out + done, 1 + nextRand(seed) % 40)) > 0) done += k;
+  endIter(&it);
+  CHECK(done == (size_t)m->len);
+  for (int i = 0; i < m->len; i++) CHECK(out[i] == m->val[backward ? m->len - 1 - i : i]);
+  //whole export and a prefix of it
+  CHECK(pclistToArray(d, out, LIST_MAX + 1) == (size_t)m->len);
+  CHECK(!memcmp(out, m->val, m->len * sizeof(VAL_TYPE)));
+  size_t n = m->len ? nextRand(seed) % m->len : 0;
+  out[n] = -1;
+  CHECK(pclistToArray(d, out, n) == n);
+  CHECK(!memcmp(out, m->val, n * sizeof(VAL_TYPE)) && out[n] == -1);
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static ListModel m;
+  for (int r = 0; r < rounds; r++)
+  {
+    PCListArena * a = makeArena(0);
+    useArena(a);
+    //random updates
+    PCList * d = NULL;
+    m.len = 0;
+    for (int i = 0; i < OPS; i++)
+    {
+      d = updateList(d, &m, &seed);
+      if (i % 10 == 0) checkRead(d, &m, &seed);
+    }
+    //catenations at both ends alternated with pops nest deeper than the inline frames
+    PCList * e = NULL;
+    VAL_TYPE x;
+    m.len = 0;
+    for (int i = 0; m.len + PIECE <= LIST_MAX; i++)
+    {
+      VAL_TYPE piece [PIECE];
+      for (int k = 0; k < PIECE; k++) piece[k] = i * PIECE + k;
+      PCList * one = pclistFromArray(piece, PIECE);
+      e = (i & 1) ? catenate(e, one) : catenate(one, e);
+      if (i & 1) memcpy(m.val + m.len, piece, sizeof(piece));
+      else
+      {
+        memmove(m.val + PIECE, m.val, m.len * sizeof(VAL_TYPE));
+        memcpy(m.val, piece, sizeof(piece));
+      }
+      m.len += PIECE;
+      e = (i & 1) ? pop(e, &x) : eject(e, &x);
+      CHECK(x == ((i & 1) ? m.val[0] : m.val[m.len - 1]));
+      if (i & 1) memmove(m.val, m.val + 1, --m.len * sizeof(VAL_TYPE));
+      else m.len--;
+      if (i % 50 == 0) checkRead(e, &m, &seed);
+    }
+    checkRead(e, &m, &seed);
+    PCListIter it;
+    initIter(&it, e, 0);
+    while (iterNext(&it, &x));
+    CHECK(it.cap > PCLIST_ITER_DEPTH);
+    endIter(&it);
+    useArena(NULL);
+    releaseArena(a);
+  }
+  printf("pclist_iter: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,113 @@
+/*---------------------------------------------------------------------*
+ * pclist_split.c - model check of deque lengths, indexed access and   *
+ *                  splitting (splitAt, take, drop)                    *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "pclistarena.h"
+
+#define VERSIONS 16
+#define OPS      3000
+
+/**
+ * Checks the length of given deque and its values read by nth.
+ */
+static void checkIndexed (PCList * d, const ListModel * m, unsigned int * seed)
+{
+  CHECK(length(d) == (size_t)m->len);
+  if (!m->len) return;
+  if (m->len <= 64)
+    for (int k = 0; k < m->len; k++) CHECK(nth(d, k) == m->val[k]);
+  else
+    for (int i = 0; i < 64; i++)
+    {
+      size_t k = nextRand(seed) % m->len;
+      CHECK(nth(d, k) == m->val[k]);
+    }
+}
+
+/**
+ * Splits given deque at a random position and checks both parts, take and drop,
+ * the parts updated further and joined back together.
+ */
+static void checkSplit (PCList * d, const ListModel * m, unsigned int * seed)
+{
+  static ListModel l, r;
+  size_t k = nextRand(seed) % (m->len + 1);
+  if (nextRand(seed) % 8 == 0) k = (nextRand(seed) & 1) ? 0 : m->len;
+  PCList * left, * right;
+  splitAt(d, k, &left, &right);
+  l.len = k;
+  memcpy(l.val, m->val, k * sizeof(VAL_TYPE));
+  r.len = m->len - k;
+  memcpy(r.val, m->val + k, r.len * sizeof(VAL_TYPE));
+  checkList(left, &l);
+  checkList(right, &r);
+  checkIndexed(left, &l, seed);
+  checkIndexed(right, &r, seed);
+  checkList(take(d, k), &l);
+  checkList(drop(d, k), &r);
+  checkList(catenate(left, right), m);
+  checkList(d, m);
+  //the parts are deques like any other
+  for (int i = 0; i < 20; i++)
+  {
+    left = updateList(left, &l, seed);
+    right = updateList(right, &r, seed);
+  }
+  checkList(left, &l);
+  checkList(right, &r);
+  checkIndexed(left, &l, seed);
+  checkIndexed(right, &r, seed);
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PCList * list [VERSIONS];
+  static ListModel model [VERSIONS], m;
+  for (int r = 0; r < rounds; r++)
+  {
+    PCListArena * a = makeArena(0);
+    useArena(a);
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      //half of the versions start as deques built from arrays
+      model[v].len = v % 2 ? nextRand(&seed) % 600 : 0;
+      for (int i = 0; i < model[v].len; i++) model[v].val[i] = nextRand(&seed) % 1000;
+      list[v] = pclistFromArray(model[v].val, model[v].len);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int v = nextRand(&seed) % VERSIONS, w = nextRand(&seed) % VERSIONS;
+      m = model[v];
+      list[w] = updateList(list[v], &m, &seed);
+      model[w] = m;
+      checkIndexed(list[w], &model[w], &seed);
+      if (i % 10 == 0) checkSplit(list[w], &model[w], &seed);
+      //splitting a split part again and joining it with other versions
+      if (i % 50 == 0 && model[w].len)
+      {
+        size_t k = nextRand(&seed) % model[w].len;
+        list[w] = drop(list[w], k);
+        model[w].len -= k;
+        memmove(model[w].val, model[w].val + k, model[w].len * sizeof(VAL_TYPE));
+        checkList(list[w], &model[w]);
+      }
+    }
+    for (int v = 0; v < VERSIONS; v++) checkSplit(list[v], &model[v], &seed);
+    useArena(NULL);
+    releaseArena(a);
+  }
+  printf("pclist_split: %d rounds ok\n", rounds);
+  return 0;
+}
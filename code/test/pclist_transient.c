@@ -0,0 +1,105 @@
+/*---------------------------------------------------------------------*
+ * pclist_transient.c - model check of batches of in-place deque       *
+ *                      updates (transient mode)                       *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "pclistarena.h"
+#include "pclisttransient.h"
+
+#define VERSIONS 8
+#define BATCHES  200
+
+/**
+ * Applies a batch of random in-place updates to a transient made of given deque,
+ * runs of one kind of update cross the windows of the transient.
+ */
+static PCList * batch (PCList * d, ListModel * m, PCList * other, const ListModel * om, unsigned int * seed)
+{
+  PCListTransient * t = pclistTransient(d);
+  int ops = nextRand(seed) % 3000;
+  for (int i = 0; i < ops; )
+  {
+    int kind = nextRand(seed) % 9, run = 1 + nextRand(seed) % 600;
+    for (int j = 0; j < run; j++, i++)
+    {
+      VAL_TYPE x = nextRand(seed) % 1000;
+      if (kind < 2 && m->len < LIST_MAX)
+      {
+        transientPush(t, x);
+        memmove(m->val + 1, m->val, m->len * sizeof(VAL_TYPE));
+        m->val[0] = x;
+        m->len++;
+      }
+      else if (kind < 4 && m->len < LIST_MAX)
+      {
+        transientInject(t, x);
+        m->val[m->len++] = x;
+      }
+      else if (kind < 6 && m->len)
+      {
+        transientPop(t, &x);
+        CHECK(x == m->val[0]);
+        memmove(m->val, m->val + 1, --m->len * sizeof(VAL_TYPE));
+      }
+      else if (kind < 8 && m->len)
+      {
+        transientEject(t, &x);
+        CHECK(x == m->val[--m->len]);
+      }
+      else if (kind == 8 && j == 0 && m->len + om->len <= LIST_MAX)
+      {
+        transientCatenate(t, other);
+        memcpy(m->val + m->len, om->val, om->len * sizeof(VAL_TYPE));
+        m->len += om->len;
+      }
+      CHECK(transientLength(t) == (size_t)m->len);
+    }
+  }
+  return pclistPersistent(t);
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PCList * list [VERSIONS];
+  static ListModel model [VERSIONS], m;
+  for (int r = 0; r < rounds; r++)
+  {
+    PCListArena * a = makeArena(0);
+    useArena(a);
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      list[v] = NULL;
+      model[v].len = 0;
+    }
+    for (int i = 0; i < BATCHES; i++)
+    {
+      int v = nextRand(&seed) % VERSIONS, w = nextRand(&seed) % VERSIONS, o = nextRand(&seed) % VERSIONS;
+      m = model[v];
+      PCList * d = batch(list[v], &m, list[o], &model[o], &seed);
+      //the versions the batch started from and catenated are not changed
+      checkList(list[v], &model[v]);
+      checkList(list[o], &model[o]);
+      checkList(d, &m);
+      //the result is a usual persistent version
+      for (int k = 0; k < 20; k++) d = updateList(d, &m, &seed);
+      checkList(d, &m);
+      list[w] = d;
+      model[w] = m;
+    }
+    useArena(NULL);
+    releaseArena(a);
+  }
+  printf("pclist_transient: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*---------------------------------------------------------------------*
+ * prbtree_batch.c - model check of batched red-black tree updates     *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+
+#define KEYS     1024
+#define VERSIONS 16
+#define OPS      2000
+#define BATCH    300
+
+/* Live blocks are counted by wrapping malloc and free at link time (-Wl,--wrap=...) */
+void * __real_malloc (size_t size);
+void   __real_free   (void * p);
+static long live = 0;
+
+void * __wrap_malloc (size_t size)
+{
+  live++;
+  return __real_malloc(size);
+}
+
+void __wrap_free (void * p)
+{
+  if (p) live--;
+  __real_free(p);
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PRBTree * tree [VERSIONS];
+  static char has [VERSIONS][KEYS], h [KEYS];
+  static VAL_TYPE keys [BATCH];
+  static PRBTreeOp ops [BATCH];
+  long start = live;
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      tree[v] = makeTree();
+      memset(has[v], 0, KEYS);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS;
+      int kind = nextRand(&seed) % 3;
+      size_t k = nextRand(&seed) % (i % 7 ? 16 : BATCH);
+      //sorted runs of keys (as batches should be), sometimes unsorted ones or repeated keys
+      VAL_TYPE x = nextRand(&seed) % KEYS;
+      int sorted = nextRand(&seed) % 4;
+      memcpy(h, has[a], KEYS);
+      for (size_t j = 0; j < k; j++)
+      {
+        x = sorted ? (x + nextRand(&seed) % 8) % KEYS : nextRand(&seed) % KEYS;
+        keys[j] = x;
+        ops[j].kind = nextRand(&seed) & 1 ? PRBTREE_INSERT : PRBTREE_ERASE;
+        ops[j].key = x;
+        if (kind == 2) h[x] = ops[j].kind == PRBTREE_INSERT;
+        else h[x] = kind == 0;
+      }
+      PRBTree * t = kind == 0 ? insertBatch(tree[a], keys, k) :
+                    kind == 1 ? eraseBatch(tree[a], keys, k) : applyBatch(tree[a], ops, k);
+      checkTree(t, h, KEYS);
+      checkTree(tree[a], has[a], KEYS);
+      releaseTree(tree[b]);
+      tree[b] = t;
+      memcpy(has[b], h, KEYS);
+    }
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      checkTree(tree[v], has[v], KEYS);
+      releaseTree(tree[v]);
+    }
+    //nodes made and dropped inside a batch were freed as well
+    CHECK(live == start);
+  }
+  printf("prbtree_batch: %d rounds ok\n", rounds);
+  return 0;
+}
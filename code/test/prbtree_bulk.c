@@ -0,0 +1,62 @@
+/*---------------------------------------------------------------------*
+ * prbtree_bulk.c - model check of red-black trees built from sorted   *
+ *                  arrays, sequentially and by threads                *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+
+#define KEYS 8192
+#define OPS  200
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static char has [KEYS], built [KEYS];
+  static VAL_TYPE a [KEYS];
+  for (int r = 0; r < rounds; r++)
+  {
+    //every small size, then random sizes and densities
+    for (int i = 0; i < 300 + 40; i++)
+    {
+      size_t n = 0;
+      int dense = i < 300 ? 2 : 1 + nextRand(&seed) % 8;
+      memset(has, 0, KEYS);
+      for (int k = 0; k < KEYS && (i >= 300 || (int)n < i); k++)
+        if (nextRand(&seed) % dense == 0)
+        {
+          has[k] = 1;
+          a[n++] = k;
+        }
+      int threads = i % 9;
+      PRBTree * t = threads ? prbtreeFromSortedPar(a, n, threads) : prbtreeFromSorted(a, n);
+      checkTree(t, has, KEYS);
+      memcpy(built, has, KEYS);
+      //the built tree is updated like any other version
+      PRBTree * u = t;
+      for (int k = 0; k < OPS; k++)
+      {
+        VAL_TYPE x = nextRand(&seed) % KEYS;
+        int ins = nextRand(&seed) & 1;
+        PRBTree * tnew = ins ? insert(u, x) : erase(u, x);
+        if (u != t) releaseTree(u);
+        u = tnew;
+        has[x] = ins;
+      }
+      checkTree(u, has, KEYS);
+      checkTree(t, built, KEYS);
+      releaseTree(u);
+      releaseTree(t);
+    }
+  }
+  printf("prbtree_bulk: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*---------------------------------------------------------------------*
+ * prbtree_compact.c - model check of compact red-black trees and of   *
+ *                     their pool of nodes shared by threads           *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "check.h"
+#include "prbctree.h"
+
+#define THREADS  4
+#define KEYS     512
+#define VERSIONS 12
+#define OPS      3000
+#define KEPT     (OPS / 100)
+
+/* Work of one writer thread -- versions kept every 100 updates with their models */
+typedef struct
+{
+  PRBCTree *   base;
+  const char * base_has;
+  unsigned int seed;
+  PRBCTree *   tree[KEPT];
+  char         has[KEPT][KEYS];
+} Writer;
+
+/**
+ * Checks the values of a compact tree against its model.
+ */
+static void checkCompact (PRBCTree * t, const char * has)
+{
+  for (int k = -1; k <= KEYS; k++) CHECK(compactFind(t, k) == (k >= 0 && k < KEYS && has[k]));
+}
+
+/**
+ * Body of a writer thread -- derives a chain of versions from the shared base tree,
+ * keeps some of them and releases the other ones (so that it frees nodes as well).
+ */
+static void * writer (void * arg)
+{
+  Writer * w = (Writer *)arg;
+  PRBCTree * t = w->base;
+  char has [KEYS];
+  memcpy(has, w->base_has, KEYS);
+  for (int i = 0; i < OPS; i++)
+  {
+    VAL_TYPE x = nextRand(&w->seed) % KEYS;
+    int ins = nextRand(&w->seed) & 1;
+    PRBCTree * tnew = ins ? compactInsert(t, x) : compactErase(t, x);
+    if (t != w->base && i % 100 != 0) releaseCompactTree(t);
+    t = tnew;
+    has[x] = ins;
+    if (i % 10 == 0) checkCompact(t, has);
+    if (i % 100 == 99)
+    {
+      w->tree[i / 100] = t;
+      memcpy(w->has[i / 100], has, KEYS);
+    }
+  }
+  return NULL;
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PRBCTree * tree [VERSIONS];
+  static char has [VERSIONS][KEYS], h [KEYS];
+  static Writer w [THREADS];
+  size_t start = compactTreeBytes();
+  for (int r = 0; r < rounds; r++)
+  {
+    //random updates of random versions
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      tree[v] = makeCompactTree();
+      memset(has[v], 0, KEYS);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS;
+      VAL_TYPE x = nextRand(&seed) % KEYS;
+      int ins = nextRand(&seed) % 3;
+      PRBCTree * t = ins ? compactInsert(tree[a], x) : compactErase(tree[a], x);
+      memcpy(h, has[a], KEYS);
+      h[x] = ins ? 1 : 0;
+      checkCompact(t, h);
+      if (i % 10 == 0) checkCompact(tree[a], has[a]);
+      releaseCompactTree(tree[b]);
+      tree[b] = t;
+      memcpy(has[b], h, KEYS);
+    }
+    //threads derive versions of one of them, the versions are released by this thread
+    pthread_t th [THREADS];
+    for (int i = 0; i < THREADS; i++)
+    {
+      w[i].base = tree[0];
+      w[i].base_has = has[0];
+      w[i].seed = seed + r * THREADS + i;
+      pthread_create(&th[i], NULL, writer, &w[i]);
+    }
+    for (int i = 0; i < THREADS; i++) pthread_join(th[i], NULL);
+    for (int v = 0; v < VERSIONS; v++) checkCompact(tree[v], has[v]);
+    for (int i = 0; i < THREADS; i++)
+      for (int v = 0; v < KEPT; v++)
+      {
+        checkCompact(w[i].tree[v], w[i].has[v]);
+        releaseCompactTree(w[i].tree[v]);
+      }
+    for (int v = 0; v < VERSIONS; v++) releaseCompactTree(tree[v]);
+    //every node was given back
+    CHECK(compactTreeBytes() == start);
+  }
+  printf("prbtree_compact: %d rounds ok\n", rounds);
+  return 0;
+}
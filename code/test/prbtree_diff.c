@@ -0,0 +1,95 @@
+/*---------------------------------------------------------------------*
+ * prbtree_diff.c - model check of the diff of two red-black tree      *
+ *                  versions                                           *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "prbtreeiter.h"
+
+#define KEYS     1024
+#define VERSIONS 12
+#define OPS      3000
+
+/* Differences reported by one diff */
+typedef struct
+{
+  PRBTreeOp op [KEYS];
+  size_t    cnt;
+} DiffLog;
+
+/**
+ * Appends a reported difference to the log.
+ */
+static void logDiff (int kind, VAL_TYPE x, void * arg)
+{
+  DiffLog * log = arg;
+  CHECK(log->cnt < KEYS);
+  log->op[log->cnt].kind = kind;
+  log->op[log->cnt].key = x;
+  log->cnt++;
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PRBTree * tree [VERSIONS];
+  static char has [VERSIONS][KEYS], h [KEYS];
+  static DiffLog log;
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      tree[v] = makeTree();
+      memset(has[v], 0, KEYS);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS;
+      //derive a version by a few updates (many now and then), so that versions share subtrees
+      int n = 1 + nextRand(&seed) % (i % 10 ? 8 : 400);
+      PRBTree * t = tree[a];
+      memcpy(h, has[a], KEYS);
+      for (int j = 0; j < n; j++)
+      {
+        VAL_TYPE x = nextRand(&seed) % KEYS;
+        int add = nextRand(&seed) % 3;
+        PRBTree * tnew = add ? insert(t, x) : erase(t, x);
+        if (t != tree[a]) releaseTree(t);
+        t = tnew;
+        h[x] = add ? 1 : 0;
+      }
+      releaseTree(tree[b]);
+      tree[b] = t;
+      memcpy(has[b], h, KEYS);
+      //diff of two random versions in ascending order, as the model has it
+      int o = nextRand(&seed) % VERSIONS, w = nextRand(&seed) % VERSIONS;
+      log.cnt = 0;
+      CHECK(diff(tree[o], tree[w], logDiff, &log) == log.cnt);
+      size_t c = 0;
+      for (int k = 0; k < KEYS; k++)
+      {
+        if (has[o][k] == has[w][k]) continue;
+        CHECK(c < log.cnt && log.op[c].key == k);
+        CHECK(log.op[c].kind == (has[w][k] ? PRBTREE_INSERT : PRBTREE_ERASE));
+        c++;
+      }
+      CHECK(c == log.cnt);
+      //replayed on the older version it gives the newer one
+      PRBTree * re = applyBatch(tree[o], log.op, log.cnt);
+      checkTree(re, has[w], KEYS);
+      releaseTree(re);
+    }
+    for (int v = 0; v < VERSIONS; v++) releaseTree(tree[v]);
+  }
+  printf("prbtree_diff: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,134 @@
+/*---------------------------------------------------------------------*
+ * prbtree_equals.c - model check of treeEquals and of hash-consed     *
+ *                    nodes (built with and without PRBTREE_HASHCONS)  *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "check.h"
+#include "prbtreeiter.h"
+#include "prbtreenode.h"
+
+#define THREADS  4
+#define KEYS     512
+#define VERSIONS 12
+#define OPS      3000
+#define BATCH    64
+
+/* Replica made by one thread -- all of them apply the same updates */
+typedef struct
+{
+  unsigned int seed;
+  PRBTree *    tree;
+} Replica;
+
+/**
+ * Body of a replica thread -- applies a sequence of updates given by the seed to an empty tree.
+ */
+static void * replicate (void * arg)
+{
+  Replica * p = (Replica *)arg;
+  unsigned int seed = p->seed;
+  PRBTree * t = makeTree();
+  for (int i = 0; i < OPS; i++)
+  {
+    VAL_TYPE x = nextRand(&seed) % KEYS;
+    PRBTree * tnew = nextRand(&seed) % 3 ? insert(t, x) : erase(t, x);
+    releaseTree(t);
+    t = tnew;
+  }
+  p->tree = t;
+  return NULL;
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PRBTree * tree [VERSIONS];
+  static char has [VERSIONS][KEYS], h [KEYS];
+  static VAL_TYPE keys [KEYS];
+  static PRBTreeOp ops [BATCH];
+  static Replica rep [THREADS];
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      tree[v] = makeTree();
+      memset(has[v], 0, KEYS);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS;
+      PRBTree * t;
+      memcpy(h, has[a], KEYS);
+      switch (nextRand(&seed) % 8)
+      {
+        case 0:
+        {
+          //a bulk load of the same values (of another shape as a rule)
+          size_t n = 0;
+          for (int k = 0; k < KEYS; k++) if (h[k]) keys[n++] = k;
+          t = prbtreeFromSorted(keys, n);
+          break;
+        }
+        case 1:
+        {
+          size_t k = nextRand(&seed) % BATCH;
+          for (size_t j = 0; j < k; j++)
+          {
+            ops[j].kind = nextRand(&seed) & 1 ? PRBTREE_INSERT : PRBTREE_ERASE;
+            ops[j].key = nextRand(&seed) % KEYS;
+            h[ops[j].key] = ops[j].kind == PRBTREE_INSERT;
+          }
+          t = applyBatch(tree[a], ops, k);
+          break;
+        }
+        default:
+        {
+          VAL_TYPE x = nextRand(&seed) % KEYS;
+          int ins = nextRand(&seed) % 3;
+          t = ins ? insert(tree[a], x) : erase(tree[a], x);
+          h[x] = ins ? 1 : 0;
+          break;
+        }
+      }
+      checkTree(t, h, KEYS);
+      CHECK(treeEquals(t, tree[a]) == !memcmp(h, has[a], KEYS));
+      int o = nextRand(&seed) % VERSIONS;
+      CHECK(treeEquals(t, tree[o]) == !memcmp(h, has[o], KEYS));
+      CHECK(treeEquals(tree[o], t) == !memcmp(h, has[o], KEYS));
+      releaseTree(tree[b]);
+      tree[b] = t;
+      memcpy(has[b], h, KEYS);
+    }
+    //replicas of the same updates are equal, hash-consed ones share all their nodes
+    pthread_t th [THREADS];
+    for (int i = 0; i < THREADS; i++)
+    {
+      rep[i].seed = seed + r;
+      pthread_create(&th[i], NULL, replicate, &rep[i]);
+    }
+    for (int i = 0; i < THREADS; i++) pthread_join(th[i], NULL);
+    for (int i = 1; i < THREADS; i++)
+    {
+      CHECK(treeEquals(rep[0].tree, rep[i].tree));
+#ifdef PRBTREE_HASHCONS
+      CHECK(rep[0].tree->root == rep[i].tree->root);
+#endif
+    }
+    for (int i = 0; i < THREADS; i++) releaseTree(rep[i].tree);
+    for (int v = 0; v < VERSIONS; v++) releaseTree(tree[v]);
+    //released nodes are not left in the intern table
+    CHECK(internedNodes() == 0);
+  }
+  printf("prbtree_equals: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,82 @@
+/*---------------------------------------------------------------------*
+ * prbtree_fat.c - model check of partially persistent red-black       *
+ *                 trees made by node copying                          *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "prbtreefat.h"
+
+#define KEYS 512
+#define OPS  6000
+
+/**
+ * Checks given version of a fat tree against its model.
+ */
+static void checkFat (PRBFatTree * t, unsigned int v, const char * has)
+{
+  static VAL_TYPE out [KEYS];
+  size_t n = 0;
+  for (int k = -1; k <= KEYS; k++)
+  {
+    int in = k >= 0 && k < KEYS && has[k];
+    CHECK(fatFind(t, v, k) == in);
+    n += in;
+  }
+  CHECK(fatSize(t, v) == n);
+  CHECK(fatToArray(t, v, out) == n);
+  for (size_t i = 0, k = 0; i < n; i++, k++)
+  {
+    while (!has[k]) k++;
+    CHECK(out[i] == (VAL_TYPE)k);
+  }
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  //model of every version (version 0 is the empty tree)
+  static char has [OPS + 1][KEYS];
+  for (int r = 0; r < rounds; r++)
+  {
+    PRBFatTree * t = makeFatTree();
+    unsigned int last = 0;
+    memset(has[0], 0, KEYS);
+    checkFat(t, 0, has[0]);
+    for (int i = 0; i < OPS; i++)
+    {
+      //phases of growth and shrinking, no-op updates make no version
+      VAL_TYPE x = nextRand(&seed) % KEYS;
+      int ins = nextRand(&seed) % 4 ? (i / 1000) % 2 == 0 : (i / 1000) % 2 == 1;
+      unsigned int v = ins ? fatInsert(t, x) : fatErase(t, x);
+      if (has[last][x] == ins) CHECK(v == last);
+      else
+      {
+        CHECK(v == last + 1);
+        memcpy(has[v], has[last], KEYS);
+        has[v][x] = ins;
+        last = v;
+      }
+      CHECK(fatVersion(t) == last);
+      if (i % 10 == 0) checkFat(t, last, has[last]);
+      if (i % 10 == 5)
+      {
+        unsigned int old = nextRand(&seed) % (last + 1);
+        checkFat(t, old, has[old]);
+      }
+    }
+    //older versions were not changed by the later updates
+    for (unsigned int v = 0; v <= last; v += 1 + nextRand(&seed) % 8) checkFat(t, v, has[v]);
+    releaseFatTree(t);
+  }
+  printf("prbtree_fat: %d rounds ok\n", rounds);
+  return 0;
+}
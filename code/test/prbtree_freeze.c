@@ -0,0 +1,81 @@
+/*---------------------------------------------------------------------*
+ * prbtree_freeze.c - model check of frozen snapshots of red-black     *
+ *                    tree versions                                    *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "prbtreefreeze.h"
+
+#define KEYS     3000
+#define VERSIONS 200
+#define QUERIES  1000
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static char has [KEYS];
+  static VAL_TYPE keys [QUERIES];
+  static char found [QUERIES];
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      //sizes around the complete trees (2^k - 1) and random ones, the empty one first
+      int n = v == 0 ? 0 : v % 2 ? (1 << (1 + v % 11)) - 1 + (int)(nextRand(&seed) % 3) - 1 : (int)(nextRand(&seed) % KEYS);
+      int span = n + (int)(nextRand(&seed) % (KEYS - n + 1));
+      PRBTree * t = makeTree();
+      memset(has, 0, KEYS);
+      for (int cnt = 0; cnt < n; )
+      {
+        VAL_TYPE x = nextRand(&seed) % span;
+        if (has[x]) continue;
+        PRBTree * tnew = insert(t, x);
+        releaseTree(t);
+        t = tnew;
+        has[x] = 1;
+        cnt++;
+      }
+      //the snapshot does not depend on the version
+      PRBTreeFrozen * f = prbtreeFreeze(t);
+      CHECK(f && f->n == (size_t)n);
+      releaseTree(t);
+      VAL_TYPE next = NA;
+      for (int k = KEYS; k >= -1; k--)
+      {
+        VAL_TYPE y = -7;
+        int in = k >= 0 && k < KEYS && has[k];
+        CHECK(frozenFind(f, k) == in);
+        if (in) next = k;
+        CHECK(frozenLowerBound(f, k, &y) == (next != NA));
+        CHECK(y == (next != NA ? next : -7));
+      }
+      size_t q = nextRand(&seed) % QUERIES;
+      for (size_t i = 0; i < q; i++) keys[i] = (VAL_TYPE)(nextRand(&seed) % (KEYS + 2)) - 1;
+      memset(found, 7, QUERIES);
+      frozenFindBatch(f, keys, q, found);
+      for (size_t i = 0; i < q; i++) CHECK(found[i] == (keys[i] >= 0 && keys[i] < KEYS && has[keys[i]]));
+      CHECK(q == QUERIES || found[q] == 7);
+      //thawed version can be updated again
+      t = prbtreeThaw(f);
+      releaseFrozen(f);
+      checkTree(t, has, KEYS);
+      VAL_TYPE x = nextRand(&seed) % KEYS;
+      PRBTree * tnew = has[x] ? erase(t, x) : insert(t, x);
+      has[x] = !has[x];
+      checkTree(tnew, has, KEYS);
+      releaseTree(t);
+      releaseTree(tnew);
+    }
+  }
+  printf("prbtree_freeze: %d rounds ok\n", rounds);
+  return 0;
+}
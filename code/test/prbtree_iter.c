@@ -0,0 +1,115 @@
+/*---------------------------------------------------------------------*
+ * prbtree_iter.c - model check of ordered cursors and range scans     *
+ *                  over red-black tree versions                       *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include "check.h"
+#include "prbtreeiter.h"
+
+#define KEYS 600
+#define OPS  1500
+
+static char has [KEYS];
+
+/**
+ * Returns the least key of the model which is at least x (KEYS if there is none).
+ */
+static int nextKey (int x)
+{
+  if (x < 0) x = 0;
+  while (x < KEYS && !has[x]) x++;
+  return x;
+}
+
+/**
+ * Returns the greatest key of the model which is at most x (-1 if there is none).
+ */
+static int prevKey (int x)
+{
+  if (x >= KEYS) x = KEYS - 1;
+  while (x >= 0 && !has[x]) x--;
+  return x;
+}
+
+/**
+ * Checks that a cursor is at given key of the model (or nowhere for a key out of range).
+ */
+static void checkAt (PRBTreeIter * it, int ok, int k)
+{
+  CHECK(ok == (k >= 0 && k < KEYS));
+  if (ok) CHECK(treeValue(it) == k);
+}
+
+/**
+ * Checks the cursors and range scans of given tree against the model.
+ */
+static void checkOrder (PRBTree * t, unsigned int * seed)
+{
+  static VAL_TYPE out [KEYS];
+  PRBTreeIter it;
+  //whole walks in both directions
+  int k = nextKey(0), ok = treeMin(&it, t);
+  for (; k < KEYS; k = nextKey(k + 1), ok = treeNext(&it)) checkAt(&it, ok, k);
+  checkAt(&it, ok, k);
+  k = prevKey(KEYS - 1);
+  for (ok = treeMax(&it, t); k >= 0; k = prevKey(k - 1), ok = treePrev(&it)) checkAt(&it, ok, k);
+  checkAt(&it, ok, k);
+  //bounds of random values followed by random steps
+  for (int i = 0; i < 20; i++)
+  {
+    int x = (int)(nextRand(seed) % (KEYS + 20)) - 10;
+    int upper = nextRand(seed) & 1;
+    k = nextKey(upper ? x + 1 : x);
+    ok = upper ? upperBound(&it, t, x) : lowerBound(&it, t, x);
+    checkAt(&it, ok, k);
+    for (int j = 0; ok && j < 10; j++)
+    {
+      int back = nextRand(seed) & 1;
+      k = back ? prevKey(k - 1) : nextKey(k + 1);
+      ok = back ? treePrev(&it) : treeNext(&it);
+      checkAt(&it, ok, k);
+    }
+  }
+  //range scans with small and large buffers
+  for (int i = 0; i < 20; i++)
+  {
+    int lo = (int)(nextRand(seed) % (KEYS + 20)) - 10, hi = lo + (int)(nextRand(seed) % 200) - 20;
+    size_t cap = nextRand(seed) % 4 ? KEYS : nextRand(seed) % 10;
+    size_t n = rangeScan(t, lo, hi, out, cap), cnt = 0;
+    for (k = nextKey(lo); k <= hi && k < KEYS && cnt < cap; k = nextKey(k + 1)) CHECK(out[cnt++] == k);
+    CHECK(n == cnt);
+  }
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  for (int r = 0; r < rounds; r++)
+  {
+    PRBTree * t = makeTree();
+    for (int k = 0; k < KEYS; k++) has[k] = 0;
+    checkOrder(t, &seed);
+    for (int i = 0; i < OPS; i++)
+    {
+      VAL_TYPE x = nextRand(&seed) % KEYS;
+      //the tree fills up in the first half and empties in the second one
+      int ins = nextRand(&seed) % 4 < (2 * i < OPS ? 3 : 1);
+      PRBTree * tnew = ins ? insert(t, x) : erase(t, x);
+      releaseTree(t);
+      t = tnew;
+      has[x] = ins;
+      if (i % 10 == 0) checkOrder(t, &seed);
+    }
+    checkTree(t, has, KEYS);
+    releaseTree(t);
+  }
+  printf("prbtree_iter: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,146 @@
+/*---------------------------------------------------------------------*
+ * prbtree_join.c - model check of split/join of red-black trees and   *
+ *                  of range erase/extract built on them               *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "prbtreejoin.h"
+
+#define KEYS     1024
+#define VERSIONS 12
+#define OPS      3000
+
+/* Live blocks are counted by wrapping malloc and free at link time (-Wl,--wrap=...) */
+void * __real_malloc (size_t size);
+void   __real_free   (void * p);
+static long live = 0;
+
+void * __wrap_malloc (size_t size)
+{
+  live++;
+  return __real_malloc(size);
+}
+
+void __wrap_free (void * p)
+{
+  if (p) live--;
+  __real_free(p);
+}
+
+/**
+ * Copies the part [lo, hi] of a model to another one, the rest of it is cleared.
+ */
+static void keepRange (char * to, const char * from, int lo, int hi)
+{
+  for (int k = 0; k < KEYS; k++) to[k] = k >= lo && k <= hi ? from[k] : 0;
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PRBTree * tree [VERSIONS];
+  static char has [VERSIONS][KEYS], h [KEYS], l [KEYS], g [KEYS];
+  long start = live;
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      tree[v] = makeTree();
+      memset(has[v], 0, KEYS);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS;
+      int lo = (int)(nextRand(&seed) % (KEYS + 20)) - 10, hi = lo + (int)(nextRand(&seed) % KEYS) - 50;
+      PRBTree * t, * less, * greater;
+      memcpy(h, has[a], KEYS);
+      switch (nextRand(&seed) % 5)
+      {
+        case 0: case 1:
+        {
+          //a few single updates keep the trees from getting empty
+          t = tree[a];
+          for (int j = 0; j < 40; j++)
+          {
+            VAL_TYPE x = nextRand(&seed) % KEYS;
+            PRBTree * tnew = insert(t, x);
+            if (t != tree[a]) releaseTree(t);
+            t = tnew;
+            h[x] = 1;
+          }
+          break;
+        }
+        case 2:
+        {
+          //split at a value and join the parts back around it
+          int found = split(tree[a], lo, &less, &greater);
+          CHECK(found == (lo >= 0 && lo < KEYS && h[lo]));
+          keepRange(l, h, -1, lo - 1);
+          keepRange(g, h, lo + 1, KEYS);
+          checkTree(less, l, KEYS);
+          checkTree(greater, g, KEYS);
+          //join puts the middle value in, it is sometimes erased again (always when out of range)
+          int in = lo >= 0 && lo < KEYS;
+          t = join(less, lo, greater);
+          if (in) h[lo] = 1;
+          if (!in || nextRand(&seed) & 1)
+          {
+            PRBTree * tnew = erase(t, lo);
+            releaseTree(t);
+            t = tnew;
+            if (in) h[lo] = 0;
+          }
+          releaseTree(less);
+          releaseTree(greater);
+          break;
+        }
+        case 3:
+        {
+          t = eraseRange(tree[a], lo, hi);
+          for (int k = lo; k <= hi; k++) if (k >= 0 && k < KEYS) h[k] = 0;
+          break;
+        }
+        default:
+        {
+          //the extracted part or the rest
+          PRBTree * rest = NULL;
+          int want_rest = nextRand(&seed) & 1;
+          PRBTree * part = extractRange(tree[a], lo, hi, want_rest ? &rest : NULL);
+          keepRange(l, h, lo, hi);
+          checkTree(part, l, KEYS);
+          for (int k = lo; k <= hi; k++) if (k >= 0 && k < KEYS) h[k] = 0;
+          if (want_rest)
+          {
+            releaseTree(part);
+            t = rest;
+          }
+          else
+          {
+            t = part;
+            memcpy(h, l, KEYS);
+          }
+          break;
+        }
+      }
+      checkTree(t, h, KEYS);
+      checkTree(tree[a], has[a], KEYS);
+      releaseTree(tree[b]);
+      tree[b] = t;
+      memcpy(has[b], h, KEYS);
+    }
+    for (int v = 0; v < VERSIONS; v++) releaseTree(tree[v]);
+    //nodes made and dropped by the operations were freed as well
+    CHECK(live == start);
+  }
+  printf("prbtree_join: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,88 @@
+/*---------------------------------------------------------------------*
+ * prbtree_mt.c - model check of concurrent red-black tree updates     *
+ *                (every thread derives its own versions)              *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "check.h"
+
+#define THREADS 4
+#define KEYS    256
+#define OPS     2000
+#define KEPT    (OPS / 100)
+
+/* Work of one writer thread -- versions kept every 100 updates with their models */
+typedef struct
+{
+  PRBTree *    base;
+  const char * base_has;
+  unsigned int seed;
+  PRBTree *    tree[KEPT];
+  char         has[KEPT][KEYS];
+} Writer;
+
+/**
+ * Body of a writer thread -- derives a chain of versions from the shared base tree
+ * and checks every one of them against its model.
+ */
+static void * writer (void * arg)
+{
+  Writer * w = (Writer *)arg;
+  PRBTree * t = w->base;
+  char has [KEYS];
+  memcpy(has, w->base_has, KEYS);
+  for (int i = 0; i < OPS; i++)
+  {
+    VAL_TYPE x = nextRand(&w->seed) % KEYS;
+    int ins = nextRand(&w->seed) & 1;
+    t = ins ? insert(t, x) : erase(t, x);
+    has[x] = ins;
+    checkTree(t, has, KEYS);
+    if (i % 100 == 99)
+    {
+      w->tree[i / 100] = t;
+      memcpy(w->has[i / 100], has, KEYS);
+    }
+  }
+  return NULL;
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static Writer w [THREADS];
+  for (int r = 0; r < rounds; r++)
+  {
+    char has [KEYS] = {0};
+    PRBTree * base = makeTree();
+    for (int k = 0; k < KEYS; k += 2)
+    {
+      base = insert(base, k);
+      has[k] = 1;
+    }
+    pthread_t th [THREADS];
+    for (int i = 0; i < THREADS; i++)
+    {
+      w[i].base = base;
+      w[i].base_has = has;
+      w[i].seed = seed + r * THREADS + i;
+      pthread_create(&th[i], NULL, writer, &w[i]);
+    }
+    for (int i = 0; i < THREADS; i++) pthread_join(th[i], NULL);
+    //no version of a thread was changed by the other ones
+    checkTree(base, has, KEYS);
+    for (int i = 0; i < THREADS; i++)
+      for (int v = 0; v < KEPT; v++) checkTree(w[i].tree[v], w[i].has[v], KEYS);
+  }
+  printf("prbtree_mt: %d rounds ok\n", rounds);
+  return 0;
+}
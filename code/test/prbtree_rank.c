@@ -0,0 +1,103 @@
+/*---------------------------------------------------------------------*
+ * prbtree_rank.c - model check of order statistics of red-black       *
+ *                  tree versions (rank, selectKth, countRange)        *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+
+#define KEYS     512
+#define VERSIONS 8
+#define OPS      1500
+
+/**
+ * Checks the order statistics of given tree against its model.
+ */
+static void checkRank (PRBTree * t, const char * has, unsigned int * seed)
+{
+  static int below [KEYS + 2];
+  size_t n = 0;
+  //below[x + 1] is the number of keys less than x
+  for (int x = -1; x <= KEYS; x++)
+  {
+    below[x + 1] = n;
+    CHECK(rank(t, x) == n);
+    if (x >= 0 && x < KEYS && has[x])
+    {
+      CHECK(selectKth(t, n) == x);
+      n++;
+    }
+  }
+  CHECK(t->root->size == n);
+  CHECK(selectKth(t, n) == NA && selectKth(t, n + 100) == NA);
+  for (int i = 0; i < 50; i++)
+  {
+    int lo = (int)(nextRand(seed) % (KEYS + 2)) - 1, hi = (int)(nextRand(seed) % (KEYS + 2)) - 1;
+    size_t cnt = lo > hi ? 0 : (hi + 1 <= KEYS ? below[hi + 2] : n) - below[lo + 1];
+    CHECK(countRange(t, lo, hi) == cnt);
+  }
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PRBTree * tree [VERSIONS];
+  static char has [VERSIONS][KEYS], h [KEYS];
+  static VAL_TYPE a [KEYS];
+  for (int r = 0; r < rounds; r++)
+  {
+    //versions start from bulk loaded trees
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      size_t n = 0;
+      for (int k = 0; k < KEYS; k++)
+        if ((has[v][k] = nextRand(&seed) % (v + 2) == 0)) a[n++] = k;
+      tree[v] = prbtreeFromSorted(a, n);
+      checkRank(tree[v], has[v], &seed);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int v = nextRand(&seed) % VERSIONS, w = nextRand(&seed) % VERSIONS;
+      memcpy(h, has[v], KEYS);
+      PRBTree * t;
+      if (i % 5)
+      {
+        VAL_TYPE x = nextRand(&seed) % KEYS;
+        int ins = nextRand(&seed) & 1;
+        t = ins ? insert(tree[v], x) : erase(tree[v], x);
+        h[x] = ins;
+      }
+      else
+      {
+        PRBTreeOp ops [32];
+        for (int j = 0; j < 32; j++)
+        {
+          ops[j].kind = nextRand(&seed) & 1 ? PRBTREE_INSERT : PRBTREE_ERASE;
+          ops[j].key = nextRand(&seed) % KEYS;
+          h[ops[j].key] = ops[j].kind == PRBTREE_INSERT;
+        }
+        t = applyBatch(tree[v], ops, 32);
+      }
+      checkTree(t, h, KEYS);
+      if (i % 5 == 0) checkRank(t, h, &seed);
+      releaseTree(tree[w]);
+      tree[w] = t;
+      memcpy(has[w], h, KEYS);
+    }
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      checkRank(tree[v], has[v], &seed);
+      releaseTree(tree[v]);
+    }
+  }
+  printf("prbtree_rank: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,121 @@
+/*---------------------------------------------------------------------*
+ * prbtree_release.c - model check of releasing red-black tree         *
+ *                     versions in random order, also by threads       *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "check.h"
+
+#define THREADS  4
+#define KEYS     512
+#define VERSIONS 32
+#define OPS      3000
+
+/* Live blocks are counted by wrapping malloc and free at link time (-Wl,--wrap=...) */
+void * __real_malloc (size_t size);
+void   __real_free   (void * p);
+static long live = 0;
+
+void * __wrap_malloc (size_t size)
+{
+  __atomic_add_fetch(&live, 1, __ATOMIC_RELAXED);
+  return __real_malloc(size);
+}
+
+void __wrap_free (void * p)
+{
+  if (p) __atomic_sub_fetch(&live, 1, __ATOMIC_RELAXED);
+  __real_free(p);
+}
+
+/* Versions of one thread with their models, a slot without a version is NULL */
+typedef struct
+{
+  PRBTree *    base;
+  const char * base_has;
+  unsigned int seed;
+  PRBTree *    tree[VERSIONS];
+  char         has[VERSIONS][KEYS];
+} Family;
+
+/**
+ * Body of a thread -- derives new versions from random live ones (or from the shared
+ * base), releases random versions and checks the live ones, at the end releases all of them.
+ */
+static void * family (void * arg)
+{
+  Family * f = (Family *)arg;
+  memset(f->tree, 0, sizeof(f->tree));
+  for (int i = 0; i < OPS; i++)
+  {
+    int a = nextRand(&f->seed) % VERSIONS, b = nextRand(&f->seed) % VERSIONS;
+    if (nextRand(&f->seed) % 4 == 0)
+    {
+      releaseTree(f->tree[b]);
+      f->tree[b] = NULL;
+      continue;
+    }
+    PRBTree * t = f->tree[a] ? f->tree[a] : f->base;
+    char has [KEYS];
+    memcpy(has, f->tree[a] ? f->has[a] : f->base_has, KEYS);
+    VAL_TYPE x = nextRand(&f->seed) % KEYS;
+    int ins = nextRand(&f->seed) & 1;
+    PRBTree * tnew = ins ? insert(t, x) : erase(t, x);
+    has[x] = ins;
+    releaseTree(f->tree[b]);
+    f->tree[b] = tnew;
+    memcpy(f->has[b], has, KEYS);
+    if (i % 16 == 0)
+      for (int v = 0; v < VERSIONS; v++)
+        if (f->tree[v]) checkTree(f->tree[v], f->has[v], KEYS);
+  }
+  for (int v = 0; v < VERSIONS; v++) releaseTree(f->tree[v]);
+  return NULL;
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static Family f [THREADS];
+  long start = live;
+  for (int r = 0; r < rounds; r++)
+  {
+    char has [KEYS] = {0};
+    PRBTree * base = makeTree();
+    for (int k = 0; k < KEYS; k += 3)
+    {
+      PRBTree * tnew = insert(base, k);
+      releaseTree(base);
+      base = tnew;
+      has[k] = 1;
+    }
+    //one thread first, then all of them on the same base
+    for (int n = 1; n <= THREADS; n += THREADS - 1)
+    {
+      pthread_t th [THREADS];
+      for (int i = 0; i < n; i++)
+      {
+        f[i].base = base;
+        f[i].base_has = has;
+        f[i].seed = seed + r * THREADS + i;
+        pthread_create(&th[i], NULL, family, &f[i]);
+      }
+      for (int i = 0; i < n; i++) pthread_join(th[i], NULL);
+      checkTree(base, has, KEYS);
+    }
+    releaseTree(base);
+    //every node of every version was freed
+    CHECK(live == start);
+  }
+  printf("prbtree_release: %d rounds ok\n", rounds);
+  return 0;
+}
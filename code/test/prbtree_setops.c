@@ -0,0 +1,110 @@
+/*---------------------------------------------------------------------*
+ * prbtree_setops.c - model check of union, intersection and           *
+ *                    difference of red-black tree versions            *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "prbtreejoin.h"
+
+#define KEYS     2048
+#define VERSIONS 10
+#define OPS      1500
+#define THREADS  3
+
+/* Live blocks are counted by wrapping malloc and free at link time (-Wl,--wrap=...) */
+void * __real_malloc (size_t size);
+void   __real_free   (void * p);
+static long live = 0;
+
+void * __wrap_malloc (size_t size)
+{
+  __atomic_fetch_add(&live, 1, __ATOMIC_RELAXED);
+  return __real_malloc(size);
+}
+
+void __wrap_free (void * p)
+{
+  if (p) __atomic_fetch_sub(&live, 1, __ATOMIC_RELAXED);
+  __real_free(p);
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  static PRBTree * tree [VERSIONS];
+  static char has [VERSIONS][KEYS], h [KEYS];
+  long start = live;
+  for (int r = 0; r < rounds; r++)
+  {
+    //every other round runs the operations in a pool
+    PRBTreePool * pool = (r & 1) ? makePool(THREADS) : NULL;
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      tree[v] = makeTree();
+      memset(has[v], 0, KEYS);
+    }
+    for (int i = 0; i < OPS; i++)
+    {
+      int a = nextRand(&seed) % VERSIONS, b = nextRand(&seed) % VERSIONS, c = nextRand(&seed) % VERSIONS;
+      PRBTree * t;
+      switch (nextRand(&seed) % 4)
+      {
+        case 0:
+        {
+          //updates of a version, so that the versions share most of their subtrees
+          int n = 1 + nextRand(&seed) % 300, add = nextRand(&seed) % 3;
+          t = tree[a];
+          memcpy(h, has[a], KEYS);
+          for (int j = 0; j < n; j++)
+          {
+            VAL_TYPE x = nextRand(&seed) % KEYS;
+            PRBTree * tnew = add ? insert(t, x) : erase(t, x);
+            if (t != tree[a]) releaseTree(t);
+            t = tnew;
+            h[x] = add ? 1 : 0;
+          }
+          break;
+        }
+        case 1:
+        {
+          t = treeUnion(tree[a], tree[b], pool);
+          for (int k = 0; k < KEYS; k++) h[k] = has[a][k] || has[b][k];
+          break;
+        }
+        case 2:
+        {
+          t = treeIntersection(tree[a], tree[b], pool);
+          for (int k = 0; k < KEYS; k++) h[k] = has[a][k] && has[b][k];
+          break;
+        }
+        default:
+        {
+          t = treeDifference(tree[a], tree[b], pool);
+          for (int k = 0; k < KEYS; k++) h[k] = has[a][k] && !has[b][k];
+          break;
+        }
+      }
+      checkTree(t, h, KEYS);
+      checkTree(tree[a], has[a], KEYS);
+      checkTree(tree[b], has[b], KEYS);
+      releaseTree(tree[c]);
+      tree[c] = t;
+      memcpy(has[c], h, KEYS);
+    }
+    for (int v = 0; v < VERSIONS; v++) releaseTree(tree[v]);
+    if (pool) releasePool(pool);
+    //nodes made and dropped by the operations were freed as well
+    CHECK(live == start);
+  }
+  printf("prbtree_setops: %d rounds ok\n", rounds);
+  return 0;
+}
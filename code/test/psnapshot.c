@@ -0,0 +1,271 @@
+/*---------------------------------------------------------------------*
+ * psnapshot.c - model check of snapshot files of tree and deque       *
+ *               versions, intact, truncated and corrupt ones          *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "pclistarena.h"
+#include "psnapshot.h"
+
+#define KEYS     2000
+#define VERSIONS 12
+#define UPDATES  300
+#define DAMAGES  200
+#define BULK     200
+
+static char      has [VERSIONS][KEYS];
+static ListModel model [VERSIONS];
+static VAL_TYPE  out [LIST_MAX];
+
+/**
+ * Writes given bytes to a file.
+ */
+static void writeFile (const char * path, const char * bytes, size_t size)
+{
+  FILE * f = fopen(path, "wb");
+  CHECK(f && fwrite(bytes, 1, size, f) == size && !fclose(f));
+}
+
+/**
+ * Reads a whole file, its size is stored.
+ */
+static char * readFile (const char * path, size_t * size)
+{
+  FILE * f = fopen(path, "rb");
+  CHECK(f && !fseek(f, 0, SEEK_END));
+  *size = (size_t)ftell(f);
+  char * ret = (char *)malloc(*size);
+  rewind(f);
+  CHECK(fread(ret, 1, *size, f) == *size && !fclose(f));
+  return ret;
+}
+
+/**
+ * Applies a random update of the model checks (see updateList), a split or a bulk push
+ * (inject) to given deque and to its model, returns the new version.
+ */
+static PCList * updateDeque (PCList * d, ListModel * m, unsigned int * seed)
+{
+  static VAL_TYPE a [BULK];
+  int k = (int)(nextRand(seed) % (m->len + 1));
+  switch (nextRand(seed) % 8)
+  {
+    case 0:
+      m->len = k;
+      return take(d, k);
+    case 1:
+      memmove(m->val, m->val + k, (m->len - k) * sizeof(VAL_TYPE));
+      m->len -= k;
+      return drop(d, k);
+    case 2:
+      k = (int)(nextRand(seed) % BULK);
+      if (m->len + k > LIST_MAX) return d;
+      for (int i = 0; i < k; i++) a[i] = nextRand(seed) % 1000;
+      memmove(m->val + k, m->val, m->len * sizeof(VAL_TYPE));
+      memcpy(m->val, a, k * sizeof(VAL_TYPE));
+      m->len += k;
+      return pushMany(d, a, k);
+    case 3:
+      k = (int)(nextRand(seed) % BULK);
+      if (m->len + k > LIST_MAX) return d;
+      for (int i = 0; i < k; i++) a[i] = nextRand(seed) % 1000;
+      memcpy(m->val + m->len, a, k * sizeof(VAL_TYPE));
+      m->len += k;
+      return injectMany(d, a, k);
+    default:
+      return updateList(d, m, seed);
+  }
+}
+
+/**
+ * Checks an intact snapshot against the models of the versions, in place and loaded.
+ */
+static void checkSnapshot (PSnapshot * s)
+{
+  PRBTree * trees [VERSIONS];
+  PCList * lists [VERSIONS];
+  CHECK(snapshotTrees(s) == VERSIONS && snapshotLists(s) == VERSIONS);
+  for (int v = 0; v < VERSIONS; v++)
+  {
+    size_t n = 0;
+    for (int x = -1; x <= KEYS; x++)
+    {
+      int in = x >= 0 && x < KEYS && has[v][x];
+      CHECK(snapshotFind(s, v, x) == in);
+      n += in;
+    }
+    CHECK(snapshotTreeSize(s, v) == n && snapshotTreeToArray(s, v, out) == n);
+    for (size_t i = 1; i < n; i++) CHECK(out[i - 1] < out[i]);
+    for (size_t i = 0; i < n; i++) CHECK(has[v][out[i]]);
+    const ListModel * m = &model[v];
+    CHECK(snapshotListLength(s, v) == (size_t)m->len);
+    for (int k = 0; k < m->len; k++) CHECK(snapshotNth(s, v, k) == m->val[k]);
+    CHECK(snapshotNth(s, v, m->len) == NA);
+    CHECK(snapshotListToArray(s, v, out) == (size_t)m->len);
+    CHECK(!memcmp(out, m->val, m->len * sizeof(VAL_TYPE)));
+  }
+  //loaded versions are valid and can be updated again
+  CHECK(snapshotLoadTrees(s, trees) && snapshotLoadLists(s, lists));
+  for (int v = 0; v < VERSIONS; v++)
+  {
+    checkTree(trees[v], has[v], KEYS);
+    checkList(lists[v], &model[v]);
+    PRBTree * t = has[v][v] ? erase(trees[v], v) : insert(trees[v], v);
+    has[v][v] = !has[v][v];
+    checkTree(t, has[v], KEYS);
+    has[v][v] = !has[v][v];
+    releaseTree(t);
+    ListModel m = model[v];
+    if (m.len == LIST_MAX) continue;
+    m.val[m.len++] = 7;
+    checkList(inject(lists[v], 7), &m);
+  }
+  for (int v = 0; v < VERSIONS; v++) releaseTree(trees[v]);
+}
+
+/**
+ * Reads everything of a snapshot that may be damaged, the reading functions may fail
+ * but they may not read or write outside the file and the arrays. Returns
+ * the number of failures.
+ */
+static int readDamaged (PSnapshot * s, unsigned int * seed)
+{
+  PRBTree * trees [VERSIONS];
+  PCList * lists [VERSIONS];
+  int ret = 0;
+  if (snapshotTrees(s) != VERSIONS || snapshotLists(s) != VERSIONS) return 1;
+  for (int v = 0; v < VERSIONS; v++)
+  {
+    for (int q = 0; q < 50; q++)
+    {
+      int found = snapshotFind(s, v, nextRand(seed) % KEYS);
+      CHECK(found >= -1 && found <= 1);
+      ret += found < 0;
+      size_t len = snapshotListLength(s, v);
+      VAL_TYPE x = snapshotNth(s, v, len == SNAP_ERROR || !len ? 0 : nextRand(seed) % len);
+      ret += x == NA;
+    }
+    size_t n = snapshotTreeSize(s, v);
+    if (n <= LIST_MAX) ret += snapshotTreeToArray(s, v, out) == SNAP_ERROR;
+    n = snapshotListLength(s, v);
+    if (n <= LIST_MAX) ret += snapshotListToArray(s, v, out) == SNAP_ERROR;
+  }
+  if (snapshotLoadTrees(s, trees))
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      PRBTree * t = insert(trees[v], v);
+      releaseTree(trees[v]);
+      trees[v] = erase(t, KEYS / 2);
+      releaseTree(t);
+      releaseTree(trees[v]);
+    }
+  else ret++;
+  PCListArena * a = makeArena(0);
+  useArena(a);
+  if (snapshotLoadLists(s, lists))
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      VAL_TYPE x;
+      PCList * d = inject(lists[v], 7);
+      while (d) d = pop(d, &x);
+    }
+  else ret++;
+  useArena(NULL);
+  releaseArena(a);
+  return ret;
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  const char * path = argc > 3 ? argv[3] : "test/psnapshot.bin";
+  int failures = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    //versions derived from each other, so they share most of their parts
+    PRBTree * trees [VERSIONS];
+    PCList * lists [VERSIONS];
+    PRBTree * t = makeTree();
+    PCList * d = NULL;
+    PCListArena * a = makeArena(0);
+    ListModel m;
+    useArena(a);
+    char now [KEYS];
+    memset(now, 0, KEYS);
+    m.len = 0;
+    for (int v = 0; v < VERSIONS; v++)
+    {
+      for (int u = 0; u < UPDATES; u++)
+      {
+        VAL_TYPE x = nextRand(&seed) % KEYS;
+        int del = now[x] && nextRand(&seed) % 3 == 0;
+        PRBTree * tnew = del ? erase(t, x) : insert(t, x);
+        //the last version of the previous step is kept
+        if (u || !v) releaseTree(t);
+        t = tnew;
+        now[x] = !del;
+        d = updateDeque(d, &m, &seed);
+      }
+      trees[v] = t;
+      lists[v] = d;
+      memcpy(has[v], now, KEYS);
+      model[v] = m;
+    }
+    CHECK(saveSnapshot(path, trees, VERSIONS, lists, VERSIONS));
+    for (int v = 0; v < VERSIONS; v++) releaseTree(trees[v]);
+    PSnapshot * s = openSnapshot(path);
+    CHECK(s);
+    checkSnapshot(s);
+    closeSnapshot(s);
+    useArena(NULL);
+    releaseArena(a);
+    size_t size;
+    char * bytes = readFile(path, &size);
+    char * copy = (char *)malloc(size);
+    //a truncated file is not opened at all
+    for (int i = 0; i < 10; i++)
+    {
+      writeFile(path, bytes, i ? nextRand(&seed) % size : size - 8);
+      CHECK(!openSnapshot(path));
+    }
+    //damaged bytes and offsets are caught by the reading functions
+    for (int i = 0; i < DAMAGES; i++)
+    {
+      memcpy(copy, bytes, size);
+      for (int j = 1 + nextRand(&seed) % 4; j > 0; j--)
+      {
+        size_t at = sizeof(PSnapHeader) / 2 + nextRand(&seed) % (size - sizeof(PSnapHeader) / 2);
+        if (nextRand(&seed) % 2) copy[at] ^= (char)(1 << nextRand(&seed) % 8);
+        else
+        {
+          uint64_t off = nextRand(&seed) % (size / 8 + 8) * 8;
+          memcpy(copy + (at & ~(size_t)7), &off, sizeof(uint64_t));
+        }
+      }
+      writeFile(path, copy, size);
+      s = openSnapshot(path);
+      if (!s)
+      {
+        failures++;
+        continue;
+      }
+      failures += readDamaged(s, &seed);
+      closeSnapshot(s);
+    }
+    free(copy);
+    free(bytes);
+  }
+  remove(path);
+  CHECK(!rounds || failures);
+  printf("psnapshot: %d rounds ok\n", rounds);
+  return 0;
+}
@@ -0,0 +1,218 @@
+/*---------------------------------------------------------------------*
+ * pversion.c - model check of registries of versions of red-black     *
+ *              trees and deques with their retention rules            *
+ *---------------------------------------------------------------------*
+ * This file is a part of a Bachelor's thesis named Persistent         *
+ * data structures and their applications.                             *
+ *                                                                     *
+ * Author: Josef Malík                                                 *
+ *---------------------------------------------------------------------*
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "pclistarena.h"
+#include "pclistiter.h"
+#include "pversion.h"
+
+#define KEYS  256
+#define OPS   1500
+#define TAGS  6
+#define LMAX  128
+
+/* Model of all versions of one registry (indexed by version numbers) */
+typedef struct
+{
+  long long ts [OPS + 1];
+  char      kept [OPS + 1];
+  int       pins [OPS + 1];
+  long      tag [TAGS];
+  char      has [OPS + 1][KEYS];
+  VAL_TYPE  val [OPS + 1][LMAX];
+  int       len [OPS + 1];
+} RegModel;
+
+static const char * tag_names [TAGS] = {"a", "b", "c", "d", "e", "f"};
+
+/**
+ * Checks every version ever committed to a registry against the model.
+ */
+static void checkVersions (PVersionReg * r, RegModel * m, int kind)
+{
+  static VAL_TYPE out [LMAX + 1];
+  unsigned long last = latestVersion(r);
+  size_t live = 0;
+  for (unsigned long id = 0; id <= last + 1; id++)
+  {
+    void * h = NULL;
+    int kept = id >= 1 && id <= last && m->kept[id];
+    CHECK(getVersion(r, id, &h) == kept);
+    live += kept;
+    if (!kept) continue;
+    if (kind == PVERSION_TREE) checkTree((PRBTree *)h, m->has[id], KEYS);
+    else
+    {
+      CHECK(pclistToArray((PCList *)h, out, LMAX + 1) == (size_t)m->len[id]);
+      CHECK(!memcmp(out, m->val[id], m->len[id] * sizeof(VAL_TYPE)));
+    }
+  }
+  CHECK(liveVersions(r) == live);
+  for (int j = 0; j < TAGS; j++) CHECK(taggedVersion(r, tag_names[j]) == (unsigned long)m->tag[j]);
+}
+
+/**
+ * Checks versionAsOf at given time -- it is the last version committed up to then, if it is retained.
+ */
+static void checkAsOf (PVersionReg * r, RegModel * m, long long ts)
+{
+  unsigned long id = latestVersion(r);
+  while (id && m->ts[id] > ts) id--;
+  CHECK(versionAsOf(r, ts) == (id && m->kept[id] ? id : 0));
+}
+
+/**
+ * Runs random commits, tags and reclamations on a registry of given kind.
+ */
+static void runRegistry (int kind, unsigned int * seed)
+{
+  static RegModel m;
+  PVersionReg * r = kind == PVERSION_TREE ? makeTreeRegistry() : makeListRegistry(nextRand(seed) % 2 ? 0 : 512);
+  //the registry does not take over the current arena, the deques are built in its one
+  PCListArena * other = makeArena(0);
+  CHECK(useArena(other) == NULL);
+  PVersionPolicy none = {0, 0, 0}, p = none;
+  long long now = 1000;
+  unsigned long last = 0;
+  memset(m.tag, 0, sizeof(m.tag));
+  for (int i = 0; i < OPS; i++)
+  {
+    switch (nextRand(seed) % 10)
+    {
+      case 0:
+      {
+        //tag (or move a tag to) a random version, it succeeds for the retained ones only
+        int j = nextRand(seed) % TAGS;
+        unsigned long id = nextRand(seed) % (last + 2);
+        int kept = id >= 1 && id <= last && m.kept[id];
+        CHECK(tagVersion(r, tag_names[j], id) == kept);
+        if (!kept) break;
+        if (m.tag[j]) m.pins[m.tag[j]]--;
+        m.tag[j] = id;
+        m.pins[id]++;
+        break;
+      }
+      case 1:
+      {
+        int j = nextRand(seed) % TAGS;
+        CHECK(untagVersion(r, tag_names[j]) == (m.tag[j] != 0));
+        if (m.tag[j]) m.pins[m.tag[j]]--;
+        m.tag[j] = 0;
+        break;
+      }
+      case 2:
+      {
+        //new rules (none of them now and then) and a reclamation at a later time
+        if (nextRand(seed) % 4) p = none;
+        else
+        {
+          p.keep_last = nextRand(seed) % 3 ? 0 : 1 + nextRand(seed) % 20;
+          p.keep_every = nextRand(seed) % 3 ? 0 : 1 + nextRand(seed) % 10;
+          p.ttl = nextRand(seed) % 3 ? 0 : 1 + nextRand(seed) % 100;
+        }
+        setRetention(r, p);
+        now += nextRand(seed) % 20;
+        size_t removed = 0;
+        int rules = p.keep_last || p.keep_every || p.ttl;
+        for (unsigned long id = 1; id <= last; id++)
+        {
+          if (!m.kept[id]) continue;
+          int kept = !rules || m.pins[id] || id == last ||
+                     (p.keep_last && last - id < p.keep_last) ||
+                     (p.keep_every && id % p.keep_every == 0) ||
+                     (p.ttl && now - m.ts[id] < p.ttl);
+          removed += !kept;
+          m.kept[id] = kept;
+        }
+        CHECK(reclaimVersions(r, now) == removed);
+        //the current arena is still the one of the caller
+        CHECK(useArena(other) == other);
+        checkVersions(r, &m, kind);
+        break;
+      }
+      default:
+      {
+        //a new version derived from the latest one, with a timestamp which may precede the previous one
+        void * h = NULL;
+        unsigned long id = last + 1;
+        long long ts = now + (long long)(nextRand(seed) % 4) - 1;
+        VAL_TYPE x = nextRand(seed) % KEYS;
+        if (last) CHECK(getVersion(r, last, &h));
+        if (kind == PVERSION_TREE)
+        {
+          int ins = nextRand(seed) % 3;
+          if (last) memcpy(m.has[id], m.has[last], KEYS);
+          else memset(m.has[id], 0, KEYS);
+          m.has[id][x] = ins ? 1 : 0;
+          PRBTree * t = last ? (PRBTree *)h : makeTree();
+          h = ins ? insert(t, x) : erase(t, x);
+          if (!last) releaseTree(t);
+        }
+        else
+        {
+          PCList * d = (PCList *)h;
+          int n = last ? m.len[last] : 0;
+          memcpy(m.val[id], m.val[last], n * sizeof(VAL_TYPE));
+          useArena(r->arena);
+          //pushes while empty, pops while full
+          int op = n == 0 ? nextRand(seed) % 2 : n == LMAX ? 2 + nextRand(seed) % 2 : nextRand(seed) % 4;
+          switch (op)
+          {
+            case 0: d = push(d, x); memmove(m.val[id] + 1, m.val[id], n * sizeof(VAL_TYPE)); m.val[id][0] = x; n++; break;
+            case 1: d = inject(d, x); m.val[id][n++] = x; break;
+            case 2: d = pop(d, &x); CHECK(x == m.val[id][0]); memmove(m.val[id], m.val[id] + 1, --n * sizeof(VAL_TYPE)); break;
+            default: d = eject(d, &x); CHECK(x == m.val[id][--n]); break;
+          }
+          useArena(other);
+          m.len[id] = n;
+          h = d;
+        }
+        CHECK(commitVersion(r, h, ts) == id);
+        m.ts[id] = ts < (last ? m.ts[last] : 0) ? m.ts[last] : ts;
+        m.kept[id] = 1;
+        m.pins[id] = 0;
+        last = id;
+        now = m.ts[id];
+        break;
+      }
+    }
+    CHECK(latestVersion(r) == last);
+    if (i % 20 == 0) checkAsOf(r, &m, now - (long long)(nextRand(seed) % 200));
+  }
+  checkVersions(r, &m, kind);
+  for (int k = 0; k < 50; k++) checkAsOf(r, &m, now - k * 7);
+  //a registry whose arena is current leaves it current after a reclamation (the new one)
+  if (kind == PVERSION_LIST)
+  {
+    useArena(r->arena);
+    setRetention(r, (PVersionPolicy){1, 0, 0});
+    reclaimVersions(r, now);
+    CHECK(useArena(NULL) == r->arena);
+  }
+  releaseRegistry(r);
+  useArena(NULL);
+  releaseArena(other);
+}
+
+int main (int argc, char ** argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+  for (int r = 0; r < rounds; r++)
+  {
+    runRegistry(PVERSION_TREE, &seed);
+    runRegistry(PVERSION_LIST, &seed);
+  }
+  printf("pversion: %d rounds ok\n", rounds);
+  return 0;
+}